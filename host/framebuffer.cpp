@@ -0,0 +1,209 @@
+#include "framebuffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Classic 5x7 GLCD font (the TFT_eSPI / Adafruit GFX default), printable
+// ASCII only. One byte per column, LSB at the top.
+static const uint8_t FONT_5X7[95][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, // ' ' ! "
+    {0x14,0x7F,0x14,0x7F,0x14}, {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, // # $ %
+    {0x36,0x49,0x56,0x20,0x50}, {0x00,0x08,0x07,0x03,0x00}, {0x00,0x1C,0x22,0x41,0x00}, // & ' (
+    {0x00,0x41,0x22,0x1C,0x00}, {0x2A,0x1C,0x7F,0x1C,0x2A}, {0x08,0x08,0x3E,0x08,0x08}, // ) * +
+    {0x00,0x80,0x70,0x30,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x00,0x60,0x60,0x00}, // , - .
+    {0x20,0x10,0x08,0x04,0x02}, {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, // / 0 1
+    {0x72,0x49,0x49,0x49,0x46}, {0x21,0x41,0x49,0x4D,0x33}, {0x18,0x14,0x12,0x7F,0x10}, // 2 3 4
+    {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x31}, {0x41,0x21,0x11,0x09,0x07}, // 5 6 7
+    {0x36,0x49,0x49,0x49,0x36}, {0x46,0x49,0x49,0x29,0x1E}, {0x00,0x00,0x14,0x00,0x00}, // 8 9 :
+    {0x00,0x40,0x34,0x00,0x00}, {0x00,0x08,0x14,0x22,0x41}, {0x14,0x14,0x14,0x14,0x14}, // ; < =
+    {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x59,0x09,0x06}, {0x3E,0x41,0x5D,0x59,0x4E}, // > ? @
+    {0x7C,0x12,0x11,0x12,0x7C}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22}, // A B C
+    {0x7F,0x41,0x41,0x41,0x3E}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, // D E F
+    {0x3E,0x41,0x41,0x51,0x73}, {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, // G H I
+    {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41}, {0x7F,0x40,0x40,0x40,0x40}, // J K L
+    {0x7F,0x02,0x1C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E}, // M N O
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, // P Q R
+    {0x26,0x49,0x49,0x49,0x32}, {0x03,0x01,0x7F,0x01,0x03}, {0x3F,0x40,0x40,0x40,0x3F}, // S T U
+    {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F}, {0x63,0x14,0x08,0x14,0x63}, // V W X
+    {0x03,0x04,0x78,0x04,0x03}, {0x61,0x59,0x49,0x4D,0x43}, {0x00,0x7F,0x41,0x41,0x41}, // Y Z [
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x41,0x7F}, {0x04,0x02,0x01,0x02,0x04}, // \ ] ^
+    {0x40,0x40,0x40,0x40,0x40}, {0x00,0x03,0x07,0x08,0x00}, {0x20,0x54,0x54,0x78,0x40}, // _ ` a
+    {0x7F,0x28,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x28}, {0x38,0x44,0x44,0x28,0x7F}, // b c d
+    {0x38,0x54,0x54,0x54,0x18}, {0x00,0x08,0x7E,0x09,0x02}, {0x18,0xA4,0xA4,0x9C,0x78}, // e f g
+    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x40,0x3D,0x00}, // h i j
+    {0x7F,0x10,0x28,0x44,0x00}, {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x78,0x04,0x78}, // k l m
+    {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38}, {0xFC,0x18,0x24,0x24,0x18}, // n o p
+    {0x18,0x24,0x24,0x18,0xFC}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x24}, // q r s
+    {0x04,0x04,0x3F,0x44,0x24}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, // t u v
+    {0x3C,0x40,0x30,0x40,0x3C}, {0x44,0x28,0x10,0x28,0x44}, {0x4C,0x90,0x90,0x90,0x7C}, // w x y
+    {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00}, {0x00,0x00,0x77,0x00,0x00}, // z { |
+    {0x00,0x41,0x36,0x08,0x00}, {0x02,0x01,0x02,0x04,0x02},                             // } ~
+};
+
+FrameBuffer::FrameBuffer(int width, int height)
+    : _w(width), _h(height), _px((size_t)width * height, 0)
+{
+}
+
+uint64_t FrameBuffer::takePixelsWritten()
+{
+    uint64_t n = _written;
+    _written = 0;
+    return n;
+}
+
+void FrameBuffer::fillRect(int x, int y, int w, int h, uint16_t color)
+{
+    for (int yy = y; yy < y + h; ++yy) {
+        for (int xx = x; xx < x + w; ++xx) setPixel(xx, yy, color);
+    }
+}
+
+void FrameBuffer::drawRect(int x, int y, int w, int h, uint16_t color)
+{
+    if (w <= 0 || h <= 0) return;
+    drawLine(x, y, x + w - 1, y, color);
+    drawLine(x, y + h - 1, x + w - 1, y + h - 1, color);
+    drawLine(x, y, x, y + h - 1, color);
+    drawLine(x + w - 1, y, x + w - 1, y + h - 1, color);
+}
+
+void FrameBuffer::drawLine(int x0, int y0, int x1, int y1, uint16_t color)
+{
+    // Bresenham, all octants
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        setPixel(x0, y0, color);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+void FrameBuffer::pushImage(int x, int y, int w, int h, const uint16_t *pixels)
+{
+    for (int yy = 0; yy < h; ++yy) {
+        for (int xx = 0; xx < w; ++xx) setPixel(x + xx, y + yy, pixels[yy * w + xx]);
+    }
+}
+
+void FrameBuffer::drawText(const char *text, int x, int y, int size,
+                           uint16_t fg, uint16_t bg)
+{
+    for (; *text; ++text, x += 6 * size) {
+        unsigned char c = (unsigned char)*text;
+        const uint8_t *glyph = (c >= 0x20 && c < 0x7F) ? FONT_5X7[c - 0x20] : FONT_5X7[0];
+
+        // 6x8 cell: five glyph columns plus one column of spacing
+        for (int col = 0; col < 6; ++col) {
+            uint8_t bits = col < 5 ? glyph[col] : 0;
+            for (int row = 0; row < 8; ++row) {
+                uint16_t color = (bits >> row) & 1 ? fg : bg;
+                fillRect(x + col * size, y + row * size, size, size, color);
+            }
+        }
+    }
+}
+
+int FrameBuffer::textWidth(const char *text, int size)
+{
+    return 6 * size * (int)strlen(text);
+}
+
+// ==== PNG ====
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t *p, size_t len)
+{
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    }
+    crc = ~crc;
+    while (len--) crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void putBE32(std::vector<uint8_t> &out, uint32_t v)
+{
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+static void writeChunk(FILE *f, const char *type, const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> buf;
+    putBE32(buf, (uint32_t)data.size());
+    buf.insert(buf.end(), type, type + 4);
+    buf.insert(buf.end(), data.begin(), data.end());
+    putBE32(buf, crc32Update(0, buf.data() + 4, buf.size() - 4));
+    fwrite(buf.data(), 1, buf.size(), f);
+}
+
+bool FrameBuffer::writePng(const char *path) const
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+
+    static const uint8_t SIG[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(SIG, 1, sizeof(SIG), f);
+
+    std::vector<uint8_t> ihdr;
+    putBE32(ihdr, _w);
+    putBE32(ihdr, _h);
+    ihdr.push_back(8);   // bit depth
+    ihdr.push_back(2);   // colour type: RGB
+    ihdr.push_back(0);   // deflate
+    ihdr.push_back(0);   // adaptive filtering
+    ihdr.push_back(0);   // no interlace
+    writeChunk(f, "IHDR", ihdr);
+
+    // Raw scanlines: filter byte 0, then RGB888 expanded from RGB565
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)_h * (1 + 3 * _w));
+    for (int y = 0; y < _h; ++y) {
+        raw.push_back(0);
+        for (int x = 0; x < _w; ++x) {
+            uint16_t c = pixel(x, y);
+            uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            raw.push_back((r << 3) | (r >> 2));
+            raw.push_back((g << 2) | (g >> 4));
+            raw.push_back((b << 3) | (b >> 2));
+        }
+    }
+
+    // zlib stream of stored (uncompressed) deflate blocks
+    std::vector<uint8_t> z = { 0x78, 0x01 };
+    for (size_t pos = 0; pos < raw.size() || pos == 0; ) {
+        size_t n = raw.size() - pos;
+        if (n > 65535) n = 65535;
+        bool last = pos + n == raw.size();
+        z.push_back(last ? 1 : 0);
+        z.push_back(n & 0xFF);
+        z.push_back(n >> 8);
+        z.push_back(~n & 0xFF);
+        z.push_back((~n >> 8) & 0xFF);
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+        pos += n;
+        if (last) break;
+    }
+    uint32_t a = 1, b = 0;
+    for (uint8_t v : raw) {
+        a = (a + v) % 65521;
+        b = (b + a) % 65521;
+    }
+    putBE32(z, (b << 16) | a);
+    writeChunk(f, "IDAT", z);
+
+    writeChunk(f, "IEND", std::vector<uint8_t>());
+    return fclose(f) == 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "platform.h"
+
+// In-memory RGB565 panel for the host build. Same coordinate system and
+// text metrics as the device (6x8 GLCD cells), so layout and damage
+// behaviour match; dumpable to PNG for inspection and regression diffs.
+class FrameBuffer : public Display {
+public:
+    FrameBuffer(int width, int height);
+
+    int width() const  { return _w; }
+    int height() const { return _h; }
+    const uint16_t *pixels() const { return _px.data(); }
+    uint16_t pixel(int x, int y) const { return _px[(size_t)y * _w + x]; }
+
+    // Pixels written since the last call (fills, lines, glyphs, images);
+    // a stand-in for SPI traffic when comparing render paths.
+    uint64_t takePixelsWritten();
+
+    void fillRect(int x, int y, int w, int h, uint16_t color) override;
+    void drawRect(int x, int y, int w, int h, uint16_t color) override;
+    void drawLine(int x0, int y0, int x1, int y1, uint16_t color) override;
+    void pushImage(int x, int y, int w, int h, const uint16_t *pixels) override;
+    void drawText(const char *text, int x, int y, int size,
+                  uint16_t fg, uint16_t bg) override;
+    int  textWidth(const char *text, int size) override;
+
+    // 8-bit RGB PNG (stored deflate, no zlib needed). False on I/O error.
+    bool writePng(const char *path) const;
+
+private:
+    void setPixel(int x, int y, uint16_t color)
+    {
+        if (x < 0 || y < 0 || x >= _w || y >= _h) return;
+        _px[(size_t)y * _w + x] = color;
+        _written++;
+    }
+
+    int                   _w, _h;
+    std::vector<uint16_t> _px;
+    uint64_t              _written = 0;
+};
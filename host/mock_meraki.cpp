@@ -0,0 +1,267 @@
+#include "mock_meraki.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+
+// Repeats the items of a top-level JSON array `times` times. Items are
+// split on commas at nesting depth 1 (fixtures contain no commas inside
+// strings at that depth).
+static std::string repeatArrayItems(const std::string &json, int times)
+{
+    size_t open  = json.find('[');
+    size_t close = json.rfind(']');
+    if (times <= 1 || open == std::string::npos || close == std::string::npos) {
+        return json;
+    }
+
+    std::string items = json.substr(open + 1, close - open - 1);
+    std::string out = json.substr(0, open + 1);
+    for (int i = 0; i < times; ++i) {
+        if (i > 0) out += ',';
+        out += items;
+    }
+    out += json.substr(close);
+    return out;
+}
+
+const char MOCK_OPTIONS_USAGE[] =
+    "  --fixtures DIR   fixture directory (default host/fixtures)\n"
+    "  --latency-ms N   delay every response by N ms\n"
+    "  --p429 P         answer a fraction P of requests with 429\n"
+    "  --truncate P     cut a fraction P of bodies off half way\n"
+    "  --oversize N     repeat fixture array items N times\n"
+    "  --chunked        chunked transfer encoding\n"
+    "  --seed N         fault injection seed\n";
+
+bool parseMockOption(MockOptions &opts, int argc, char **argv, int &i)
+{
+    const char *a = argv[i];
+    if (strcmp(a, "--chunked") == 0) {
+        opts.chunked = true;
+        return true;
+    }
+    if (i + 1 >= argc) return false;
+    if      (strcmp(a, "--fixtures") == 0)   opts.fixtureDir = argv[++i];
+    else if (strcmp(a, "--latency-ms") == 0) opts.latencyMs  = atoi(argv[++i]);
+    else if (strcmp(a, "--p429") == 0)       opts.p429       = atof(argv[++i]);
+    else if (strcmp(a, "--truncate") == 0)   opts.pTruncate  = atof(argv[++i]);
+    else if (strcmp(a, "--oversize") == 0)   opts.oversize   = atoi(argv[++i]);
+    else if (strcmp(a, "--seed") == 0)       opts.seed       = (unsigned)atoi(argv[++i]);
+    else return false;
+    return true;
+}
+
+MockMerakiServer::MockMerakiServer(const MockOptions &opts)
+    : _opts(opts), _rng(opts.seed)
+{
+}
+
+MockMerakiServer::~MockMerakiServer()
+{
+    stop();
+    if (_listenFd >= 0) close(_listenFd);
+}
+
+bool MockMerakiServer::loadFixture(const char *name, std::string &out, bool required)
+{
+    std::string path = _opts.fixtureDir + "/" + name;
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) {
+        if (required) fprintf(stderr, "[mock] missing fixture %s\n", path.c_str());
+        return false;
+    }
+    out.clear();
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    fclose(f);
+    out = repeatArrayItems(out, _opts.oversize);
+    return true;
+}
+
+bool MockMerakiServer::listen(uint16_t port)
+{
+    if (!loadFixture("latest.json", _latest, true) ||
+        !loadFixture("history_30d.json", _history30d, true)) {
+        return false;
+    }
+    loadFixture("history_2d.json", _history2d, false);
+
+    _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_listenFd < 0) return false;
+
+    int one = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(port);
+    if (bind(_listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        ::listen(_listenFd, 4) != 0) {
+        perror("[mock] bind/listen");
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(_listenFd, (struct sockaddr *)&addr, &len);
+    _port = ntohs(addr.sin_port);
+    return true;
+}
+
+void MockMerakiServer::start()
+{
+    _thread = std::thread([this] { serve(); });
+}
+
+void MockMerakiServer::stop()
+{
+    _stop = true;
+    if (_thread.joinable()) _thread.join();
+}
+
+void MockMerakiServer::serve()
+{
+    while (!_stop) {
+        struct pollfd p = { _listenFd, POLLIN, 0 };
+        if (poll(&p, 1, 100) <= 0) continue;
+
+        int fd = accept(_listenFd, NULL, NULL);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        _stats.connections++;
+        handleConnection(fd);
+        close(fd);
+    }
+}
+
+bool MockMerakiServer::chance(double p)
+{
+    if (p <= 0) return false;
+    return std::uniform_real_distribution<double>(0, 1)(_rng) < p;
+}
+
+bool MockMerakiServer::sendAll(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        _stats.bytesSent += (uint64_t)n;
+        data += n;
+        len  -= (size_t)n;
+    }
+    return true;
+}
+
+// Serves requests on one connection until the client closes it, asks for
+// Connection: close, or a fault closes it on purpose.
+void MockMerakiServer::handleConnection(int fd)
+{
+    std::string buf;
+    while (!_stop) {
+        size_t end;
+        while ((end = buf.find("\r\n\r\n")) == std::string::npos) {
+            struct pollfd p = { fd, POLLIN, 0 };
+            int r = poll(&p, 1, 100);
+            if (_stop) return;
+            if (r <= 0) continue;
+
+            char tmp[1024];
+            ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+            if (n <= 0) return;
+            buf.append(tmp, n);
+        }
+
+        std::string head = buf.substr(0, end);
+        buf.erase(0, end + 4);
+
+        // "GET <target> HTTP/1.1"
+        size_t sp1 = head.find(' ');
+        size_t sp2 = head.find(' ', sp1 + 1);
+        if (sp1 == std::string::npos || sp2 == std::string::npos) return;
+        std::string target = head.substr(sp1 + 1, sp2 - sp1 - 1);
+        bool keepAlive = strcasestr(head.c_str(), "Connection: close") == NULL;
+
+        if (!handleRequest(fd, target, keepAlive) || !keepAlive) return;
+    }
+}
+
+bool MockMerakiServer::handleRequest(int fd, const std::string &target, bool keepAlive)
+{
+    _stats.requests++;
+    if (_opts.latencyMs > 0) usleep(_opts.latencyMs * 1000);
+
+    const std::string *body = NULL;
+    if (target.find("/sensor/readings/latest") != std::string::npos) {
+        body = &_latest;
+    } else if (target.find("/sensor/readings/history/byInterval") != std::string::npos) {
+        size_t t = target.find("timespan=");
+        long span = t == std::string::npos ? 0 : atol(target.c_str() + t + 9);
+        body = span > 0 && span <= 2 * 86400 && !_history2d.empty() ? &_history2d
+                                                                    : &_history30d;
+    }
+
+    char head[256];
+    if (!body) {
+        static const char NOT_FOUND[] = "{\"errors\":[\"Not found\"]}";
+        snprintf(head, sizeof(head),
+                 "HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\n"
+                 "Content-Length: %zu\r\n\r\n", sizeof(NOT_FOUND) - 1);
+        return sendAll(fd, head, strlen(head)) &&
+               sendAll(fd, NOT_FOUND, sizeof(NOT_FOUND) - 1);
+    }
+
+    if (chance(_opts.p429)) {
+        static const char LIMITED[] = "{\"errors\":[\"Too many requests\"]}";
+        _stats.rateLimited++;
+        snprintf(head, sizeof(head),
+                 "HTTP/1.1 429 Too Many Requests\r\nContent-Type: application/json\r\n"
+                 "Retry-After: 1\r\nContent-Length: %zu\r\n\r\n", sizeof(LIMITED) - 1);
+        return sendAll(fd, head, strlen(head)) &&
+               sendAll(fd, LIMITED, sizeof(LIMITED) - 1);
+    }
+
+    bool   truncate = chance(_opts.pTruncate);
+    size_t sendLen  = truncate ? body->size() / 2 : body->size();
+    if (truncate) _stats.truncated++;
+
+    const char *conn = keepAlive ? "keep-alive" : "close";
+    if (_opts.chunked) {
+        snprintf(head, sizeof(head),
+                 "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                 "Transfer-Encoding: chunked\r\nConnection: %s\r\n\r\n", conn);
+        if (!sendAll(fd, head, strlen(head))) return false;
+
+        // Odd-sized chunks so chunk boundaries land mid-token
+        const size_t CHUNK = 1021;
+        for (size_t pos = 0; pos < sendLen; pos += CHUNK) {
+            size_t n = std::min(CHUNK, sendLen - pos);
+            char size[16];
+            snprintf(size, sizeof(size), "%zx\r\n", n);
+            if (!sendAll(fd, size, strlen(size)) ||
+                !sendAll(fd, body->data() + pos, n) ||
+                !sendAll(fd, "\r\n", 2)) {
+                return false;
+            }
+        }
+        if (truncate) return false;
+        return sendAll(fd, "0\r\n\r\n", 5);
+    }
+
+    snprintf(head, sizeof(head),
+             "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+             "Content-Length: %zu\r\nConnection: %s\r\n\r\n", body->size(), conn);
+    if (!sendAll(fd, head, strlen(head)) || !sendAll(fd, body->data(), sendLen)) {
+        return false;
+    }
+    return !truncate;   // a cut-off body is followed by a close
+}
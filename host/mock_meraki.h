@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+
+// Local stand-in for the Meraki endpoints the firmware calls, replaying
+// recorded responses from a fixture directory:
+//
+//   .../sensor/readings/latest               -> latest.json
+//   .../sensor/readings/history/byInterval   -> history_2d.json when
+//                                               timespan <= 2 days (and the
+//                                               file exists), else
+//                                               history_30d.json
+//
+// Speaks keep-alive HTTP/1.1, one connection at a time (like the device),
+// and can inject the failures the fetch path has to survive.
+struct MockOptions {
+    std::string fixtureDir = "host/fixtures";
+    int      latencyMs = 0;       // delay before every response
+    double   p429      = 0;       // fraction of requests answered 429
+    double   pTruncate = 0;       // fraction of bodies cut off half way (then close)
+    int      oversize  = 1;       // repeat each fixture array's items N times
+    bool     chunked   = false;   // chunked transfer encoding instead of Content-Length
+    unsigned seed      = 1;       // fault injection is reproducible per seed
+};
+
+// Consumes the fault-injection option at argv[i] (advancing i past its
+// value). Returns false if argv[i] isn't one. Shared by mock_meraki and
+// mt15_bench so both take the same flags.
+bool parseMockOption(MockOptions &opts, int argc, char **argv, int &i);
+
+extern const char MOCK_OPTIONS_USAGE[];
+
+struct MockStats {
+    std::atomic<uint32_t> connections{0};
+    std::atomic<uint32_t> requests{0};
+    std::atomic<uint32_t> rateLimited{0};
+    std::atomic<uint32_t> truncated{0};
+    std::atomic<uint64_t> bytesSent{0};
+};
+
+class MockMerakiServer {
+public:
+    explicit MockMerakiServer(const MockOptions &opts);
+    ~MockMerakiServer();
+
+    // Loads fixtures and binds 127.0.0.1:port (0 picks a free port).
+    bool listen(uint16_t port);
+    uint16_t port() const { return _port; }
+
+    void serve();   // blocks until stop()
+    void start();   // serve() on a background thread
+    void stop();
+
+    const MockStats &stats() const { return _stats; }
+
+private:
+    bool loadFixture(const char *name, std::string &out, bool required);
+    void handleConnection(int fd);
+    bool handleRequest(int fd, const std::string &target, bool keepAlive);
+    bool sendAll(int fd, const char *data, size_t len);
+    bool chance(double p);
+
+    MockOptions       _opts;
+    MockStats         _stats;
+    std::string       _latest, _history30d, _history2d;
+    std::mt19937      _rng;
+    int               _listenFd = -1;
+    uint16_t          _port = 0;
+    std::atomic<bool> _stop{false};
+    std::thread       _thread;
+};
@@ -0,0 +1,55 @@
+// Standalone mock Meraki API for pointing mt15_render (or anything else
+// speaking plain HTTP) at recorded fixtures.
+//
+//   mock_meraki --port 8080 --latency-ms 150 --p429 0.1
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mock_meraki.h"
+
+static MockMerakiServer *g_server = NULL;
+
+static void onSignal(int)
+{
+    if (g_server) g_server->stop();
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: mock_meraki [--port N] [options]\n%s", MOCK_OPTIONS_USAGE);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    MockOptions opts;
+    int port = 8080;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (!parseMockOption(opts, argc, argv, i)) {
+            usage();
+        }
+    }
+
+    MockMerakiServer server(opts);
+    if (!server.listen((uint16_t)port)) return 1;
+
+    g_server = &server;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    fprintf(stderr, "[mock] serving %s on 127.0.0.1:%u\n",
+            opts.fixtureDir.c_str(), (unsigned)server.port());
+    server.serve();
+
+    const MockStats &s = server.stats();
+    fprintf(stderr, "[mock] %u connections, %u requests, %u 429s, %u truncated\n",
+            (unsigned)s.connections, (unsigned)s.requests,
+            (unsigned)s.rateLimited, (unsigned)s.truncated);
+    return 0;
+}
@@ -0,0 +1,255 @@
+// Check and benchmark of the on-device analytics (analytics.h): feeds a
+// synthetic sensor's irregular samples, with gaps and missing readings, and
+// after every one compares each metric's windowed min / max / mean / rate
+// and the alert mask against a brute-force recompute over the raw samples.
+// Then walks the CO2 rule through its trip, hold, clear and restart cases.
+// Exits non-zero on any mismatch.
+//
+//   mt15_analytics_bench --samples 20000
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "analytics.h"
+#include "platform_host.h"
+
+// ==== SYNTHETIC SENSOR ====
+
+// Readings that wander across the alert levels, so rules trip, hold and
+// clear many times over the run. Spacing is irregular (latest polls, MQTT
+// bursts), with the odd outage longer than every hold time.
+struct Sample {
+    uint32_t ts;
+    double   raw[METRIC_COUNT];     // as fed; NAN = no reading
+    int16_t  value[METRIC_COUNT];   // as stored; READING_NONE = no reading
+};
+
+static uint32_t g_rng = 0x9E3779B9;
+
+static double uniform()
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng / 4294967296.0;
+}
+
+static double gauss(double sd)
+{
+    return (uniform() + uniform() + uniform() + uniform() - 2.0) * sd * 1.73;
+}
+
+static std::vector<Sample> synthesize(int count)
+{
+    // Centre and step of each walk, indexed by metric
+    static const double CENTRE[METRIC_COUNT] = { 27.5, 29, 1000, 40, 30, 450, 80 };
+    static const double STEP[METRIC_COUNT]   = { 0.08, 0.4, 15, 1, 1.5, 8, 1 };
+
+    std::vector<Sample> out;
+    double   walk[METRIC_COUNT];
+    uint32_t ts = 1700006400;
+    for (int m = 0; m < METRIC_COUNT; ++m) walk[m] = CENTRE[m];
+
+    for (int i = 0; i < count; ++i) {
+        ts += uniform() < 0.01 ? 600 + (uint32_t)(uniform() * 3 * 3600)   // outage
+                               : 20 + (uint32_t)(uniform() * 70);
+        Sample s;
+        s.ts = ts;
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            walk[m] += (CENTRE[m] - walk[m]) * 0.01 + gauss(STEP[m]);
+            s.raw[m]   = uniform() < 0.02 ? NAN : walk[m];
+            s.value[m] = encodeReading(m, s.raw[m]);
+        }
+        out.push_back(s);
+    }
+    return out;
+}
+
+// ==== BRUTE FORCE ====
+
+static bool same(float got, float want)
+{
+    if (isnan(want)) return isnan(got);
+    return fabsf(got - want) <= 1e-4f * fmaxf(1.0f, fabsf(want));
+}
+
+// Window stats from scratch over samples[lo..hi], as summarize() defines them
+static MetricStats windowStats(const std::vector<Sample> &s, size_t lo, size_t hi, int m)
+{
+    MetricStats r = {};
+    r.min = r.max = r.mean = r.ratePerHour = NAN;
+    float   scale = METRICS[m].scale;
+    int32_t sum   = 0;
+    int     first = -1, last = -1;
+    int16_t lowest = 0, highest = 0;
+    for (size_t i = lo; i <= hi; ++i) {
+        int16_t v = s[i].value[m];
+        if (v == READING_NONE) continue;
+        if (first < 0 || v < lowest) lowest = v;
+        if (first < 0 || v > highest) highest = v;
+        if (first < 0) first = (int)i;
+        last = (int)i;
+        sum += v;
+        r.samples++;
+    }
+    if (!r.samples) return r;
+    r.min  = lowest / scale;
+    r.max  = highest / scale;
+    r.mean = (float)sum / r.samples / scale;
+    if (s[last].ts > s[first].ts) {
+        r.ratePerHour = (s[last].value[m] - s[first].value[m]) / scale * 3600.0f /
+                        (s[last].ts - s[first].ts);
+    }
+    return r;
+}
+
+static bool beyondAt(const Sample &s, const AlertRule &rule)
+{
+    double v = s.raw[rule.metric];
+    return !isnan(v) && (rule.above ? v > rule.on : v < rule.on);
+}
+
+// Rule `r`'s alert after sample k, given its state after k - 1: a raised
+// alert holds until a reading past `off`; otherwise it trips once the run
+// of consecutive samples beyond `on` ending at k (no missing reading, no
+// gap longer than the hold) spans the hold time.
+static bool alertAfter(const std::vector<Sample> &s, size_t k, int r, bool raised)
+{
+    const AlertRule &rule = ALERT_RULES[r];
+    if (raised) {
+        double v = s[k].raw[rule.metric];
+        return isnan(v) || !(rule.above ? v < rule.off : v > rule.off);
+    }
+    if (!beyondAt(s[k], rule)) return false;
+
+    size_t start = k;
+    while (start > 0 && s[start].ts - s[start - 1].ts <= rule.holdS &&
+           beyondAt(s[start - 1], rule)) {
+        --start;
+    }
+    return s[k].ts - s[start].ts >= rule.holdS;
+}
+
+// ==== SCRIPTED ALERTS ====
+
+// Walks the CO2 rule through its edge cases, starting a day after the run
+// so the window and every pending hold have expired
+static int checkCo2Rule(uint32_t ts)
+{
+    const uint32_t CO2_BIT = 1u << 0;   // ALERT_RULES[0]
+    double v[METRIC_COUNT] = { 22, 45, 500, 40, 5, 150, 90 };
+    int bad = 0;
+
+    struct Step {
+        uint32_t    dt;
+        double      co2;
+        bool        raised;
+        const char *what;
+    };
+    static const Step STEPS[] = {
+        { 86400, 500,  false, "quiet start (clears whatever the run left)" },
+        { 60,    1200, false, "over 1000: hold starts" },
+        { 540,   1200, false, "9 min over" },
+        { 60,    1200, true,  "10 min over: trips" },
+        { 60,    950,  true,  "950 is above the 900 clear level: holds" },
+        { 60,    880,  false, "880: clears" },
+        { 60,    1200, false, "over again: a new hold, not raised" },
+        { 300,   NAN,  false, "missing CO2 reading" },
+        { 300,   1200, false, "back over: the missing reading restarted the hold" },
+        { 540,   1200, false, "9 min into the new hold" },
+        { 2400,  1200, false, "over after a 40 min gap: restarts, doesn't trip" },
+        { 600,   1200, true,  "10 min after the gap: trips" },
+    };
+
+    for (const Step &st : STEPS) {
+        ts += st.dt;
+        v[METRIC_CO2] = st.co2;
+        analyticsSample(ts, v);
+        bool raised = (g_analytics.alertMask & CO2_BIT) != 0;
+        printf("  %-50s %s\n", st.what, raised == st.raised ? "ok" : "WRONG");
+        if (raised != st.raised) bad++;
+    }
+    return bad;
+}
+
+// ==== BENCH ====
+
+static void usage()
+{
+    fprintf(stderr, "usage: mt15_analytics_bench [--samples N]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int count = 20000;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (i + 1 >= argc) usage();
+        if (strcmp(a, "--samples") == 0) count = atoi(argv[++i]);
+        else usage();
+    }
+    if (count <= 0) usage();
+
+    std::vector<Sample> s = synthesize(count);
+    size_t statsBad = 0, alertsBad = 0, trips = 0;
+    uint32_t expectMask = 0;
+    unsigned long us = 0;
+
+    for (size_t k = 0; k < s.size(); ++k) {
+        unsigned long t0 = platformMicros();
+        analyticsSample(s[k].ts, s[k].raw);
+        us += platformMicros() - t0;
+
+        // The window: the newest STATS_WINDOW_SAMPLES samples, minus any
+        // STATS_WINDOW_S or more older than this one
+        size_t lo = k + 1 > (size_t)STATS_WINDOW_SAMPLES ? k + 1 - STATS_WINDOW_SAMPLES : 0;
+        while (s[lo].ts + STATS_WINDOW_S <= s[k].ts) ++lo;
+
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            MetricStats want = windowStats(s, lo, k, m);
+            const MetricStats &got = g_analytics.stats[m];
+            if (got.samples != want.samples || !same(got.min, want.min) ||
+                !same(got.max, want.max) || !same(got.mean, want.mean) ||
+                !same(got.ratePerHour, want.ratePerHour)) {
+                if (statsBad++ < 5) {
+                    printf("sample %zu %s: got %u %.2f/%.2f/%.2f/%.2f, want %u %.2f/%.2f/%.2f/%.2f\n",
+                           k, METRICS[m].name, got.samples, got.min, got.max, got.mean,
+                           got.ratePerHour, want.samples, want.min, want.max, want.mean,
+                           want.ratePerHour);
+                }
+            }
+        }
+
+        for (int r = 0; r < ALERT_RULE_COUNT; ++r) {
+            uint32_t bit    = 1u << r;
+            bool     before = (expectMask & bit) != 0;
+            bool     after  = alertAfter(s, k, r, before);
+            if (after && !before) trips++;
+            expectMask = after ? expectMask | bit : expectMask & ~bit;
+        }
+        if (g_analytics.alertMask != expectMask && alertsBad++ < 5) {
+            printf("sample %zu: alert mask %lx, want %lx\n", k,
+                   (unsigned long)g_analytics.alertMask, (unsigned long)expectMask);
+        }
+    }
+
+    printf("%zu samples over %.1f days, %d metrics, %d rules\n", s.size(),
+           (s.back().ts - s.front().ts) / 86400.0, METRIC_COUNT, ALERT_RULE_COUNT);
+    printf("windowed stats: %zu mismatches; alerts: %zu trips, %zu mismatches\n",
+           statsBad, trips, alertsBad);
+    printf("cost: %.2f us per sample, all metrics and rules\n", (double)us / s.size());
+
+    printf("\nCO2 rule:\n");
+    int scriptBad = checkCo2Rule(s.back().ts);
+
+    if (statsBad || alertsBad || scriptBad) {
+        printf("\nMISMATCH\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,299 @@
+// End-to-end benchmark of the firmware's refresh cycle on the host:
+// fetch latest -> fetch history -> parse/merge -> snapshot -> render,
+// against the mock Meraki server (started in-process unless --server is
+// given). Reports per-stage latency percentiles, bytes on the wire, and
+// peak heap and stack per cycle.
+//
+//   mt15_bench --cycles 200 --latency-ms 40 --p429 0.05 --truncate 0.02
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "framebuffer.h"
+#include "meraki_fetch.h"
+#include "meraki_http.h"
+#include "mock_meraki.h"
+#include "platform_host.h"
+#include "snapshot.h"
+#include "ui.h"
+
+// ==== HEAP TRACKING ====
+
+// malloc/free are interposed so allocations made by the cycle thread are
+// counted; other threads (the mock server) are ignored.
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+extern "C" void  __libc_free(void *);
+
+static thread_local bool   t_trackHeap = false;
+static thread_local size_t t_heapNow   = 0;
+static thread_local size_t t_heapPeak  = 0;
+
+static void heapAdd(void *p)
+{
+    if (!p || !t_trackHeap) return;
+    t_heapNow += malloc_usable_size(p);
+    if (t_heapNow > t_heapPeak) t_heapPeak = t_heapNow;
+}
+
+static void heapSub(void *p)
+{
+    if (!p || !t_trackHeap) return;
+    size_t n = malloc_usable_size(p);
+    t_heapNow = t_heapNow > n ? t_heapNow - n : 0;
+}
+
+extern "C" void *malloc(size_t n)
+{
+    void *p = __libc_malloc(n);
+    heapAdd(p);
+    return p;
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+    void *p = __libc_calloc(n, size);
+    heapAdd(p);
+    return p;
+}
+
+extern "C" void *realloc(void *old, size_t n)
+{
+    heapSub(old);
+    void *p = __libc_realloc(old, n);
+    heapAdd(p ? p : old);
+    return p;
+}
+
+extern "C" void free(void *p)
+{
+    heapSub(p);
+    __libc_free(p);
+}
+
+// ==== CYCLE ====
+
+struct CycleResult {
+    unsigned long latestUs, historyUs, renderUs, totalUs;
+    bool          latestOk, historyOk;
+    uint64_t      rxBytes, txBytes;
+    size_t        heapPeak, stackPeak;
+};
+
+struct Bench {
+    PosixTransport           tcp;
+    FrameBuffer              live{SCREEN_W, SCREEN_H};
+    std::vector<FrameBuffer> history;
+    FrameBuffer              overview{SCREEN_W, SCREEN_H};
+    uint32_t                 overviewKey = 0;
+    uint32_t                 pageKey[METRIC_COUNT] = {};
+    bool                     fullHistory = false;
+    bool                     renderAll   = false;
+
+    Bench() : history(METRIC_COUNT, FrameBuffer(SCREEN_W, SCREEN_H)) {}
+};
+
+static Bench *g_bench = NULL;
+
+// One refresh as the firmware does it: both fetches, then the UI side
+// re-rendering whatever changed (the live widgets plus the overview and
+// any history page whose data moved).
+static void runCycle(CycleResult &r)
+{
+    Bench &b = *g_bench;
+    uint64_t rx0 = b.tcp.bytesRead, tx0 = b.tcp.bytesWritten;
+
+    t_heapNow = t_heapPeak = 0;
+    t_trackHeap = true;
+
+    if (b.fullHistory) g_historyNeedsFull = true;
+
+    unsigned long t0 = platformMicros();
+    r.latestOk  = fetchMT15Once();
+    unsigned long t1 = platformMicros();
+    r.historyOk = fetchMT15History();
+    unsigned long t2 = platformMicros();
+
+    publishSnapshot();
+    acquireSnapshot();
+    const SensorSnapshot &snap = uiSnapshot();
+    renderLivePage(snap);
+    uint32_t ovKey = overviewKey(snap.sensors, 0);
+    if (b.renderAll || ovKey != b.overviewKey) {
+        renderOverviewCanvas(b.overview, snap.sensors, 0);
+        b.overviewKey = ovKey;
+    }
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        uint32_t key = historyKey(m, snap.history);
+        if (!b.renderAll && key == b.pageKey[m]) continue;
+        renderHistoryCanvas(b.history[m], m, snap.history);
+        b.pageKey[m] = key;
+    }
+    unsigned long t3 = platformMicros();
+
+    t_trackHeap = false;
+
+    r.latestUs  = t1 - t0;
+    r.historyUs = t2 - t1;
+    r.renderUs  = t3 - t2;
+    r.totalUs   = t3 - t0;
+    r.rxBytes   = b.tcp.bytesRead - rx0;
+    r.txBytes   = b.tcp.bytesWritten - tx0;
+    r.heapPeak  = t_heapPeak;
+}
+
+// ==== STACK MEASUREMENT ====
+
+// Each cycle runs on a fresh thread whose stack is pre-painted; the deepest
+// overwritten byte afterwards is the cycle's stack high-water mark.
+const size_t  BENCH_STACK_SIZE = 1 << 20;
+const uint8_t STACK_PAINT      = 0xA5;
+
+static void *cycleThread(void *arg)
+{
+    if (arg) runCycle(*(CycleResult *)arg);
+    return NULL;
+}
+
+static size_t runOnPaintedStack(CycleResult *r)
+{
+    static uint8_t *stack = NULL;
+    if (!stack) stack = (uint8_t *)aligned_alloc(4096, BENCH_STACK_SIZE);
+    memset(stack, STACK_PAINT, BENCH_STACK_SIZE);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, BENCH_STACK_SIZE);
+    pthread_t th;
+    pthread_create(&th, &attr, cycleThread, r);
+    pthread_join(th, NULL);
+    pthread_attr_destroy(&attr);
+
+    size_t untouched = 0;
+    while (untouched < BENCH_STACK_SIZE && stack[untouched] == STACK_PAINT) ++untouched;
+    return BENCH_STACK_SIZE - untouched;
+}
+
+// ==== REPORT ====
+
+static unsigned long percentile(std::vector<unsigned long> v, double p)
+{
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t rank = (size_t)(p / 100.0 * v.size() + 0.5);
+    return v[std::min(rank ? rank - 1 : 0, v.size() - 1)];
+}
+
+static void printRow(const char *name, const std::vector<CycleResult> &rs,
+                     unsigned long CycleResult::*field)
+{
+    std::vector<unsigned long> v;
+    for (const CycleResult &r : rs) v.push_back(r.*field);
+    printf("%-16s %9.2f %9.2f %9.2f %9.2f\n", name,
+           percentile(v, 50) / 1000.0, percentile(v, 90) / 1000.0,
+           percentile(v, 99) / 1000.0, percentile(v, 100) / 1000.0);
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: mt15_bench [--cycles N] [--interval-ms N] [--full-history]\n"
+            "                  [--render-all] [--server HOST:PORT]\n"
+            "                  [mock options]\n%s", MOCK_OPTIONS_USAGE);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    MockOptions opts;
+    const char *server = NULL;
+    int cycles = 100, intervalMs = 0;
+    static Bench bench;
+    g_bench = &bench;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if      (strcmp(a, "--full-history") == 0) bench.fullHistory = true;
+        else if (strcmp(a, "--render-all") == 0)   bench.renderAll = true;
+        else if (strcmp(a, "--cycles") == 0 && i + 1 < argc)      cycles = atoi(argv[++i]);
+        else if (strcmp(a, "--interval-ms") == 0 && i + 1 < argc) intervalMs = atoi(argv[++i]);
+        else if (strcmp(a, "--server") == 0 && i + 1 < argc)      server = argv[++i];
+        else if (!parseMockOption(opts, argc, argv, i)) usage();
+    }
+    if (cycles <= 0) usage();
+
+    MockMerakiServer mock(opts);
+    static char host[256] = "127.0.0.1";
+    uint16_t port;
+    if (server) {
+        const char *colon = strrchr(server, ':');
+        if (!colon || colon - server >= (long)sizeof(host)) usage();
+        memcpy(host, server, colon - server);
+        host[colon - server] = '\0';
+        port = (uint16_t)atoi(colon + 1);
+    } else {
+        if (!mock.listen(0)) return 1;
+        mock.start();
+        port = mock.port();
+    }
+
+    g_merakiConfig = { host, port, "bench-key", "123456", "Q3CA-ABCD-1234", NULL };
+    g_transport = &bench.tcp;
+    g_wifiState = WIFI_OK;
+    g_canvas = &bench.live;
+    initWidgets();
+
+    size_t stackBase = runOnPaintedStack(NULL);   // thread overhead alone
+
+    std::vector<CycleResult> results(cycles);
+    for (int c = 0; c < cycles; ++c) {
+        size_t used = runOnPaintedStack(&results[c]);
+        results[c].stackPeak = used > stackBase ? used - stackBase : 0;
+        if (intervalMs > 0) usleep(intervalMs * 1000);
+    }
+
+    if (!server) mock.stop();
+
+    // ---- report ----
+
+    int latestOk = 0, historyOk = 0;
+    uint64_t rx = 0, tx = 0, rxMax = 0;
+    size_t heapMax = 0, stackMax = 0;
+    for (const CycleResult &r : results) {
+        latestOk  += r.latestOk;
+        historyOk += r.historyOk;
+        rx += r.rxBytes;
+        tx += r.txBytes;
+        rxMax    = std::max(rxMax, r.rxBytes);
+        heapMax  = std::max(heapMax, r.heapPeak);
+        stackMax = std::max(stackMax, r.stackPeak);
+    }
+
+    printf("cycles: %d  latest ok: %d  history ok: %d  connects: %lu  reused: %lu\n",
+           cycles, latestOk, historyOk,
+           (unsigned long)g_tlsHandshakes, (unsigned long)g_reusedRequests);
+    if (!server) {
+        const MockStats &s = mock.stats();
+        printf("mock: %u requests, %u 429s, %u truncated, latency %d ms, oversize x%d%s\n",
+               (unsigned)s.requests, (unsigned)s.rateLimited, (unsigned)s.truncated,
+               opts.latencyMs, opts.oversize, opts.chunked ? ", chunked" : "");
+    }
+    printf("\n%-16s %9s %9s %9s %9s\n", "stage (ms)", "p50", "p90", "p99", "max");
+    printRow("latest fetch",  results, &CycleResult::latestUs);
+    printRow("history fetch", results, &CycleResult::historyUs);
+    printRow("render",        results, &CycleResult::renderUs);
+    printRow("total",         results, &CycleResult::totalUs);
+    printf("\nbytes/cycle: rx %.0f avg / %llu max, tx %.0f avg\n",
+           (double)rx / cycles, (unsigned long long)rxMax, (double)tx / cycles);
+    printf("peak memory/cycle: heap %zu B, stack %zu B, fetch arena %zu of %zu B%s\n",
+           heapMax, stackMax, g_fetchArena.highWater(), g_fetchArena.size(),
+           g_fetchArena.failures() ? " (overflowed)" : "");
+    return 0;
+}
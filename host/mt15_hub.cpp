@@ -0,0 +1,157 @@
+// Site hub daemon: the firmware's fetch pipeline on a Linux box, multicast
+// to every display in listener mode (see lib/mt15core/src/hub.h). With
+// --listen it is a listener instead and prints what arrives.
+//
+//   mt15_hub --server 127.0.0.1:8080 --org 123 --serial Q2XX-XXXX-XXXX
+//   mt15_hub --listen
+//
+// There is no TLS on the host: against api.meraki.com, point --server at
+// a TLS-terminating proxy (stunnel, socat, nginx) in front of it.
+// --group ADDR:PORT overrides the default group; --cache DIR keeps the
+// boot cache there, as on the device. --mqtt HOST:PORT --mac MAC takes the
+// live sensor's readings from the site's broker as they are published
+// (mqtt_live.h), e.g. a local mosquitto.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hub.h"
+#include "meraki_fetch.h"
+#include "meraki_http.h"
+#include "mqtt_live.h"
+#include "perf_stats.h"
+#include "platform_host.h"
+#include "scheduler.h"
+#include "snapshot.h"
+#include "state_cache.h"
+
+// As on the device with DISPLAYS_PER_ORG 1: the hub is the org's only poller
+static const SchedulerConfig HUB_SCHEDULER = {
+    { 60000, HISTORY_REFRESH_MS },
+    MERAKI_ORG_REQUESTS_PER_S,
+    4.0f,
+    5000, 600000,
+    0
+};
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: mt15_hub --server HOST:PORT --org ID --serial SN [--key KEY]\n"
+            "                [--group ADDR:PORT] [--cache DIR] [--mqtt HOST:PORT --mac MAC]\n"
+            "       mt15_hub --listen [--group ADDR:PORT]\n");
+    exit(2);
+}
+
+// "host:port" -> host (static copy), port; exits on garbage
+static const char *splitHostPort(const char *s, uint16_t &port)
+{
+    static char host[3][256];
+    static int  which = 0;
+    const char *colon = strrchr(s, ':');
+    if (!colon || colon - s >= (long)sizeof(host[0])) usage();
+    char *h = host[which++ % 3];
+    memcpy(h, s, colon - s);
+    h[colon - s] = '\0';
+    port = (uint16_t)atoi(colon + 1);
+    return h;
+}
+
+static int runListener(const char *addr, uint16_t port)
+{
+    if (!hubListenInit()) return 1;
+    for (;;) {
+        HubReceive rx = hubReceive(60000);
+        if (rx == HUB_RX_ERROR) {
+            fprintf(stderr, "receive failed, rejoining %s:%u\n", addr, (unsigned)port);
+            platformDelay(5000);
+            g_multicast->begin(addr, port, true);
+            continue;
+        }
+        if (rx != HUB_RX_INSTALLED) continue;
+        printf("#%lu: %d sensors, %d buckets, latest",
+               (unsigned long)g_hubStats.installed, g_sensors.count, g_history.count);
+        for (int m = 0; m < METRIC_COUNT; ++m) printf(" %s=%.2f", METRICS[m].name, g_latest[m]);
+        printf("  (packets %lu, incomplete %lu, rejected %lu)\n",
+               (unsigned long)g_hubStats.packets, (unsigned long)g_hubStats.incomplete,
+               (unsigned long)g_hubStats.rejected);
+        fflush(stdout);
+    }
+}
+
+// The firmware's fetchTask(), minus WiFi, broadcasting after each refresh
+static int runHub()
+{
+    if (g_blobDir) loadStateCache();
+    schedulerInit(HUB_SCHEDULER);
+    PosixTransport mqttTcp;
+    mqttLiveInit(mqttTcp);
+
+    for (;;) {
+        schedulerSetTtl(JOB_LATEST, mqttLiveActive() ? MQTT_OVERVIEW_REFRESH_MS : HUB_SCHEDULER.ttlMs[JOB_LATEST]);
+        int job = schedulerNextJob();
+        if (job < 0) {
+            if (mqttLivePoll(schedulerIdleMs())) {
+                printf("mqtt: latest");
+                for (int m = 0; m < METRIC_COUNT; ++m) printf(" %s=%.2f", METRICS[m].name, g_latest[m]);
+                printf("  (messages %lu, ignored %lu)\n", (unsigned long)g_mqttStats.messages,
+                       (unsigned long)g_mqttStats.ignored);
+                fflush(stdout);
+                hubBroadcast();
+            }
+            continue;
+        }
+
+        bool fullHistory = false;   // set when the ring was rebuilt
+        bool ok = job == JOB_LATEST ? fetchMT15Once() : fetchMT15History(&fullHistory);
+        if (ok && job == JOB_LATEST) g_stateFromCache = false;
+        schedulerJobDone(job, ok);
+        memSample(false);
+        if (ok) hubBroadcast(fullHistory);
+        if (g_blobDir) saveStateCache();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *server = NULL;
+    const char *group  = NULL;
+    const char *mqtt   = NULL;
+    bool        listen = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (strcmp(a, "--listen") == 0) {
+            listen = true;
+            continue;
+        }
+        if (i + 1 >= argc) usage();
+        if      (strcmp(a, "--server") == 0) server = argv[++i];
+        else if (strcmp(a, "--group") == 0)  group  = argv[++i];
+        else if (strcmp(a, "--org") == 0)    g_merakiConfig.orgId  = argv[++i];
+        else if (strcmp(a, "--serial") == 0) g_merakiConfig.serial = argv[++i];
+        else if (strcmp(a, "--key") == 0)    g_merakiConfig.apiKey = argv[++i];
+        else if (strcmp(a, "--cache") == 0)  g_blobDir = argv[++i];
+        else if (strcmp(a, "--mqtt") == 0)   mqtt   = argv[++i];
+        else if (strcmp(a, "--mac") == 0)    g_mqttConfig.sensorMac = argv[++i];
+        else usage();
+    }
+    if (!listen && !server) usage();
+
+    uint16_t    port = HUB_PORT;
+    const char *addr = group ? splitHostPort(group, port) : HUB_GROUP;
+    PosixMulticast mc;
+    if (!mc.begin(addr, port, listen)) {
+        fprintf(stderr, "cannot open multicast %s:%u\n", addr, (unsigned)port);
+        return 1;
+    }
+    g_multicast = &mc;
+    if (listen) return runListener(addr, port);
+
+    PosixTransport tcp;
+    g_merakiConfig.host = splitHostPort(server, g_merakiConfig.port);
+    if (mqtt) g_mqttConfig.host = splitHostPort(mqtt, g_mqttConfig.port);
+    g_transport = &tcp;
+    return runHub();
+}
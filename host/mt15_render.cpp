@@ -0,0 +1,230 @@
+// Host renderer: runs the firmware's parse -> history merge -> draw path
+// against recorded responses (or a server) and writes every page to PNG.
+//
+//   mt15_render --latest fixtures/latest.json --history fixtures/history_30d.json
+//   mt15_render --server 127.0.0.1:8080 --org 123 --serial Q2XX-XXXX-XXXX
+//   mt15_render --cache /tmp/mt15     (pages from the boot cache alone)
+//
+// With --cache DIR the boot cache (DIR/state.bin) is loaded first, as in
+// setup(), and rewritten from whatever was parsed or fetched.
+//
+// Pages land in --out (default ".") as page0.png (live), page1.png
+// (overview), page2.png .. page8.png (history) and page9.png
+// (diagnostics: the fetch stages with --server, the renders above), the
+// local API's bodies as latest.json and history.json, and per-stage
+// timings go to stderr for quick profiling.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "framebuffer.h"
+#include "local_api.h"
+#include "meraki_fetch.h"
+#include "meraki_http.h"
+#include "perf_stats.h"
+#include "platform_host.h"
+#include "snapshot.h"
+#include "state_cache.h"
+#include "ui.h"
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: mt15_render [--latest FILE] [--history FILE]\n"
+            "                   [--server HOST:PORT --org ID --serial SN [--key KEY]]\n"
+            "                   [--cache DIR] [--out DIR]\n");
+    exit(2);
+}
+
+static bool parseLatestFile(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    FileReader in(f);
+    sensorStoreClear(g_sensors);
+    bool ok = parseLatest(in, g_sensors);
+    fclose(f);
+    if (!ok) return false;
+
+    // Live page: --serial if given, else the first sensor in the file
+    const char *serial = *g_merakiConfig.serial ? g_merakiConfig.serial
+                                                : g_sensors.serial[0];
+    if (g_sensors.count > 0 && !sensorLatest(g_sensors, serial, g_latest)) {
+        fprintf(stderr, "%s not in %s\n", serial, path);
+    }
+    return true;
+}
+
+static bool parseHistoryFile(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    FileReader in(f);
+    static HistoryWindow win;
+    bool ok = parseHistoryWindow(in, win) && mergeHistoryWindow(g_history, win, true);
+    fclose(f);
+    return ok;
+}
+
+static bool savePage(const FrameBuffer &fb, const char *dir, int page)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/page%d.png", dir, page);
+    if (!fb.writePng(path)) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+// What the firmware's local API would answer for `path`, to DIR/<name>
+static bool saveApiBody(const char *dir, const char *path, const char *name)
+{
+    char req[64];
+    snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\n\r\n", path);
+    LocalApiResponse res;
+    localApiHandle(req, res);
+
+    char file[512];
+    snprintf(file, sizeof(file), "%s/%s", dir, name);
+    FILE *f = fopen(file, "wb");
+    bool ok = f && res.status == 200 && fwrite(res.body, 1, res.len, f) == res.len;
+    if (f) fclose(f);
+    if (!ok) fprintf(stderr, "cannot write %s (status %d)\n", file, res.status);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    const char *latestPath  = NULL;
+    const char *historyPath = NULL;
+    const char *server      = NULL;
+    const char *outDir      = ".";
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (i + 1 >= argc) usage();
+        if      (strcmp(a, "--latest") == 0)  latestPath  = argv[++i];
+        else if (strcmp(a, "--history") == 0) historyPath = argv[++i];
+        else if (strcmp(a, "--server") == 0)  server      = argv[++i];
+        else if (strcmp(a, "--org") == 0)     g_merakiConfig.orgId  = argv[++i];
+        else if (strcmp(a, "--serial") == 0)  g_merakiConfig.serial = argv[++i];
+        else if (strcmp(a, "--key") == 0)     g_merakiConfig.apiKey = argv[++i];
+        else if (strcmp(a, "--out") == 0)     outDir      = argv[++i];
+        else if (strcmp(a, "--cache") == 0)   g_blobDir   = argv[++i];
+        else usage();
+    }
+    bool haveInput = server || latestPath || historyPath;
+    if (!haveInput && !g_blobDir) usage();
+
+    // ---- boot cache ----
+
+    unsigned long t0 = platformMicros();
+    if (g_blobDir && !loadStateCache() && !haveInput) {
+        fprintf(stderr, "no usable cache in %s\n", g_blobDir);
+        return 1;
+    }
+    unsigned long tCache = platformMicros() - t0;
+
+    // ---- fetch / parse ----
+
+    t0 = platformMicros();
+    PosixTransport tcp;
+    if (server) {
+        static char host[256];
+        const char *colon = strrchr(server, ':');
+        if (!colon || colon - server >= (long)sizeof(host)) usage();
+        memcpy(host, server, colon - server);
+        host[colon - server] = '\0';
+        g_merakiConfig.host = host;
+        g_merakiConfig.port = (uint16_t)atoi(colon + 1);
+        g_transport = &tcp;
+
+        if (!fetchMT15Once())    fprintf(stderr, "latest fetch failed\n");
+        if (!fetchMT15History()) fprintf(stderr, "history fetch failed\n");
+    } else {
+        if (latestPath && !parseLatestFile(latestPath))    return 1;
+        if (historyPath && !parseHistoryFile(historyPath)) return 1;
+    }
+    unsigned long tParse = platformMicros() - t0;
+
+    if (haveInput) g_stateFromCache = false;
+    if (haveInput && g_blobDir) saveStateCache();
+
+    g_wifiState = WIFI_OK;
+    memSample(true);
+    publishSnapshot();
+    acquireSnapshot();
+    const SensorSnapshot &snap = uiSnapshot();
+
+    // ---- render ----
+
+    FrameBuffer fb(SCREEN_W, SCREEN_H);
+    g_canvas = &fb;
+    initWidgets();
+
+    t0 = platformMicros();
+    g_currentPage = PAGE_LIVE;
+    renderPageDirect(snap);
+    unsigned long tLive = platformMicros() - t0;
+    perfRecord(PERF_RENDER, tLive);
+    if (!savePage(fb, outDir, PAGE_LIVE)) return 1;
+
+    // Most refreshes move one reading by its last digit
+    static SensorSnapshot next;
+    next = snap;
+    next.latest[METRIC_TEMP] += 0.01;
+    fb.takePixelsWritten();
+    t0 = platformMicros();
+    renderPageDirect(next);
+    unsigned long tUpdate  = platformMicros() - t0;
+    uint64_t      updatePx = fb.takePixelsWritten();
+
+    t0 = platformMicros();
+    renderOverviewCanvas(fb, snap.sensors, 0);
+    unsigned long tOverview = platformMicros() - t0;
+    perfRecord(PERF_RENDER, tOverview);
+    if (!savePage(fb, outDir, PAGE_OVERVIEW)) return 1;
+
+    // Each chart twice: the first render builds its geometry, the second
+    // only rasterises the cached one
+    unsigned long tHist = 0, tHistCached = 0;
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        t0 = platformMicros();
+        renderHistoryCanvas(fb, m, snap.history);
+        unsigned long us = platformMicros() - t0;
+        tHist += us;
+        perfRecord(PERF_RENDER, us);
+
+        t0 = platformMicros();
+        renderHistoryCanvas(fb, m, snap.history);
+        tHistCached += platformMicros() - t0;
+        if (!savePage(fb, outDir, PAGE_HISTORY_FIRST + m)) return 1;
+    }
+
+    renderDiagCanvas(fb, snap);
+    if (!savePage(fb, outDir, PAGE_DIAG)) return 1;
+
+    // ---- local API ----
+
+    if (!localApiInit()) return 1;
+    localApiPublish();
+    if (!saveApiBody(outDir, "/latest", "latest.json"))   return 1;
+    if (!saveApiBody(outDir, "/history", "history.json")) return 1;
+
+    fprintf(stderr,
+            "cache load: %lu us, %s: %lu us, live page: %lu us, overview: %lu us (%d sensors)\n"
+            "live update, one digit: %lu us, %llu px\n"
+            "history: %lu us/page, %lu us/page with cached geometry (%d buckets)\n",
+            tCache, server ? "fetch+parse" : "parse", tParse, tLive,
+            tOverview, snap.sensors.count, tUpdate, (unsigned long long)updatePx,
+            tHist / METRIC_COUNT, tHistCached / METRIC_COUNT, snap.history.count);
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Benchmark of the compressed time-series store (series_store.h): appends
+// a synthetic sensor's buckets for every metric, then decodes each metric
+// front to back as a history page would, checking every value. Reports
+// the pool bytes against the history ring's 18 bytes a bucket, bits per
+// entry of each stream, and encode / decode throughput.
+//
+//   mt15_series_bench --days 90 --interval 300 --reps 5
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "platform_host.h"
+#include "series_store.h"
+
+// ==== SYNTHETIC SENSOR ====
+
+// What a 5-minute average from an MT in an office looks like: daily
+// cycles, occupancy on weekdays, sensor noise at the stored resolution,
+// and the odd missing bucket or metric
+struct Point {
+    uint32_t ts;
+    int16_t  values[METRIC_COUNT];
+};
+
+static uint32_t g_rng = 0x9E3779B9;
+
+static double uniform()
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng / 4294967296.0;
+}
+
+static double gauss(double sd)
+{
+    return (uniform() + uniform() + uniform() + uniform() - 2.0) * sd * 1.73;
+}
+
+static std::vector<Point> synthesize(int days, uint32_t interval)
+{
+    const uint32_t START = 1700006400;   // a Wednesday, 00:00 UTC
+    std::vector<Point> pts;
+    double co2 = 420, pm = 3, tvoc = 120;
+
+    for (uint32_t t = START; t < START + days * 86400u; t += interval) {
+        if (uniform() < 0.002) continue;   // bucket the API never filled
+
+        double hour     = (t % 86400) / 3600.0;
+        int    weekday  = (int)((t / 86400 + 3) % 7);   // 0 = Sunday
+        bool   occupied = weekday >= 1 && weekday <= 5 && hour >= 8 && hour < 18;
+        double day      = sin((hour - 9) / 24.0 * 2 * M_PI);
+
+        co2  += ((occupied ? 750 : 430) - co2) * 0.08 + gauss(4);
+        pm   += (3 - pm) * 0.05 + gauss(0.15) + (uniform() < 0.003 ? 20 : 0);
+        tvoc += ((occupied ? 260 : 110) - tvoc) * 0.05 + gauss(3);
+
+        double v[METRIC_COUNT];
+        v[METRIC_TEMP]  = 21.5 + 1.2 * day + (occupied ? 0.6 : 0) + gauss(0.04);
+        v[METRIC_HUM]   = 42 - 4 * day + gauss(0.2);
+        v[METRIC_CO2]   = floor(co2);
+        v[METRIC_NOISE] = floor(occupied ? 48 + gauss(2) : 33 + gauss(0.5));
+        v[METRIC_PM25]  = pm < 0 ? 0 : pm;
+        v[METRIC_TVOC]  = floor(tvoc);
+        v[METRIC_IAQ]   = floor(100 - (co2 - 400) / 20 - pm / 2);
+
+        Point p;
+        p.ts = t;
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            p.values[m] = uniform() < 0.001 ? READING_NONE : encodeReading(m, v[m]);
+        }
+        pts.push_back(p);
+    }
+    return pts;
+}
+
+// ==== BENCH ====
+
+static void usage()
+{
+    fprintf(stderr, "usage: mt15_series_bench [--days N] [--interval S] [--reps N] [--chunks N]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int      days     = 90;
+    uint32_t interval = 300;
+    int      reps     = 5;
+    int      chunks   = 2048;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (i + 1 >= argc) usage();
+        if      (strcmp(a, "--days") == 0)     days     = atoi(argv[++i]);
+        else if (strcmp(a, "--interval") == 0) interval = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(a, "--reps") == 0)     reps     = atoi(argv[++i]);
+        else if (strcmp(a, "--chunks") == 0)   chunks   = atoi(argv[++i]);
+        else usage();
+    }
+    if (days <= 0 || interval == 0 || reps <= 0) usage();
+
+    std::vector<Point>       pts = synthesize(days, interval);
+    std::vector<SeriesChunk> pool(chunks);
+    SeriesStore              store;
+    uint32_t                 window = days * 86400u / interval;
+
+    // Encode: best of `reps` fresh fills
+    unsigned long encodeUs = (unsigned long)-1;
+    for (int r = 0; r < reps; ++r) {
+        if (!seriesInit(store, pool.data(), chunks, window)) {
+            fprintf(stderr, "bad pool size %d\n", chunks);
+            return 1;
+        }
+        unsigned long t0 = platformMicros();
+        for (const Point &p : pts) seriesAppend(store, p.ts, p.values);
+        unsigned long us = platformMicros() - t0;
+        if (us < encodeUs) encodeUs = us;
+    }
+
+    size_t n = pts.size();
+    if (seriesCount(store) != n) {
+        printf("pool too small: kept %lu of %zu points (--chunks)\n",
+               (unsigned long)seriesCount(store), n);
+    }
+    size_t first = n - seriesCount(store);
+
+    // Decode: every metric front to back, best of `reps`
+    unsigned long decodeUs = (unsigned long)-1;
+    size_t        bad      = 0;
+    for (int r = 0; r < reps; ++r) {
+        unsigned long t0 = platformMicros();
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            SeriesCursor c;
+            seriesSeek(store, m, 0, c);
+            uint32_t ts;
+            int16_t  v;
+            for (size_t i = first; seriesNext(c, ts, v); ++i) {
+                if (r == 0 && (i >= n || ts != pts[i].ts || v != pts[i].values[m])) bad++;
+            }
+        }
+        unsigned long us = platformMicros() - t0;
+        if (us < decodeUs) decodeUs = us;
+    }
+
+    // A 30-day page out of the window: seek, then decode one metric
+    unsigned long seekUs = 0;
+    {
+        uint32_t from = store.lastTs - 30 * 86400u;
+        unsigned long t0 = platformMicros();
+        SeriesCursor c;
+        seriesSeek(store, METRIC_TEMP, from, c);
+        uint32_t ts;
+        int16_t  v;
+        size_t   got = 0;
+        while (seriesNext(c, ts, v)) got++;
+        seekUs = platformMicros() - t0;
+        if (got == 0 || got > n) bad++;
+    }
+
+    size_t kept = seriesCount(store);
+    size_t used = seriesBytesUsed(store);
+    size_t raw  = kept * (sizeof(uint32_t) + METRIC_COUNT * sizeof(int16_t));
+    printf("%zu points (%d days at %lu s), %d metrics\n", kept, days, (unsigned long)interval,
+           METRIC_COUNT);
+    printf("size: %zu B in %zu chunks vs %zu B as a history ring (%.1fx), %.2f B/point\n",
+           used, used / sizeof(SeriesChunk), raw, (double)raw / used, (double)used / kept);
+
+    printf("\n%-16s %9s\n", "stream", "bits/pt");
+    printf("%-16s %9.2f\n", "timestamps", (double)seriesStreamBits(store, 0) / kept);
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        printf("%-16s %9.2f\n", METRICS[m].name, (double)seriesStreamBits(store, 1 + m) / kept);
+    }
+
+    double values = (double)kept * METRIC_COUNT;
+    printf("\nencode: %.1f ms, %.0f ns/point, %.1f M values/s\n", encodeUs / 1000.0,
+           encodeUs * 1000.0 / n, n * METRIC_COUNT / (double)encodeUs);
+    printf("decode: %.1f ms all metrics, %.1f M values/s\n", decodeUs / 1000.0,
+           values / decodeUs);
+    printf("30-day seek + decode, one metric: %lu us\n", seekUs);
+
+    if (bad) {
+        printf("\nMISMATCH: %zu values decoded wrong\n", bad);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+#include "platform_host.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// ==== CLOCK / LOG ====
+
+static uint64_t monotonicUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+unsigned long platformMillis() { return (unsigned long)(monotonicUs() / 1000); }
+unsigned long platformMicros() { return (unsigned long)monotonicUs(); }
+
+void platformDelay(unsigned long ms)
+{
+    usleep(ms * 1000);
+}
+
+// xorshift32 seeded from the clock and pid; the fetch side is the only user
+uint32_t platformRandom()
+{
+    static uint32_t s = (uint32_t)monotonicUs() ^ ((uint32_t)getpid() << 16) ^ 0x9E3779B9u;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+void platformLog(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+// ==== MEMORY ====
+
+// No portable way to ask the allocator; the diagnostics page shows "--"
+size_t platformFreeHeap() { return 0; }
+size_t platformMinFreeHeap() { return 0; }
+size_t platformLargestFreeBlock() { return 0; }
+void  *platformAllocLarge(size_t size) { return malloc(size); }
+
+// ==== STORAGE ====
+
+const char *g_blobDir = NULL;
+
+static bool blobPath(char *buf, size_t size, const char *name, const char *ext)
+{
+    if (!g_blobDir) return false;
+    int n = snprintf(buf, size, "%s/%s.%s", g_blobDir, name, ext);
+    return n > 0 && (size_t)n < size;
+}
+
+long platformLoadBlob(const char *name, uint8_t *buf, size_t size)
+{
+    char path[512];
+    if (!blobPath(path, sizeof(path), name, "bin")) return -1;
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    size_t len = fread(buf, 1, size, f);
+    bool whole = fgetc(f) == EOF && !ferror(f);
+    fclose(f);
+    return whole ? (long)len : -1;
+}
+
+// Temp file + rename(), like LittleFS on the device
+bool platformSaveBlob(const char *name, const uint8_t *data, size_t len)
+{
+    char path[512], tmp[512];
+    if (!blobPath(path, sizeof(path), name, "bin") ||
+        !blobPath(tmp, sizeof(tmp), name, "tmp")) {
+        return false;
+    }
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return false;
+    bool ok = fwrite(data, 1, len, f) == len;
+    ok = fclose(f) == 0 && ok;
+    return ok && rename(tmp, path) == 0;
+}
+
+// ==== TCP ====
+
+bool PosixTransport::connect(const char *host, uint16_t port)
+{
+    stop();
+
+    char service[8];
+    snprintf(service, sizeof(service), "%u", (unsigned)port);
+
+    struct addrinfo hints = {}, *res = NULL;
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    uint64_t t0 = monotonicUs();
+    if (getaddrinfo(host, service, &hints, &res) != 0) return false;
+    uint64_t t1 = monotonicUs();
+
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            _fd = fd;
+            break;
+        }
+        close(fd);
+    }
+    freeaddrinfo(res);
+
+    dnsUs = (long)(t1 - t0);
+    tcpUs = (long)(monotonicUs() - t1);   // every address tried
+    tlsUs = -1;
+    _eof = false;
+    _pos = _len = 0;
+    return _fd >= 0;
+}
+
+void PosixTransport::fill()
+{
+    if (_fd < 0 || _eof || _pos < _len) return;
+
+    ssize_t n = recv(_fd, _buf, sizeof(_buf), MSG_DONTWAIT);
+    if (n > 0) {
+        _pos = 0;
+        _len = (size_t)n;
+        bytesRead += (uint64_t)n;
+    } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        _eof = true;
+    }
+}
+
+bool PosixTransport::connected()
+{
+    if (_fd < 0) return false;
+    fill();
+    return !_eof || _pos < _len;
+}
+
+void PosixTransport::stop()
+{
+    if (_fd >= 0) close(_fd);
+    _fd  = -1;
+    _eof = false;
+    _pos = _len = 0;
+}
+
+size_t PosixTransport::write(const uint8_t *buf, size_t len)
+{
+    size_t sent = 0;
+    while (_fd >= 0 && sent < len) {
+        ssize_t n = send(_fd, buf + sent, len - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += (size_t)n;
+    }
+    bytesWritten += sent;
+    return sent;
+}
+
+int PosixTransport::available()
+{
+    fill();
+    return (int)(_len - _pos);
+}
+
+int PosixTransport::read()
+{
+    fill();
+    return _pos < _len ? _buf[_pos++] : -1;
+}
+
+// ==== MULTICAST ====
+
+PosixMulticast::~PosixMulticast()
+{
+    if (_fd >= 0) close(_fd);
+}
+
+bool PosixMulticast::begin(const char *group, uint16_t port, bool receive)
+{
+    if (_fd >= 0) close(_fd);
+    _fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (_fd < 0) return false;
+
+    _dest = {};
+    _dest.sin_family = AF_INET;
+    _dest.sin_port   = htons(port);
+    if (inet_pton(AF_INET, group, &_dest.sin_addr) != 1) {
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    if (receive) {
+        int one = 1;
+        setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in any = {};
+        any.sin_family      = AF_INET;
+        any.sin_port        = htons(port);
+        any.sin_addr.s_addr = htonl(INADDR_ANY);
+        struct ip_mreq mreq = {};
+        mreq.imr_multiaddr        = _dest.sin_addr;
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (bind(_fd, (struct sockaddr *)&any, sizeof(any)) < 0 ||
+            setsockopt(_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            close(_fd);
+            _fd = -1;
+            return false;
+        }
+    } else {
+        unsigned char ttl = 1;   // this subnet only
+        setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    }
+    return true;
+}
+
+bool PosixMulticast::send(const uint8_t *buf, size_t len)
+{
+    return _fd >= 0 &&
+           sendto(_fd, buf, len, 0, (struct sockaddr *)&_dest, sizeof(_dest)) == (ssize_t)len;
+}
+
+int PosixMulticast::receive(uint8_t *buf, size_t size, unsigned long timeoutMs)
+{
+    if (_fd < 0) return -1;
+    struct pollfd p = { _fd, POLLIN, 0 };
+    int ready = poll(&p, 1, (int)timeoutMs);
+    if (ready <= 0) return ready < 0 && errno != EINTR ? -1 : 0;
+    ssize_t n = recv(_fd, buf, size, 0);
+    return n < 0 ? (errno == EINTR ? 0 : -1) : (int)n;
+}
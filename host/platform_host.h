@@ -0,0 +1,64 @@
+#pragma once
+#include <stdio.h>
+#include <netinet/in.h>
+#include "platform.h"
+
+// Where platformLoadBlob/platformSaveBlob keep their files; NULL (the
+// default) means no storage: loads find nothing and saves fail.
+extern const char *g_blobDir;
+
+// Plain TCP over POSIX sockets (no TLS); points the core at a local or
+// mock server instead of api.meraki.com.
+class PosixTransport : public Transport {
+public:
+    ~PosixTransport() override { stop(); }
+
+    bool   connect(const char *host, uint16_t port) override;
+    bool   connected() override;
+    void   stop() override;
+    size_t write(const uint8_t *buf, size_t len) override;
+    int    available() override;
+    int    read() override;
+
+    // Traffic since construction, for benchmarks
+    uint64_t bytesRead    = 0;
+    uint64_t bytesWritten = 0;
+
+private:
+    void fill();   // non-blocking top-up of the receive buffer
+
+    int     _fd  = -1;
+    bool    _eof = false;
+    uint8_t _buf[4096];
+    size_t  _pos = 0, _len = 0;
+};
+
+// UDP multicast over POSIX sockets; loops back to listeners on the same
+// machine, so a hub and listeners can run side by side.
+class PosixMulticast : public Multicast {
+public:
+    ~PosixMulticast() override;
+
+    bool begin(const char *group, uint16_t port, bool receive) override;
+    bool send(const uint8_t *buf, size_t len) override;
+    int  receive(uint8_t *buf, size_t size, unsigned long timeoutMs) override;
+
+private:
+    int                _fd   = -1;
+    struct sockaddr_in _dest = {};
+};
+
+// A whole file as a byte stream, for parsing recorded responses
+class FileReader : public ByteReader {
+public:
+    explicit FileReader(FILE *f) : _f(f) {}
+
+    int read() override
+    {
+        int c = fgetc(_f);
+        return c == EOF ? -1 : c;
+    }
+
+private:
+    FILE *_f;
+};
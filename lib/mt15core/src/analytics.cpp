@@ -0,0 +1,214 @@
+#include "analytics.h"
+
+#include <math.h>
+
+#include "meraki_http.h"
+#include "snapshot.h"
+
+// Levels from the usual indoor guidance (CO2 per ASHRAE 62.1's 1000 ppm
+// rule of thumb, PM2.5 per the 24 h WHO/EPA level). This is the one place
+// to touch for other thresholds.
+const AlertRule ALERT_RULES[] = {
+    { METRIC_CO2,  true,  1000, 900, 10 * 60, "CO2 high" },
+    { METRIC_PM25, true,  35,   25,  10 * 60, "PM2.5 high" },
+    { METRIC_TVOC, true,  500,  400, 15 * 60, "TVOC high" },
+    { METRIC_TEMP, true,  28,   27,  30 * 60, "Too warm" },
+    { METRIC_HUM,  false, 25,   30,  30 * 60, "Air dry" },
+};
+const int ALERT_RULE_COUNT = sizeof(ALERT_RULES) / sizeof(ALERT_RULES[0]);
+static_assert(sizeof(ALERT_RULES) / sizeof(ALERT_RULES[0]) <= MAX_ALERT_RULES,
+              "alertMask / alertSince hold MAX_ALERT_RULES");
+static_assert(STATS_WINDOW_SAMPLES <= 255, "deques hold uint8_t ring positions");
+
+static AnalyticsSummary emptySummary()
+{
+    AnalyticsSummary a = {};
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        MetricStats &s = a.stats[m];
+        s.ewma = s.min = s.max = s.mean = s.ratePerHour = NAN;
+    }
+    return a;
+}
+
+AnalyticsSummary g_analytics = emptySummary();
+
+// ==== WINDOW ====
+
+struct Sample {
+    uint32_t ts;
+    int16_t  value[METRIC_COUNT];   // READING_NONE = no reading
+};
+
+// Ring positions, oldest at the front
+struct PosDeque {
+    uint8_t pos[STATS_WINDOW_SAMPLES];
+    uint8_t head, count;
+};
+
+struct MetricWindow {
+    PosDeque valid;      // every sample with a reading, in order
+    PosDeque min, max;   // increasing / decreasing values
+    int32_t  sum;        // of `valid`
+    uint32_t ewmaTs;     // 0 = no EWMA yet
+};
+
+static Sample       g_ring[STATS_WINDOW_SAMPLES];
+static int          g_ringHead  = 0;
+static int          g_ringCount = 0;
+static MetricWindow g_window[METRIC_COUNT];
+static uint32_t     g_pendingSince[MAX_ALERT_RULES];   // 0 = not beyond `on`
+
+static inline int dqAt(const PosDeque &d, int i)
+{
+    return d.pos[(d.head + i) % STATS_WINDOW_SAMPLES];
+}
+
+static inline int dqFront(const PosDeque &d) { return dqAt(d, 0); }
+static inline int dqBack(const PosDeque &d)  { return dqAt(d, d.count - 1); }
+
+static inline void dqPushBack(PosDeque &d, int pos)
+{
+    d.pos[(d.head + d.count) % STATS_WINDOW_SAMPLES] = (uint8_t)pos;
+    d.count++;
+}
+
+static inline void dqPopFront(PosDeque &d)
+{
+    d.head = (uint8_t)((d.head + 1) % STATS_WINDOW_SAMPLES);
+    d.count--;
+}
+
+// Drops the oldest sample from the ring and every deque whose front it is
+static void evictOldest()
+{
+    int p = g_ringHead;
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        MetricWindow &w = g_window[m];
+        if (w.valid.count && dqFront(w.valid) == p) {
+            w.sum -= g_ring[p].value[m];
+            dqPopFront(w.valid);
+        }
+        if (w.min.count && dqFront(w.min) == p) dqPopFront(w.min);
+        if (w.max.count && dqFront(w.max) == p) dqPopFront(w.max);
+    }
+    g_ringHead = (g_ringHead + 1) % STATS_WINDOW_SAMPLES;
+    g_ringCount--;
+}
+
+static void pushValue(int m, int pos, int16_t v)
+{
+    MetricWindow &w = g_window[m];
+    dqPushBack(w.valid, pos);
+    w.sum += v;
+
+    // Anything the new value beats can never be the window's min (max)
+    // again: it leaves the window first
+    while (w.min.count && g_ring[dqBack(w.min)].value[m] >= v) w.min.count--;
+    dqPushBack(w.min, pos);
+    while (w.max.count && g_ring[dqBack(w.max)].value[m] <= v) w.max.count--;
+    dqPushBack(w.max, pos);
+}
+
+static void summarize(int m, MetricStats &s)
+{
+    const MetricWindow &w     = g_window[m];
+    float               scale = METRICS[m].scale;
+
+    s.samples = w.valid.count;
+    if (w.valid.count == 0) {
+        s.min = s.max = s.mean = s.ratePerHour = NAN;
+        return;
+    }
+    s.min  = g_ring[dqFront(w.min)].value[m] / scale;
+    s.max  = g_ring[dqFront(w.max)].value[m] / scale;
+    s.mean = (float)w.sum / w.valid.count / scale;
+
+    const Sample &first = g_ring[dqFront(w.valid)];
+    const Sample &last  = g_ring[dqBack(w.valid)];
+    s.ratePerHour = last.ts > first.ts
+        ? (last.value[m] - first.value[m]) / scale * 3600.0f / (last.ts - first.ts)
+        : NAN;
+}
+
+// ==== ALERTS ====
+
+static void evaluateRule(int r, uint32_t ts, double v)
+{
+    const AlertRule &rule = ALERT_RULES[r];
+    uint32_t bit    = 1u << r;
+    bool     beyond = rule.above ? v > rule.on : v < rule.on;
+    bool     clear  = rule.above ? v < rule.off : v > rule.off;
+
+    if (g_analytics.alertMask & bit) {
+        if (!clear) return;
+        g_analytics.alertMask &= ~bit;
+        g_pendingSince[r] = 0;
+        platformLog("[alert] %s cleared (%.1f %s)\n", rule.text, v, METRICS[rule.metric].unit);
+        return;
+    }
+
+    if (!beyond) {
+        g_pendingSince[r] = 0;
+        return;
+    }
+    if (!g_pendingSince[r]) g_pendingSince[r] = ts;
+    if (ts - g_pendingSince[r] >= rule.holdS) {
+        g_analytics.alertMask     |= bit;
+        g_analytics.alertSince[r]  = g_pendingSince[r];
+        platformLog("[alert] %s: %.1f %s for %lu min\n", rule.text, v,
+                    METRICS[rule.metric].unit, (unsigned long)(ts - g_pendingSince[r]) / 60);
+    }
+}
+
+// ==== SAMPLES ====
+
+void analyticsSample(uint32_t ts, const double values[METRIC_COUNT])
+{
+    if (g_analytics.ts && ts <= g_analytics.ts) return;
+
+    while (g_ringCount && (g_ringCount == STATS_WINDOW_SAMPLES ||
+                           g_ring[g_ringHead].ts + STATS_WINDOW_S <= ts)) {
+        evictOldest();
+    }
+
+    int     pos = (g_ringHead + g_ringCount) % STATS_WINDOW_SAMPLES;
+    Sample &smp = g_ring[pos];
+    smp.ts = ts;
+    g_ringCount++;
+
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        smp.value[m] = encodeReading(m, values[m]);
+        MetricStats &s = g_analytics.stats[m];
+        if (smp.value[m] != READING_NONE) {
+            pushValue(m, pos, smp.value[m]);
+
+            // Irregular sampling: weight by the time since the last value
+            MetricWindow &w = g_window[m];
+            if (!w.ewmaTs) {
+                s.ewma = (float)values[m];
+            } else {
+                float alpha = 1.0f - expf(-(float)(ts - w.ewmaTs) / STATS_EWMA_TAU_S);
+                s.ewma += alpha * ((float)values[m] - s.ewma);
+            }
+            w.ewmaTs = ts;
+        }
+        summarize(m, s);
+    }
+
+    // The hold has to be seen, not assumed: a sample without the metric,
+    // or a gap longer than the hold, starts the run over
+    for (int r = 0; r < ALERT_RULE_COUNT; ++r) {
+        const AlertRule &rule = ALERT_RULES[r];
+        double v = values[rule.metric];
+        if (isnan(v) || (g_analytics.ts && ts - g_analytics.ts > rule.holdS)) g_pendingSince[r] = 0;
+        if (!isnan(v)) evaluateRule(r, ts, v);
+    }
+    g_analytics.ts = ts;
+}
+
+void analyticsUpdate()
+{
+    int s = sensorFind(g_sensors, g_merakiConfig.serial);
+    if (s < 0 || !g_sensors.ts[s]) return;
+    analyticsSample(g_sensors.ts[s], g_latest);
+}
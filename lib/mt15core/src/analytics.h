@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include "metrics.h"
+
+// On-device trends and alerts, so "has CO2 been high all morning?" costs
+// no API call. Every new reading of the configured sensor (latest poll,
+// MQTT burst, hub state) is one sample:
+//
+//   per metric   EWMA with time constant STATS_EWMA_TAU_S; min, max, mean
+//                and rate of change over the last STATS_WINDOW_S
+//   alert rules  ALERT_RULES: a metric beyond its trip level for the hold
+//                time raises the alert, back past the clear level drops it
+//                (hysteresis, so a reading hovering at the line doesn't
+//                flap). A missing reading or a gap longer than the hold
+//                restarts the hold.
+//
+// The window is a ring of samples in the history ring's 16-bit fixed
+// point. Min and max come from monotonic deques of ring positions, the
+// mean from a running integer sum, so each sample enters and leaves every
+// structure once: constant cost per sample however long the window, and
+// no drift in the sum. All state is static; nothing is allocated.
+//
+// Fetch side; the UI reads the summary from its snapshot.
+
+const uint32_t STATS_WINDOW_S       = 60 * 60;
+const int      STATS_WINDOW_SAMPLES = 128;       // cap: one per 28 s over the hour
+const uint32_t STATS_EWMA_TAU_S     = 10 * 60;
+const int      MAX_ALERT_RULES      = 8;
+
+struct AlertRule {
+    int         metric;
+    bool        above;      // trips above `on`, else below
+    float       on, off;    // trip / clear levels
+    uint32_t    holdS;      // beyond `on` this long before it trips
+    const char *text;       // banner, up to 12 characters
+};
+
+extern const AlertRule ALERT_RULES[];
+extern const int       ALERT_RULE_COUNT;
+
+// NAN where there's nothing to show yet (rate needs two samples)
+struct MetricStats {
+    float    ewma;
+    float    min, max, mean;   // over the window
+    float    ratePerHour;      // oldest to newest sample in the window
+    uint32_t samples;          // in the window
+};
+
+struct AnalyticsSummary {
+    uint32_t    ts;                            // newest sample, unix s; 0 = none
+    MetricStats stats[METRIC_COUNT];
+    uint32_t    alertMask;                     // bit per ALERT_RULES entry raised
+    uint32_t    alertSince[MAX_ALERT_RULES];   // first sample beyond `on`
+};
+
+extern AnalyticsSummary g_analytics;   // fetch side, copied into snapshots
+
+// Feeds the working state's readings for the configured sensor (g_latest,
+// at its g_sensors timestamp) in as one sample. A reading already fed is
+// skipped, so it is safe to call after every refresh.
+void analyticsUpdate();
+
+// One sample at `ts` (unix s, newer than the last); NAN = no reading.
+void analyticsSample(uint32_t ts, const double values[METRIC_COUNT]);
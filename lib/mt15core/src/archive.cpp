@@ -0,0 +1,39 @@
+#include "archive.h"
+
+#include "meraki_http.h"
+#include "platform.h"
+#include "snapshot.h"
+
+SeriesStore g_archive = {};
+
+bool archiveInit()
+{
+    if (g_archive.chunks) return true;
+    SeriesChunk *pool = (SeriesChunk *)platformAllocLarge(ARCHIVE_CHUNKS * sizeof(SeriesChunk));
+    if (!pool || !seriesInit(g_archive, pool, ARCHIVE_CHUNKS, ARCHIVE_MAX_POINTS)) {
+        platformLog("[archive] pool alloc failed, archive off\n");
+        return false;
+    }
+    return true;
+}
+
+void archiveUpdate()
+{
+    if (!g_archive.chunks) return;
+    int s = sensorFind(g_sensors, g_merakiConfig.serial);
+    if (s < 0 || !g_sensors.ts[s]) return;
+
+    uint32_t slot = g_sensors.ts[s] - g_sensors.ts[s] % ARCHIVE_INTERVAL_S;
+    if (seriesCount(g_archive) > 0 && slot <= g_archive.lastTs) return;
+
+    int16_t values[METRIC_COUNT];
+    for (int m = 0; m < METRIC_COUNT; ++m) values[m] = encodeReading(m, g_latest[m]);
+    if (!seriesAppend(g_archive, slot, values)) return;
+
+    // Hourly, not every slot
+    if (g_archive.end % (3600 / ARCHIVE_INTERVAL_S) == 1) {
+        platformLog("[archive] holding %lu points in %lu bytes\n",
+                    (unsigned long)seriesCount(g_archive),
+                    (unsigned long)seriesBytesUsed(g_archive));
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "series_store.h"
+
+// The configured sensor's readings at 5-minute resolution for 90 days, well
+// past the history ring's 30, in a compressed store (series_store.h).
+// Fed from every new reading (latest poll, MQTT burst, hub state) rather
+// than from the ring, so the resolution doesn't depend on
+// HISTORY_INTERVAL_S: the first reading in each ARCHIVE_INTERVAL_S slot is
+// kept, stamped with the slot's start.
+//
+// Sized at ARCHIVE_BYTES_PER_POINT, what 5-minute MT data takes
+// (host/mt15_series_bench.cpp); if a noisier site needs more, the oldest
+// days go first. RAM only, so it starts over after a reset. Served as
+// /history?span=90d (local_api.h).
+//
+// Fetch side.
+
+const uint32_t ARCHIVE_INTERVAL_S      = 300;
+const uint32_t ARCHIVE_SPAN_S          = 90 * 86400;
+const uint32_t ARCHIVE_MAX_POINTS      = ARCHIVE_SPAN_S / ARCHIVE_INTERVAL_S;
+const size_t   ARCHIVE_BYTES_PER_POINT = 6;
+const int      ARCHIVE_CHUNKS =
+    (int)(ARCHIVE_MAX_POINTS * ARCHIVE_BYTES_PER_POINT / SERIES_CHUNK_BYTES) + 3 * SERIES_STREAMS;
+static_assert(ARCHIVE_CHUNKS < SERIES_NO_CHUNK, "chunk links are 16 bits");
+
+// Inactive (every call a no-op, readers see it empty) until archiveInit()
+extern SeriesStore g_archive;
+
+// Allocates the pool (platformAllocLarge(), once; ~170 KB).
+bool archiveInit();
+
+// Appends the working state's reading for the configured sensor (g_latest,
+// at its g_sensors timestamp) if its slot isn't held yet. Safe to call
+// after every refresh.
+void archiveUpdate();
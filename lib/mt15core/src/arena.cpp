@@ -0,0 +1,17 @@
+#include "arena.h"
+
+#include "platform.h"
+
+void *Arena::alloc(size_t size)
+{
+    size_t start = (_used + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (start > _size || size > _size - start) {
+        _failures++;
+        platformLog("[arena] out of memory: %u bytes wanted, %u of %u in use\n",
+                    (unsigned)size, (unsigned)_used, (unsigned)_size);
+        return NULL;
+    }
+    _used = start + size;
+    if (_used > _high) _high = _used;
+    return _buf + start;
+}
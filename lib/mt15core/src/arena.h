@@ -0,0 +1,67 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+// Bump allocator over a caller-supplied static block. Allocations are
+// released in stack order through ArenaScope, never one by one, so the
+// block can't fragment and nothing ever reaches the system heap.
+//
+//   ArenaScope scope(g_fetchArena);
+//   SensorStore *store = g_fetchArena.make<SensorStore>();
+//   ...                       // everything made here goes away with `scope`
+
+const size_t ARENA_ALIGN = 8;   // doubles and pointers on the ESP32 and our hosts
+
+class Arena {
+public:
+    Arena(uint8_t *buf, size_t size) : _buf(buf), _size(size) {}
+
+    // `size` bytes aligned to ARENA_ALIGN, or NULL (logged and counted)
+    // when the block is exhausted.
+    void *alloc(size_t size);
+
+    // A default-initialised T: like malloc, the plain structs we keep
+    // here come back with whatever the last user left in them
+    template <class T> T *make()
+    {
+        void *p = alloc(sizeof(T));
+        return p ? new (p) T : NULL;
+    }
+
+    size_t mark() const { return _used; }
+    void   release(size_t mark) { if (mark < _used) _used = mark; }
+
+    size_t   size() const { return _size; }
+    size_t   used() const { return _used; }
+    size_t   highWater() const { return _high; }   // most ever in use
+    uint32_t failures() const { return _failures; }
+
+private:
+    uint8_t *_buf;
+    size_t   _size;
+    size_t   _used     = 0;
+    size_t   _high     = 0;
+    uint32_t _failures = 0;
+};
+
+// Gives back everything allocated from `arena` during its lifetime
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena &arena) : _arena(arena), _mark(arena.mark()) {}
+    ~ArenaScope() { _arena.release(_mark); }
+
+private:
+    ArenaScope(const ArenaScope &);
+    ArenaScope &operator=(const ArenaScope &);
+
+    Arena &_arena;
+    size_t _mark;
+};
+
+// Bytes an arena needs for `size` bytes worth of allocations, counting the
+// alignment padding each one may add
+constexpr size_t arenaBytes(size_t size, int allocations)
+{
+    return size + allocations * (ARENA_ALIGN - 1);
+}
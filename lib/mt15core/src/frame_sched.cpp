@@ -0,0 +1,65 @@
+#include "frame_sched.h"
+
+#include "perf_stats.h"
+#include "platform.h"
+
+static bool          g_frameDirty    = false;
+static bool          g_frameDeadline = false;
+static unsigned long g_frameBy       = 0;   // valid while g_frameDeadline
+static unsigned long g_frameLast     = 0;   // when the last frame was rendered
+static bool          g_frameAny      = false;
+
+// Earliest the next frame may start
+static unsigned long nextSlot()
+{
+    return g_frameAny ? g_frameLast + FRAME_MIN_MS : platformMillis();
+}
+
+void frameInvalidate()
+{
+    g_frameDirty = true;
+}
+
+void frameRenderBy(unsigned long ms)
+{
+    if (g_frameDeadline && reached(g_frameBy, ms)) return;   // an earlier one is set
+    g_frameBy = ms;
+    g_frameDeadline = true;
+}
+
+void frameWoke(uint32_t events)
+{
+    FrameStats &s = g_frameStats;
+    s.wakes++;
+    if (events & FRAME_EV_TOUCH) s.touchWakes++;
+    if (events & FRAME_EV_DATA)  s.dataWakes++;
+    if (events == 0)             s.timerWakes++;
+}
+
+bool frameDue()
+{
+    unsigned long now = platformMillis();
+    bool pending = g_frameDirty || (g_frameDeadline && reached(g_frameBy, now));
+    return pending && reached(nextSlot(), now);
+}
+
+void frameDone()
+{
+    unsigned long now = platformMillis();
+    g_frameDirty = false;
+    if (g_frameDeadline && reached(g_frameBy, now)) g_frameDeadline = false;
+    g_frameLast = now;
+    g_frameAny  = true;
+    g_frameStats.frames++;
+}
+
+unsigned long frameSleepMs()
+{
+    unsigned long now = platformMillis();
+    if (!g_frameDirty && !g_frameDeadline) return FRAME_SLEEP_FOREVER;
+
+    // Dirty renders at the next slot, a deadline at whichever is later
+    unsigned long due = nextSlot();
+    if (!g_frameDirty && !reached(g_frameBy, due)) due = g_frameBy;
+    return reached(due, now) ? 0 : due - now;
+}
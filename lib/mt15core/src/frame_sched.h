@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+// Frame scheduling for the UI loop. The loop sleeps until something wakes
+// it, tells this why, and renders only when a frame is due:
+//
+//   events      touch samples and freshly published snapshots (FRAME_EV_*),
+//               delivered by the firmware as task notification bits
+//   deadlines   "render by" times for things that change on their own
+//               (the diagnostics page), the only timed wake-ups left
+//   frames      at most one per FRAME_MIN_MS however many events arrive;
+//               a first event after idling renders at once
+//
+// With nothing changing the loop sleeps indefinitely. Only the UI calls
+// into this.
+
+// Why the loop woke up; bits so several can arrive in one notification
+const uint32_t FRAME_EV_TOUCH = 1 << 0;
+const uint32_t FRAME_EV_DATA  = 1 << 1;
+
+// One full-page blit takes ~31 ms, so faster frames would only queue up
+const unsigned long FRAME_MIN_MS = 33;
+
+// frameSleepMs() with nothing pending
+const unsigned long FRAME_SLEEP_FOREVER = 0xFFFFFFFFUL;
+
+// Something on screen is out of date: render at the next frame slot.
+void frameInvalidate();
+
+// Render no later than `ms` (platformMillis()) even if nothing else
+// happens. Keeps the earliest of several.
+void frameRenderBy(unsigned long ms);
+
+// Accounts for one wake-up: the FRAME_EV_* bits it brought, 0 on a timeout.
+void frameWoke(uint32_t events);
+
+// True if a frame should be rendered now; follow it with frameDone().
+bool frameDue();
+
+// A frame was rendered: clears what was pending, counts it.
+void frameDone();
+
+// How long the loop may sleep before the next frame or deadline is due,
+// 0 if one already is, FRAME_SLEEP_FOREVER if nothing is pending.
+unsigned long frameSleepMs();
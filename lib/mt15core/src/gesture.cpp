@@ -0,0 +1,116 @@
+#include "gesture.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// ==== TOUCH RING ====
+
+bool TouchRing::push(const TouchSample &s)
+{
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= (uint32_t)TOUCH_RING_SIZE) {
+        _dropped++;
+        return false;
+    }
+    _buf[head % TOUCH_RING_SIZE] = s;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool TouchRing::pop(TouchSample &s)
+{
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) return false;
+    s = _buf[tail % TOUCH_RING_SIZE];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// ==== RECOGNIZER ====
+
+float GestureRecognizer::releaseVelocity(bool vertical) const
+{
+    if (_recentCount < 2) return 0.0f;
+
+    // Newest sample against the oldest one still inside the window
+    const TouchSample &last = _recent[(_recentHead + GESTURE_RECENT - 1) % GESTURE_RECENT];
+    const TouchSample *first = &last;
+    for (int k = 2; k <= _recentCount; ++k) {
+        const TouchSample &s = _recent[(_recentHead + GESTURE_RECENT - k) % GESTURE_RECENT];
+        if (last.us - s.us > GESTURE_VELOCITY_US) break;
+        first = &s;
+    }
+    uint32_t dt = last.us - first->us;
+    if (dt == 0) return 0.0f;
+    int d = vertical ? last.y - first->y : last.x - first->x;
+    return d * 1e6f / dt;
+}
+
+bool GestureRecognizer::feed(const TouchSample &s, Gesture &out)
+{
+    if (s.down) {
+        if (_state == IDLE) {
+            _state = PENDING;
+            _start = s;
+            _lastY = s.y;
+            _recentCount = 0;
+        }
+        _recent[_recentHead] = s;
+        _recentHead = (_recentHead + 1) % GESTURE_RECENT;
+        if (_recentCount < GESTURE_RECENT) _recentCount++;
+    } else if (_state == IDLE) {
+        return false;   // a release we never saw start
+    }
+
+    out.type     = GESTURE_NONE;
+    out.x        = _start.x;
+    out.y        = _start.y;
+    out.dy       = 0;
+    out.velocity = 0.0f;
+    out.us       = s.us;
+
+    int dx = s.x - _start.x;
+    int dy = s.y - _start.y;
+
+    if (_state == PENDING && s.down) {
+        if (abs(dx) > GESTURE_SLOP_PX || abs(dy) > GESTURE_SLOP_PX) {
+            _state = abs(dy) > abs(dx) ? SCROLLING : SWIPING;
+        } else if (s.us - _start.us >= GESTURE_LONG_PRESS_US) {
+            _state = HELD;
+            out.type = GESTURE_LONG_PRESS;
+            return true;
+        }
+    }
+
+    if (_state == SCROLLING && s.down && s.y != _lastY) {
+        out.type = GESTURE_SCROLL;
+        out.dy   = s.y - _lastY;
+        _lastY   = s.y;
+        return true;
+    }
+
+    if (s.down) return false;
+
+    // Released
+    State state = _state;
+    _state = IDLE;
+
+    if (state == PENDING && s.us - _start.us < GESTURE_LONG_PRESS_US) {
+        out.type = GESTURE_TAP;
+    } else if (state == SWIPING) {
+        float v = releaseVelocity(false);
+        if (fabsf(v) >= GESTURE_FLING_PX_PER_S || abs(dx) >= GESTURE_SWIPE_PX) {
+            // A far drag released slowly still goes the way it travelled
+            bool left = fabsf(v) >= GESTURE_FLING_PX_PER_S ? v < 0 : dx < 0;
+            out.type     = left ? GESTURE_FLING_LEFT : GESTURE_FLING_RIGHT;
+            out.velocity = fabsf(v);
+        }
+    } else if (state == SCROLLING) {
+        float v = releaseVelocity(true);
+        if (fabsf(v) >= GESTURE_FLING_PX_PER_S) {
+            out.type     = v < 0 ? GESTURE_FLING_UP : GESTURE_FLING_DOWN;
+            out.velocity = fabsf(v);
+        }
+    }
+    return out.type != GESTURE_NONE;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Touch input: raw samples from the touch task, and the gestures the UI
+// acts on.
+//
+// The firmware's touch task wakes on the controller's interrupt and, while
+// a finger is down, samples at a steady TOUCH_SAMPLE_MS into a TouchRing;
+// the UI drains the ring and runs every sample through a GestureRecognizer.
+// Nothing here knows about pages: main.cpp decides what a fling does.
+
+const int      TOUCH_SAMPLE_MS = 10;      // 100 Hz while pressed
+const int      TOUCH_RING_SIZE = 64;      // 640 ms of samples; power of two
+
+// Recognizer thresholds
+const int      GESTURE_SLOP_PX        = 10;      // movement before a drag starts
+const uint32_t GESTURE_LONG_PRESS_US  = 600000;  // held still this long
+const uint32_t GESTURE_VELOCITY_US    = 80000;   // window the release velocity is taken over
+const float    GESTURE_FLING_PX_PER_S = 300.0f;  // slower releases aren't flings
+const int      GESTURE_SWIPE_PX       = 80;      // ...unless they travelled this far
+const int      GESTURE_RECENT         = 16;      // samples kept for that (160 ms)
+
+struct TouchSample {
+    int16_t  x, y;
+    bool     down;   // false: the finger lifted (x, y repeat the last point)
+    uint32_t us;     // platformMicros() when sampled, truncated
+};
+
+// Lock-free single producer (touch task) / single consumer (UI) ring.
+// When the UI falls behind, new samples are dropped rather than old ones
+// overwritten, so a release is never lost in the middle of a gesture.
+class TouchRing {
+public:
+    bool push(const TouchSample &s);
+    bool pop(TouchSample &s);
+
+    uint32_t dropped() const { return _dropped; }
+
+private:
+    TouchSample           _buf[TOUCH_RING_SIZE];
+    std::atomic<uint32_t> _head{0};   // next write, producer only
+    std::atomic<uint32_t> _tail{0};   // next read, consumer only
+    uint32_t              _dropped = 0;
+};
+
+enum GestureType {
+    GESTURE_NONE = 0,
+    GESTURE_TAP,
+    GESTURE_LONG_PRESS,
+    GESTURE_SCROLL,        // vertical drag step: dy since the last one
+    GESTURE_FLING_LEFT,    // horizontal release, fast or far enough
+    GESTURE_FLING_RIGHT,
+    GESTURE_FLING_UP,      // vertical release after a scroll, fast enough
+    GESTURE_FLING_DOWN
+};
+
+struct Gesture {
+    GestureType type;
+    int16_t     x, y;       // where it started
+    int16_t     dy;         // GESTURE_SCROLL: finger travel, up = negative
+    float       velocity;   // flings: px/s along their axis, always positive
+    uint32_t    us;         // sample that completed it, for input latency
+};
+
+// Turns one finger's samples into gestures:
+//   down, no movement past the slop, up      tap (before the long-press time)
+//   down, held still for the long-press time long press (once; rest swallowed)
+//   mostly vertical movement                 scroll steps, then maybe a
+//                                            vertical fling on release
+//   mostly horizontal movement               horizontal fling on release if
+//                                            fast or far enough
+// Velocity comes from the samples of the last GESTURE_VELOCITY_US before
+// release, so a slow drag that ends in a flick still flings.
+class GestureRecognizer {
+public:
+    // Feeds one sample; true with `out` filled when it completes a gesture.
+    bool feed(const TouchSample &s, Gesture &out);
+
+private:
+    enum State { IDLE, PENDING, SCROLLING, SWIPING, HELD };
+
+    float releaseVelocity(bool vertical) const;
+
+    State       _state = IDLE;
+    TouchSample _start = {};
+    int16_t     _lastY = 0;     // y the last scroll step was reported at
+    TouchSample _recent[GESTURE_RECENT];   // newest samples, for the release velocity
+    int         _recentCount = 0;
+    int         _recentHead  = 0;
+};
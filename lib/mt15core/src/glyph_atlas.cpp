@@ -0,0 +1,266 @@
+#include "glyph_atlas.h"
+
+#include <math.h>
+#include <string.h>
+
+// ==== STROKE FONT ====
+
+// Glyphs are drawn on a 20-unit-high design grid: cap height from y = 1
+// to the baseline at y = 15, x-height from y = 7, descenders to y = 19.
+// Each is a few lines and elliptical arcs (angles in degrees, 0 = +x,
+// 90 = down) stroked with round ends.
+const float DESIGN_H     = 20.0f;
+const float DESIGN_BASE  = 15.0f;
+const float STROKE_HALF  = 1.0f;    // half the pen width
+const float ARC_STEP_DEG = 15.0f;   // arcs become polylines this fine
+
+struct GlyphDef {
+    char  c;
+    float advance;
+};
+
+// In GLYPH_CHARS order
+static const GlyphDef GLYPHS[] = {
+    { ' ', 5 },  { '-', 8 },  { '.', 4 },  { '/', 7 },  { '%', 11 },
+    { '0', 10 }, { '1', 10 }, { '2', 10 }, { '3', 10 }, { '4', 10 },
+    { '5', 10 }, { '6', 10 }, { '7', 10 }, { '8', 10 }, { '9', 10 },
+    { 'B', 10 }, { 'C', 10 }, { 'b', 10 }, { 'd', 10 }, { 'g', 10 },
+    { 'm', 12 }, { 'p', 10 }, { 'u', 10 },
+};
+static_assert(sizeof(GLYPHS) / sizeof(GLYPHS[0]) == GLYPH_COUNT, "a GlyphDef per GLYPH_CHARS");
+
+enum StrokeKind { STROKE_LINE, STROKE_ARC };
+
+// LINE: x0 y0 x1 y1; ARC: cx cy rx ry from to
+struct Stroke {
+    char    c;
+    uint8_t kind;
+    float   p[6];
+};
+
+static const Stroke STROKES[] = {
+    { '-', STROKE_LINE, { 1.5, 9, 6.5, 9 } },
+    { '.', STROKE_LINE, { 1.6, 14.1, 2.4, 14.1 } },
+    { '/', STROKE_LINE, { 6, 1, 1, 15 } },
+    { '%', STROKE_ARC,  { 3, 4, 2, 2.6, 0, 360 } },
+    { '%', STROKE_ARC,  { 8, 12, 2, 2.6, 0, 360 } },
+    { '%', STROKE_LINE, { 9, 1.5, 2, 14.5 } },
+
+    { '0', STROKE_ARC,  { 5, 8, 3.8, 7, 0, 360 } },
+    { '1', STROKE_LINE, { 2.5, 3.5, 5.5, 1 } },
+    { '1', STROKE_LINE, { 5.5, 1, 5.5, 15 } },
+    { '2', STROKE_ARC,  { 5, 4.8, 3.8, 3.8, 190, 385 } },
+    { '2', STROKE_LINE, { 8.44, 6.4, 1.2, 15 } },
+    { '2', STROKE_LINE, { 1.2, 15, 8.8, 15 } },
+    { '3', STROKE_ARC,  { 5, 4.6, 3.6, 3.6, 200, 450 } },
+    { '3', STROKE_ARC,  { 5, 11.4, 3.8, 3.6, 270, 520 } },
+    { '4', STROKE_LINE, { 6.8, 15, 6.8, 1 } },
+    { '4', STROKE_LINE, { 6.8, 1, 1, 10.8 } },
+    { '4', STROKE_LINE, { 1, 10.8, 9.2, 10.8 } },
+    { '5', STROKE_LINE, { 8.5, 1, 2.3, 1 } },
+    { '5', STROKE_LINE, { 2.3, 1, 1.9, 7.6 } },
+    { '5', STROKE_ARC,  { 5, 10.6, 3.9, 4.4, 220, 500 } },
+    { '6', STROKE_ARC,  { 5, 10.6, 3.8, 4.4, 0, 360 } },
+    { '6', STROKE_LINE, { 7.8, 1.2, 1.4, 9.4 } },
+    { '7', STROKE_LINE, { 1, 1, 9, 1 } },
+    { '7', STROKE_LINE, { 9, 1, 3.8, 15 } },
+    { '8', STROKE_ARC,  { 5, 4.5, 3.4, 3.5, 0, 360 } },
+    { '8', STROKE_ARC,  { 5, 11.4, 3.9, 3.6, 0, 360 } },
+    { '9', STROKE_ARC,  { 5, 5.4, 3.8, 4.4, 0, 360 } },
+    { '9', STROKE_LINE, { 8.6, 6.6, 2.2, 14.8 } },
+
+    { 'B', STROKE_LINE, { 1.5, 1, 1.5, 15 } },
+    { 'B', STROKE_LINE, { 1.5, 1, 5.2, 1 } },
+    { 'B', STROKE_ARC,  { 5.2, 4.5, 3.3, 3.5, 270, 450 } },
+    { 'B', STROKE_LINE, { 5.2, 8, 1.5, 8 } },
+    { 'B', STROKE_ARC,  { 5.6, 11.5, 3.6, 3.5, 270, 450 } },
+    { 'B', STROKE_LINE, { 5.6, 15, 1.5, 15 } },
+    { 'C', STROKE_ARC,  { 5.6, 8, 4.4, 7, 40, 320 } },
+    { 'b', STROKE_LINE, { 1.7, 1, 1.7, 15 } },
+    { 'b', STROKE_ARC,  { 5, 11, 3.3, 4, 0, 360 } },
+    { 'd', STROKE_LINE, { 8.3, 1, 8.3, 15 } },
+    { 'd', STROKE_ARC,  { 5, 11, 3.3, 4, 0, 360 } },
+    { 'g', STROKE_ARC,  { 5, 10.6, 3.3, 3.6, 0, 360 } },
+    { 'g', STROKE_LINE, { 8.3, 7, 8.3, 16 } },
+    { 'g', STROKE_ARC,  { 5, 16, 3.3, 3, 0, 150 } },
+    { 'm', STROKE_LINE, { 1.5, 7, 1.5, 15 } },
+    { 'm', STROKE_ARC,  { 3.75, 9.7, 2.25, 2.7, 180, 360 } },
+    { 'm', STROKE_LINE, { 6, 9.7, 6, 15 } },
+    { 'm', STROKE_ARC,  { 8.25, 9.7, 2.25, 2.7, 180, 360 } },
+    { 'm', STROKE_LINE, { 10.5, 9.7, 10.5, 15 } },
+    { 'p', STROKE_LINE, { 1.7, 7, 1.7, 19 } },
+    { 'p', STROKE_ARC,  { 5, 11, 3.3, 4, 0, 360 } },
+    { 'u', STROKE_LINE, { 1.7, 7, 1.7, 11.5 } },
+    { 'u', STROKE_ARC,  { 4.9, 11.5, 3.2, 3.5, 0, 180 } },
+    { 'u', STROKE_LINE, { 8.1, 7, 8.1, 15 } },
+};
+
+// ==== RASTERISING ====
+
+const int MAX_GLYPH_SEGMENTS = 96;
+
+struct Segment {
+    float x0, y0, x1, y1;
+};
+
+// Glyph `c` as line segments in px at `scale`
+static int glyphSegments(char c, float scale, Segment *seg)
+{
+    int n = 0;
+    for (const Stroke &s : STROKES) {
+        if (s.c != c) continue;
+        if (s.kind == STROKE_LINE) {
+            if (n < MAX_GLYPH_SEGMENTS) {
+                seg[n++] = { s.p[0] * scale, s.p[1] * scale, s.p[2] * scale, s.p[3] * scale };
+            }
+            continue;
+        }
+        int   steps = (int)ceilf((s.p[5] - s.p[4]) / ARC_STEP_DEG);
+        float px = 0, py = 0;
+        for (int i = 0; i <= steps; ++i) {
+            float a = (s.p[4] + (s.p[5] - s.p[4]) * i / steps) * (float)M_PI / 180.0f;
+            float x = (s.p[0] + s.p[2] * cosf(a)) * scale;
+            float y = (s.p[1] + s.p[3] * sinf(a)) * scale;
+            if (i > 0 && n < MAX_GLYPH_SEGMENTS) seg[n++] = { px, py, x, y };
+            px = x;
+            py = y;
+        }
+    }
+    return n;
+}
+
+static float segmentDist2(const Segment &s, float x, float y)
+{
+    float dx = s.x1 - s.x0, dy = s.y1 - s.y0;
+    float len2 = dx * dx + dy * dy;
+    float t = len2 > 0 ? ((x - s.x0) * dx + (y - s.y0) * dy) / len2 : 0;
+    t = t < 0 ? 0 : t > 1 ? 1 : t;
+    float ex = s.x0 + t * dx - x, ey = s.y0 + t * dy - y;
+    return ex * ex + ey * ey;
+}
+
+// Coverage masks of every glyph at one size, in the faces' cell layout
+struct SizeMasks {
+    uint8_t  height, baseline;
+    uint8_t  advance[GLYPH_COUNT];
+    uint32_t offset[GLYPH_COUNT];
+    uint32_t total;       // pixels, all cells
+    uint8_t *coverage;    // NULL until rasterised
+};
+
+static SizeMasks g_masks[GLYPH_SIZES];
+static GlyphFace g_faces[MAX_GLYPH_FACES];
+static int       g_faceCount = 0;
+
+// Pen edge is anti-aliased over one pixel: coverage falls from 1 to 0 as
+// the pixel centre moves from half a pixel inside to half outside
+static bool rasteriseSize(int size)
+{
+    SizeMasks &m = g_masks[size];
+    if (m.coverage) return true;
+
+    unsigned long t0    = platformMicros();
+    float         scale = GLYPH_CELL_H[size] / DESIGN_H;
+    float         pen   = STROKE_HALF * scale;
+    float         solid = pen > 0.5f ? (pen - 0.5f) * (pen - 0.5f) : 0;
+
+    m.height   = (uint8_t)GLYPH_CELL_H[size];
+    m.baseline = (uint8_t)lroundf(DESIGN_BASE * scale);
+    m.total    = 0;
+    for (int g = 0; g < GLYPH_COUNT; ++g) {
+        m.advance[g] = (uint8_t)lroundf(GLYPHS[g].advance * scale);
+        m.offset[g]  = m.total;
+        m.total     += (uint32_t)m.advance[g] * m.height;
+    }
+    uint8_t *cov = (uint8_t *)platformAllocLarge(m.total);
+    if (!cov) return false;
+
+    static Segment seg[MAX_GLYPH_SEGMENTS];   // 1.5 KB, off the UI task's stack
+    for (int g = 0; g < GLYPH_COUNT; ++g) {
+        int      n    = glyphSegments(GLYPHS[g].c, scale, seg);
+        int      w    = m.advance[g];
+        uint8_t *cell = cov + m.offset[g];
+        for (int y = 0; y < m.height; ++y) {
+            for (int x = 0; x < w; ++x) {
+                float best = 1e9f;
+                for (int i = 0; i < n && best > solid; ++i) {
+                    float d2 = segmentDist2(seg[i], x + 0.5f, y + 0.5f);
+                    if (d2 < best) best = d2;
+                }
+                float c = pen + 0.5f - sqrtf(best);
+                c = c < 0 ? 0 : c > 1 ? 1 : c;
+                cell[y * w + x] = (uint8_t)lroundf(c * 255);
+            }
+        }
+    }
+    m.coverage = cov;
+    platformLog("[glyph] %d px: %d glyphs rasterised in %lu us, %lu B\n", m.height,
+                GLYPH_COUNT, platformMicros() - t0, (unsigned long)m.total);
+    return true;
+}
+
+// ==== FACES ====
+
+static uint16_t blend565(uint16_t fg, uint16_t bg, uint8_t a)
+{
+    int na = 255 - a;
+    int r  = ((bg >> 11) * na + (fg >> 11) * a + 127) / 255;
+    int g  = (((bg >> 5) & 0x3F) * na + ((fg >> 5) & 0x3F) * a + 127) / 255;
+    int b  = ((bg & 0x1F) * na + (fg & 0x1F) * a + 127) / 255;
+    return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+const GlyphFace *glyphFace(int size, uint16_t fg, uint16_t bg)
+{
+    if (size < 0 || size >= GLYPH_SIZES) return NULL;
+    for (int i = 0; i < g_faceCount; ++i) {
+        const GlyphFace &f = g_faces[i];
+        if (f.size == size && f.fg == fg && f.bg == bg) return &f;
+    }
+    if (g_faceCount == MAX_GLYPH_FACES || !rasteriseSize(size)) return NULL;
+
+    const SizeMasks &m  = g_masks[size];
+    uint16_t        *px = (uint16_t *)platformAllocLarge(m.total * sizeof(uint16_t));
+    if (!px) return NULL;
+
+    // Coverage is mostly 0 or 255; only the edges need blending
+    for (uint32_t i = 0; i < m.total; ++i) {
+        uint8_t a = m.coverage[i];
+        px[i] = a == 0 ? bg : a == 255 ? fg : blend565(fg, bg, a);
+    }
+
+    GlyphFace &f = g_faces[g_faceCount++];
+    f.size     = (uint8_t)size;
+    f.fg       = fg;
+    f.bg       = bg;
+    f.height   = m.height;
+    f.baseline = m.baseline;
+    memcpy(f.advance, m.advance, sizeof(f.advance));
+    memcpy(f.offset, m.offset, sizeof(f.offset));
+    f.pixels   = px;
+    return &f;
+}
+
+int glyphIndex(char c)
+{
+    const char *p = c ? strchr(GLYPH_CHARS, c) : NULL;
+    return p ? (int)(p - GLYPH_CHARS) : 0;
+}
+
+int glyphTextWidth(const GlyphFace &f, const char *text)
+{
+    int w = 0;
+    for (; *text; ++text) w += f.advance[glyphIndex(*text)];
+    return w;
+}
+
+int glyphDrawText(Display &gfx, const GlyphFace &f, const char *text, int x, int y)
+{
+    int x0 = x;
+    for (; *text; ++text) {
+        int g = glyphIndex(*text);
+        gfx.pushImage(x, y, f.advance[g], f.height, glyphCell(f, g));
+        x += f.advance[g];
+    }
+    return x - x0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include "platform.h"
+
+// Large anti-aliased text for the live readouts. The built-in GLCD font
+// only scales by pixel doubling and TFT_eSPI's smooth fonts blend every
+// pixel against the background on each draw, too slow to redraw every
+// refresh. Instead each glyph is rasterised once per size from a small
+// stroke font (distance to the stroke -> coverage) and blended once per
+// colour pair into a cell of RGB565 pixels, kept in PSRAM. Drawing a
+// character is then a single pushImage() of its cell: one window and one
+// burst, about what a size-1 GLCD character costs.
+//
+// The set covers what formatMetric() prints: digits, "-.", space and the
+// unit letters. Anything else draws as a blank space cell. Digits share
+// one advance so a changing value doesn't shift the glyphs after it.
+//
+// UI side only.
+
+const char GLYPH_CHARS[] = " -./%0123456789BCbdgmpu";
+const int  GLYPH_COUNT   = sizeof(GLYPH_CHARS) - 1;
+
+// Cell heights (ascent + descent) in px, indexed by size
+const int GLYPH_SIZES = 3;
+const int GLYPH_CELL_H[GLYPH_SIZES] = { 20, 30, 40 };
+
+const int MAX_GLYPH_FACES = 4;   // readouts: normal and alert colour, two sizes
+
+// One size in one fg/bg pair. Cells are `advance[i]` x `height`, row major,
+// at pixels + offset[i].
+struct GlyphFace {
+    uint8_t   size;
+    uint16_t  fg, bg;
+    uint8_t   height;
+    uint8_t   baseline;            // rows above the baseline
+    uint8_t   advance[GLYPH_COUNT];
+    uint32_t  offset[GLYPH_COUNT];
+    uint16_t *pixels;
+};
+
+// Face for `size` drawing `fg` on `bg`, rasterised on first use. NULL if
+// the allocation failed (no PSRAM left) or every face slot is taken.
+const GlyphFace *glyphFace(int size, uint16_t fg, uint16_t bg);
+
+// Index into the face's tables; characters outside the set map to ' '
+int glyphIndex(char c);
+
+inline const uint16_t *glyphCell(const GlyphFace &f, int index)
+{
+    return f.pixels + f.offset[index];
+}
+
+int glyphTextWidth(const GlyphFace &f, const char *text);
+
+// Draws `text` with its top-left at (x, y); returns the width drawn
+int glyphDrawText(Display &gfx, const GlyphFace &f, const char *text, int x, int y);
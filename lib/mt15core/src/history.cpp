@@ -0,0 +1,79 @@
+#include "history.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+int historyUpsert(HistoryRing &h, uint32_t ts)
+{
+    // Search newest-first: merges almost always hit the last bucket or two
+    int i = h.count - 1;
+    while (i >= 0 && historyTs(h, i) > ts) --i;
+    if (i >= 0 && historyTs(h, i) == ts) return i;
+
+    int pos = i + 1;
+    if (h.count == MAX_HISTORY_POINTS) {
+        if (pos == 0) return -1;
+        h.head = (h.head + 1) % MAX_HISTORY_POINTS;
+        h.count--;
+        pos--;
+    }
+
+    if (pos == 0 && h.count > 0) {
+        // Prepend by moving head back: newest-first pages fill an hourly
+        // ring from the end without shifting it each time
+        h.head = (h.head + MAX_HISTORY_POINTS - 1) % MAX_HISTORY_POINTS;
+    } else {
+        // Open a hole at pos (a no-op when appending)
+        for (int k = h.count; k > pos; --k) {
+            int dst = historySlot(h, k);
+            int src = historySlot(h, k - 1);
+            h.startTs[dst] = h.startTs[src];
+            memcpy(h.value[dst], h.value[src], sizeof(h.value[dst]));
+        }
+    }
+
+    int s = historySlot(h, pos);
+    h.startTs[s] = ts;
+    for (int m = 0; m < METRIC_COUNT; ++m) h.value[s][m] = READING_NONE;
+    h.count++;
+    return pos;
+}
+
+void copyHistory(HistoryRing &dst, const HistoryRing &src)
+{
+    for (int i = 0; i < src.count; ++i) {
+        int s = historySlot(src, i);
+        dst.startTs[i] = src.startTs[s];
+        memcpy(dst.value[i], src.value[s], sizeof(dst.value[i]));
+    }
+    dst.head  = 0;
+    dst.count = src.count;
+}
+
+void tsToLabel(uint32_t ts, char mmdd[6])
+{
+    time_t t = ts;
+    struct tm tmv;
+    gmtime_r(&t, &tmv);
+    snprintf(mmdd, 6, "%02u/%02u",
+             (unsigned)(tmv.tm_mon + 1) % 100u, (unsigned)tmv.tm_mday % 100u);
+}
+
+// newlib has no timegm(), so days-from-civil is done by hand.
+uint32_t parseIsoTs(const char *s)
+{
+    int Y, M, D, hh = 0, mm = 0, ss = 0;
+    if (!s || sscanf(s, "%4d-%2d-%2dT%2d:%2d:%2d", &Y, &M, &D, &hh, &mm, &ss) < 3) {
+        return 0;
+    }
+
+    Y -= M <= 2;
+    long era = Y / 400;
+    long yoe = Y - era * 400;
+    long doy = (153 * (M > 2 ? M - 3 : M + 9) + 2) / 5 + D - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long days = era * 146097 + doe - 719468;
+
+    return (uint32_t)(days * 86400L + hh * 3600L + mm * 60L + ss);
+}
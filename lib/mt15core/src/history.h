@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include "metrics.h"
+
+// Bucket length in seconds. Daily by default; build with
+// -DMT15_HISTORY_INTERVAL_S=3600 for hourly (720 buckets, ~13 KB per copy
+// of the ring). The API also offers 900 and 300, RAM permitting.
+#ifndef MT15_HISTORY_INTERVAL_S
+#define MT15_HISTORY_INTERVAL_S 86400
+#endif
+
+const uint32_t HISTORY_INTERVAL_S  = MT15_HISTORY_INTERVAL_S;   // must match &interval
+const uint32_t HISTORY_FULL_SPAN_S = 2592000;                   // 30 days
+
+static_assert(HISTORY_FULL_SPAN_S % HISTORY_INTERVAL_S == 0,
+              "MT15_HISTORY_INTERVAL_S must divide 30 days");
+
+// 30-day history: buckets keyed by start time (unix seconds, UTC), held in
+// a ring so merging the newest bucket is O(1) in the common case. Averages
+// are fixed point (MetricDesc::scale) in 16 bits, READING_NONE for gaps.
+// Logical index 0 is the oldest bucket; see historyTs()/historyValue().
+const int MAX_HISTORY_POINTS = HISTORY_FULL_SPAN_S / HISTORY_INTERVAL_S + 2;   // + partial ends
+
+struct HistoryRing {
+    uint32_t startTs[MAX_HISTORY_POINTS];
+    int16_t  value[MAX_HISTORY_POINTS][METRIC_COUNT];  // bucket averages
+    int      head;    // slot holding the oldest bucket
+    int      count;
+};
+
+inline int historySlot(const HistoryRing &h, int i)
+{
+    return (h.head + i) % MAX_HISTORY_POINTS;
+}
+
+inline uint32_t historyTs(const HistoryRing &h, int i)
+{
+    return h.startTs[historySlot(h, i)];
+}
+
+// NaN for a gap
+inline float historyValue(const HistoryRing &h, int metric, int i)
+{
+    return decodeReading(metric, h.value[historySlot(h, i)][metric]);
+}
+
+// Returns the logical index of bucket `ts`, inserting an empty bucket in
+// time order if it isn't there yet. A full ring drops its oldest bucket to
+// make room; buckets older than everything in a full ring return -1.
+int historyUpsert(HistoryRing &h, uint32_t ts);
+
+// Copies only the buckets in use, oldest first (dst.head ends up 0).
+void copyHistory(HistoryRing &dst, const HistoryRing &src);
+
+// unix seconds (UTC) -> "MM/DD"
+void tsToLabel(uint32_t ts, char mmdd[6]);
+
+// "YYYY-MM-DDTHH:MM:SSZ" -> unix seconds (UTC), 0 if malformed.
+uint32_t parseIsoTs(const char *s);
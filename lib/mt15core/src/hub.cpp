@@ -0,0 +1,169 @@
+#include "hub.h"
+
+#include <string.h>
+
+#include "arena.h"
+#include "meraki_fetch.h"
+#include "platform.h"
+#include "snapshot.h"
+
+HubStats   g_hubStats = {};
+Multicast *g_multicast = NULL;
+
+static const uint8_t HUB_MAGIC[4] = { 'M', 'T', 'H', 'B' };
+
+// One datagram, either way
+static uint8_t g_hubPacket[sizeof(HubPacketHeader) + HUB_CHUNK_BYTES];
+
+// ==== HUB ====
+
+static uint32_t      g_hubId      = 0;
+static uint32_t      g_hubSeq     = 0;
+static bool          g_sentFull   = false;
+static unsigned long g_lastFullAt = 0;
+
+bool hubBroadcast(bool forceFull)
+{
+    if (!g_multicast) return false;
+    if (g_hubId == 0) g_hubId = platformRandom() | 1;
+
+    unsigned long now = platformMillis();
+    bool full = forceFull || !g_sentFull || reached(g_lastFullAt + HUB_FULL_INTERVAL_MS, now);
+
+    ArenaScope scope(g_fetchArena);
+    uint8_t *blob = (uint8_t *)g_fetchArena.alloc(MAX_STATE_CACHE_BYTES);
+    if (!blob) return false;
+    size_t len = encodeStateCache(blob, MAX_STATE_CACHE_BYTES,
+                                  full ? MAX_HISTORY_POINTS : HUB_DELTA_BUCKETS);
+    if (len == 0) return false;
+
+    HubPacketHeader hdr;
+    memcpy(hdr.magic, HUB_MAGIC, sizeof(hdr.magic));
+    hdr.version  = HUB_PROTOCOL_VERSION;
+    hdr.kind     = full ? HUB_MSG_FULL : HUB_MSG_DELTA;
+    hdr.chunks   = (uint8_t)((len + HUB_CHUNK_BYTES - 1) / HUB_CHUNK_BYTES);
+    hdr.hubId    = g_hubId;
+    hdr.seq      = ++g_hubSeq;
+    hdr.totalLen = (uint32_t)len;
+
+    for (int c = 0; c < hdr.chunks; ++c) {
+        size_t off = c * HUB_CHUNK_BYTES;
+        size_t n   = len - off < HUB_CHUNK_BYTES ? len - off : HUB_CHUNK_BYTES;
+        hdr.chunk = (uint8_t)c;
+        memcpy(g_hubPacket, &hdr, sizeof(hdr));
+        memcpy(g_hubPacket + sizeof(hdr), blob + off, n);
+        if (c > 0) platformDelay(HUB_CHUNK_GAP_MS);
+        if (!g_multicast->send(g_hubPacket, sizeof(hdr) + n)) {
+            g_hubStats.sendFailures++;
+            platformLog("[hub] send failed at chunk %d/%d of #%lu\n", c + 1, hdr.chunks,
+                        (unsigned long)hdr.seq);
+            return false;
+        }
+    }
+
+    if (full) {
+        g_sentFull   = true;
+        g_lastFullAt = now;
+    }
+    g_hubStats.sent++;
+    platformLog("[hub] sent %s #%lu: %u bytes in %d datagrams\n", full ? "full" : "delta",
+                (unsigned long)hdr.seq, (unsigned)len, hdr.chunks);
+    return true;
+}
+
+// ==== LISTENER ====
+
+// The message being assembled
+static uint8_t *g_rxBlob    = NULL;   // MAX_STATE_CACHE_BYTES
+static bool     g_rxActive  = false;
+static uint32_t g_rxHubId   = 0;
+static uint32_t g_rxSeq     = 0;
+static uint8_t  g_rxKind    = 0;
+static uint8_t  g_rxChunks  = 0;
+static uint32_t g_rxLen     = 0;
+static uint32_t g_rxHave[(HUB_MAX_CHUNKS + 31) / 32];   // bit per chunk received
+static int      g_rxGot     = 0;
+static bool     g_rxDone    = false;  // installed (or rejected); ignore repeats
+
+bool hubListenInit()
+{
+    if (!g_rxBlob) g_rxBlob = (uint8_t *)platformAllocLarge(MAX_STATE_CACHE_BYTES);
+    if (!g_rxBlob) platformLog("[hub] reassembly buffer alloc failed\n");
+    return g_rxBlob != NULL;
+}
+
+// Checks one datagram and files its chunk. True once it completes a
+// message that decoded and was installed.
+static bool acceptPacket(const uint8_t *pkt, size_t len)
+{
+    HubPacketHeader hdr;
+    if (len < sizeof(hdr)) return false;
+    memcpy(&hdr, pkt, sizeof(hdr));
+    if (memcmp(hdr.magic, HUB_MAGIC, sizeof(hdr.magic)) != 0) return false;   // not ours
+
+    size_t payload = len - sizeof(hdr);
+    size_t expect  = hdr.chunk + 1 < hdr.chunks ? HUB_CHUNK_BYTES
+                                                : hdr.totalLen - (size_t)hdr.chunk * HUB_CHUNK_BYTES;
+    if (hdr.version != HUB_PROTOCOL_VERSION || hdr.chunks == 0 || hdr.chunks > HUB_MAX_CHUNKS ||
+        hdr.chunk >= hdr.chunks || hdr.totalLen > MAX_STATE_CACHE_BYTES ||
+        hdr.totalLen <= (size_t)(hdr.chunks - 1) * HUB_CHUNK_BYTES || payload != expect) {
+        g_hubStats.rejected++;
+        return false;
+    }
+
+    bool same = g_rxActive && hdr.hubId == g_rxHubId && hdr.seq == g_rxSeq;
+    if (!same) {
+        if (g_rxActive && hdr.hubId == g_rxHubId && (int32_t)(hdr.seq - g_rxSeq) < 0) {
+            return false;   // late chunk of an older message
+        }
+        if (g_rxActive && !g_rxDone) g_hubStats.incomplete++;
+        g_rxActive = true;
+        g_rxDone   = false;
+        g_rxHubId  = hdr.hubId;
+        g_rxSeq    = hdr.seq;
+        g_rxKind   = hdr.kind;
+        g_rxChunks = hdr.chunks;
+        g_rxLen    = hdr.totalLen;
+        g_rxGot    = 0;
+        memset(g_rxHave, 0, sizeof(g_rxHave));
+    } else if (g_rxDone || hdr.chunks != g_rxChunks || hdr.totalLen != g_rxLen) {
+        return false;
+    }
+
+    uint32_t bit = 1u << (hdr.chunk & 31);
+    if (g_rxHave[hdr.chunk >> 5] & bit) return false;   // repeat
+    memcpy(g_rxBlob + (size_t)hdr.chunk * HUB_CHUNK_BYTES, pkt + sizeof(hdr), payload);
+    g_rxHave[hdr.chunk >> 5] |= bit;
+    if (++g_rxGot < g_rxChunks) return false;
+
+    g_rxDone = true;
+    if (!decodeStateCache(g_rxBlob, g_rxLen, g_rxKind == HUB_MSG_DELTA)) {
+        g_hubStats.rejected++;
+        platformLog("[hub] #%lu from %08lx didn't decode\n", (unsigned long)g_rxSeq,
+                    (unsigned long)g_rxHubId);
+        return false;
+    }
+    g_stateFromCache = false;
+    g_hubStats.installed++;
+    platformLog("[hub] installed %s #%lu: %lu bytes, %d buckets, %d sensors\n",
+                g_rxKind == HUB_MSG_DELTA ? "delta" : "full", (unsigned long)g_rxSeq,
+                (unsigned long)g_rxLen, g_history.count, g_sensors.count);
+    return true;
+}
+
+HubReceive hubReceive(unsigned long timeoutMs)
+{
+    if (!g_multicast || !g_rxBlob) return HUB_RX_ERROR;
+
+    unsigned long start = platformMillis();
+    for (;;) {
+        unsigned long waited = platformMillis() - start;
+        if (waited >= timeoutMs) return HUB_RX_TIMEOUT;
+
+        int n = g_multicast->receive(g_hubPacket, sizeof(g_hubPacket), timeoutMs - waited);
+        if (n < 0) return HUB_RX_ERROR;
+        if (n == 0) continue;
+        g_hubStats.packets++;
+        if (acceptPacket(g_hubPacket, (size_t)n)) return HUB_RX_INSTALLED;
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "platform.h"
+#include "state_cache.h"
+
+// Hub mode: one poller per site. The hub (one display, or mt15_hub on a
+// Linux box) runs the usual fetch pipeline and multicasts the working
+// state after every refresh; listeners install what arrives instead of
+// fetching, so they never open a TLS connection and the org's API load
+// stays that of one display however many screens there are.
+//
+// Messages are state-cache blobs (state_cache.h: versioned, CRC-checked):
+//   full    everything; every HUB_FULL_INTERVAL_MS and after a full
+//           history fetch, so late joiners and listeners that lost a
+//           datagram catch up
+//   delta   latest readings and the overview, but only the newest
+//           HUB_DELTA_BUCKETS history buckets, merged on arrival
+// Each is split into datagrams of up to HUB_CHUNK_BYTES behind a
+// HubPacketHeader. A listener assembles one message at a time and drops it
+// if a chunk goes missing: the next refresh brings another.
+
+enum HubRole {
+    HUB_OFF    = 0,   // fetch from the API, send nothing
+    HUB_SEND   = 1,   // fetch from the API and multicast
+    HUB_LISTEN = 2    // take everything from the hub
+};
+
+enum HubReceive {
+    HUB_RX_TIMEOUT   = 0,   // nothing complete within the timeout
+    HUB_RX_INSTALLED = 1,   // a message is now in the working state
+    HUB_RX_ERROR     = 2    // socket error (or not set up): rejoin, then call again
+};
+
+enum HubMessage {
+    HUB_MSG_FULL  = 1,
+    HUB_MSG_DELTA = 2
+};
+
+const uint8_t       HUB_PROTOCOL_VERSION = 1;
+const size_t        HUB_CHUNK_BYTES      = 1200;   // + headers, well inside a 1500 MTU
+const unsigned long HUB_CHUNK_GAP_MS     = 2;      // lets the WiFi driver drain between them
+const int           HUB_DELTA_BUCKETS    = 2;      // what an incremental history refresh touches
+const unsigned long HUB_FULL_INTERVAL_MS = 5 * 60 * 1000UL;
+
+const int HUB_MAX_CHUNKS = (int)((MAX_STATE_CACHE_BYTES + HUB_CHUNK_BYTES - 1) / HUB_CHUNK_BYTES);
+static_assert(HUB_MAX_CHUNKS <= 255, "chunk numbers are 8 bits");
+
+// Administratively scoped group; sent with TTL 1, so it stays on the subnet
+const char     HUB_GROUP[] = "239.255.77.15";
+const uint16_t HUB_PORT    = 5015;
+
+struct HubPacketHeader {
+    uint8_t  magic[4];   // "MTHB"
+    uint8_t  version;    // HUB_PROTOCOL_VERSION
+    uint8_t  kind;       // HubMessage
+    uint8_t  chunk;
+    uint8_t  chunks;
+    uint32_t hubId;      // random per hub boot: a restarted hub's seq starts over
+    uint32_t seq;        // message number
+    uint32_t totalLen;   // blob bytes over all chunks
+};
+
+struct HubStats {
+    uint32_t sent, sendFailures;              // hub: messages
+    uint32_t packets, installed;              // listener
+    uint32_t incomplete, rejected;           // lost a chunk / bad header or blob
+};
+
+extern HubStats   g_hubStats;   // fetch side
+extern Multicast *g_multicast;  // set up by the platform before either call
+
+// Hub, fetch side after each refresh: multicasts the working state, full
+// or delta per the rules above (`forceFull` after a full history fetch).
+bool hubBroadcast(bool forceFull = false);
+
+// Listener: allocates the reassembly buffer (platformAllocLarge(), once).
+bool hubListenInit();
+
+// Listener, fetch side: waits up to `timeoutMs` for datagrams and returns
+// HUB_RX_INSTALLED as soon as a complete message has been installed in the
+// working state. A socket error returns at once, so the caller must back
+// off before rejoining rather than call straight back in.
+HubReceive hubReceive(unsigned long timeoutMs);
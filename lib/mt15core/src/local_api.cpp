@@ -0,0 +1,496 @@
+#include "local_api.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <atomic>
+
+#include "meraki_http.h"
+#include "platform.h"
+#include "snapshot.h"
+#include "state_cache.h"
+#include "ui.h"
+
+// ==== BODY BUFFERS ====
+
+// One endpoint's bodies: the same SPSC triple buffer as the snapshots, with
+// the fetch task filling `back` and the server task reading `front`.
+struct BodyBuffer {
+    char                 *buf[3];
+    uint32_t              len[3];
+    uint32_t              etag[3];
+    size_t                size;
+    std::atomic<uint32_t> middle;   // buffer index | BODY_FRESH
+    uint32_t              back;     // fetch side only
+    uint32_t              front;    // server only
+    uint32_t              key;      // content hash of what was last built
+    bool                  built;
+};
+
+static const uint32_t BODY_FRESH = 0x80;
+
+static BodyBuffer g_apiLatest;
+static BodyBuffer g_apiHistory;
+static BodyBuffer g_apiArchive;   // size 0 if it couldn't be allocated
+static bool       g_apiReady = false;
+
+static bool initBody(BodyBuffer &b, size_t size)
+{
+    for (int i = 0; i < 3; ++i) {
+        b.buf[i] = (char *)platformAllocLarge(size);
+        if (!b.buf[i]) return false;
+        b.len[i]  = 0;
+        b.etag[i] = 0;
+    }
+    b.size  = size;
+    b.middle.store(1);
+    b.back  = 0;
+    b.front = 2;
+    b.built = false;
+    return true;
+}
+
+static void publishBody(BodyBuffer &b)
+{
+    uint32_t prev = b.middle.exchange(b.back | BODY_FRESH, std::memory_order_acq_rel);
+    b.back = prev & ~BODY_FRESH;
+}
+
+static void acquireBody(BodyBuffer &b)
+{
+    if (!(b.middle.load(std::memory_order_acquire) & BODY_FRESH)) return;
+    uint32_t prev = b.middle.exchange(b.front, std::memory_order_acq_rel);
+    b.front = prev & ~BODY_FRESH;
+}
+
+bool localApiInit()
+{
+    if (g_apiReady) return true;
+    if (!initBody(g_apiLatest, LOCAL_API_LATEST_BYTES) ||
+        !initBody(g_apiHistory, LOCAL_API_HISTORY_BYTES)) {
+        platformLog("[api] body buffers alloc failed, local API off\n");
+        return false;
+    }
+    if (!initBody(g_apiArchive, LOCAL_API_ARCHIVE_BYTES)) {
+        g_apiArchive.size = 0;
+        platformLog("[api] archive body alloc failed, /history?span=90d off\n");
+    }
+    g_apiReady = true;
+    return true;
+}
+
+// ==== JSON WRITER ====
+
+struct BodyWriter {
+    char  *buf;
+    size_t size;
+    size_t len;
+    bool   full;
+};
+
+static void put(BodyWriter &w, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void put(BodyWriter &w, const char *fmt, ...)
+{
+    if (w.full) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(w.buf + w.len, w.size - w.len, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= w.size - w.len) {
+        w.full = true;
+        return;
+    }
+    w.len += n;
+}
+
+// Quoted and escaped; control characters are dropped
+static void putString(BodyWriter &w, const char *s)
+{
+    put(w, "\"");
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') put(w, "\\%c", *s);
+        else if ((uint8_t)*s >= 0x20) put(w, "%c", *s);
+    }
+    put(w, "\"");
+}
+
+// Decimals the metric's fixed point keeps (scale 100 -> 2)
+static int metricDecimals(int metric)
+{
+    return (int)lroundf(log10f(METRICS[metric].scale));
+}
+
+static void putValue(BodyWriter &w, int metric, double v)
+{
+    if (isnan(v) || fabs(v) > 1e9) put(w, "null");
+    else                           put(w, "%.*f", metricDecimals(metric), v);
+}
+
+static void putMetricNames(BodyWriter &w)
+{
+    put(w, "\"metrics\":[");
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        if (m) put(w, ",");
+        putString(w, METRICS[m].name);
+    }
+    put(w, "]");
+}
+
+// ==== BODIES ====
+
+static uint32_t latestKey()
+{
+    const SensorStore &s = g_sensors;
+    uint32_t h = contentHash(g_latest, sizeof(g_latest), g_stateFromCache);
+    h = contentHash(&g_analytics, sizeof(g_analytics), h);
+    h = contentHash(&s.count, sizeof(s.count), h);
+    h = contentHash(s.networkName, s.networkCount * sizeof(s.networkName[0]), h);
+    h = contentHash(s.serial, s.count * sizeof(s.serial[0]), h);
+    h = contentHash(s.network, s.count * sizeof(s.network[0]), h);
+    h = contentHash(s.ts, s.count * sizeof(s.ts[0]), h);
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        h = contentHash(s.reading[m], s.count * sizeof(s.reading[m][0]), h);
+    }
+    return h;
+}
+
+static void writeLatest(BodyWriter &w)
+{
+    const SensorStore &s = g_sensors;
+
+    put(w, "{\"serial\":");
+    putString(w, g_merakiConfig.serial ? g_merakiConfig.serial : "");
+    put(w, ",\"fromCache\":%s,", g_stateFromCache ? "true" : "false");
+    putMetricNames(w);
+
+    put(w, ",\"units\":[");
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        if (m) put(w, ",");
+        putString(w, METRICS[m].unit);
+    }
+    put(w, "],\"latest\":[");
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        if (m) put(w, ",");
+        putValue(w, m, g_latest[m]);
+    }
+
+    put(w, "],\"stats\":[");
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        const MetricStats &st = g_analytics.stats[m];
+        put(w, m ? ",[" : "[");
+        putValue(w, m, st.ewma);
+        put(w, ",");
+        putValue(w, m, st.min);
+        put(w, ",");
+        putValue(w, m, st.max);
+        put(w, ",");
+        putValue(w, m, st.mean);
+        put(w, ",");
+        putValue(w, m, st.ratePerHour);
+        put(w, "]");
+    }
+
+    put(w, "],\"alerts\":[");
+    bool first = true;
+    for (int r = 0; r < ALERT_RULE_COUNT; ++r) {
+        if (!(g_analytics.alertMask & (1u << r))) continue;
+        put(w, first ? "{\"text\":" : ",{\"text\":");
+        putString(w, ALERT_RULES[r].text);
+        put(w, ",\"metric\":");
+        putString(w, METRICS[ALERT_RULES[r].metric].name);
+        put(w, ",\"since\":%lu}", (unsigned long)g_analytics.alertSince[r]);
+        first = false;
+    }
+
+    put(w, "],\"networks\":[");
+    for (int n = 0; n < s.networkCount; ++n) {
+        if (n) put(w, ",");
+        putString(w, s.networkName[n]);
+    }
+
+    put(w, "],\"sensors\":[");
+    for (int i = 0; i < s.count; ++i) {
+        put(w, i ? ",[" : "[");
+        putString(w, s.serial[i]);
+        if (s.network[i] == NETWORK_NONE) put(w, ",null");
+        else                              put(w, ",%u", (unsigned)s.network[i]);
+        put(w, ",%lu", (unsigned long)s.ts[i]);
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            put(w, ",");
+            putValue(w, m, sensorReading(s, m, i));
+        }
+        put(w, "]");
+    }
+    put(w, "]}");
+}
+
+static uint32_t historyKey()
+{
+    const HistoryRing &h = g_history;
+    uint32_t key = contentHash(&h.count, sizeof(h.count));
+    for (int i = 0; i < h.count; ++i) {
+        int slot = historySlot(h, i);
+        key = contentHash(&h.startTs[slot], sizeof(h.startTs[slot]), key);
+        key = contentHash(h.value[slot], sizeof(h.value[slot]), key);
+    }
+    return key;
+}
+
+static void writeHistory(BodyWriter &w)
+{
+    const HistoryRing &h = g_history;
+
+    put(w, "{\"interval\":%lu,", (unsigned long)HISTORY_INTERVAL_S);
+    putMetricNames(w);
+    put(w, ",\"buckets\":[");
+    for (int i = 0; i < h.count; ++i) {
+        put(w, i ? ",[%lu" : "[%lu", (unsigned long)historyTs(h, i));
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            put(w, ",");
+            putValue(w, m, historyValue(h, m, i));
+        }
+        put(w, "]");
+    }
+    put(w, "]}");
+}
+
+// The body only changes once an hour: an append mostly lands in the
+// newest bucket, which is left out until it is complete
+static uint32_t archiveKey()
+{
+    uint32_t bucket = g_archive.lastTs / LOCAL_API_ARCHIVE_INTERVAL_S;
+    return contentHash(&bucket, sizeof(bucket));
+}
+
+static void putArchiveBucket(BodyWriter &w, uint32_t ts, const int32_t sum[METRIC_COUNT],
+                             const int n[METRIC_COUNT], bool first)
+{
+    put(w, first ? "[%lu" : ",[%lu", (unsigned long)ts);
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        put(w, ",");
+        putValue(w, m, n[m] ? (double)sum[m] / n[m] / METRICS[m].scale : NAN);
+    }
+    put(w, "]");
+}
+
+// The ARCHIVE_SPAN_S of the archive up to its newest complete bucket,
+// averaged per LOCAL_API_ARCHIVE_INTERVAL_S. Every point is in every
+// stream, so one cursor per metric, seeked to the same point, stays in
+// step; only the first decodes timestamps.
+static void writeArchive(BodyWriter &w)
+{
+    const uint32_t interval = LOCAL_API_ARCHIVE_INTERVAL_S;
+
+    put(w, "{\"interval\":%lu,", (unsigned long)interval);
+    putMetricNames(w);
+    put(w, ",\"buckets\":[");
+
+    uint32_t newest = g_archive.lastTs - g_archive.lastTs % interval;   // still filling
+    uint32_t from   = newest > ARCHIVE_SPAN_S ? newest - ARCHIVE_SPAN_S : 0;
+    SeriesCursor c[METRIC_COUNT];
+    for (int m = 0; m < METRIC_COUNT; ++m) seriesSeek(g_archive, m, from, c[m]);
+
+    int32_t  sum[METRIC_COUNT];
+    int      n[METRIC_COUNT];
+    uint32_t bucket = 0;
+    bool     first  = true;
+    uint32_t ts;
+    int16_t  v[METRIC_COUNT];
+    while (seriesNext(c[0], ts, v[0]) && ts < newest) {
+        for (int m = 1; m < METRIC_COUNT; ++m) seriesNextValue(c[m], v[m]);
+
+        uint32_t b = ts - ts % interval;
+        if (b != bucket) {
+            if (bucket) {
+                putArchiveBucket(w, bucket, sum, n, first);
+                first = false;
+            }
+            bucket = b;
+            memset(sum, 0, sizeof(sum));
+            memset(n, 0, sizeof(n));
+        }
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            if (v[m] == READING_NONE) continue;
+            sum[m] += v[m];
+            n[m]++;
+        }
+    }
+    if (bucket) putArchiveBucket(w, bucket, sum, n, first);
+    put(w, "]}");
+}
+
+// Rebuilds `b` into its back buffer if `key` moved, then publishes it
+static void rebuildBody(BodyBuffer &b, uint32_t key, void (*write)(BodyWriter &),
+                        const char *name)
+{
+    if (b.built && b.key == key) return;
+
+    unsigned long t0 = platformMicros();
+    BodyWriter w = { b.buf[b.back], b.size, 0, false };
+    write(w);
+    if (w.full) {
+        // Sized for the worst case, so this is a bug; keep serving the old one
+        platformLog("[api] %s body over %u bytes, not published\n", name, (unsigned)b.size);
+        return;
+    }
+    b.len[b.back]  = (uint32_t)w.len;
+    b.etag[b.back] = key;
+    b.key   = key;
+    b.built = true;
+    publishBody(b);
+    platformLog("[api] %s rebuilt: %u bytes in %lu us\n", name, (unsigned)w.len,
+                platformMicros() - t0);
+}
+
+void localApiPublish()
+{
+    if (!g_apiReady) return;
+    rebuildBody(g_apiLatest, latestKey(), writeLatest, "/latest");
+    rebuildBody(g_apiHistory, historyKey(), writeHistory, "/history");
+    if (g_apiArchive.size) {
+        rebuildBody(g_apiArchive, archiveKey(), writeArchive, "/history?span=90d");
+    }
+}
+
+// ==== REQUESTS ====
+
+static void plainResponse(LocalApiResponse &res, int status, const char *text)
+{
+    res.status   = status;
+    res.body     = text;
+    res.len      = strlen(text);
+    res.json     = false;
+    res.sendBody = true;
+    res.etag     = 0;
+}
+
+// Value of query parameter `name` in `query` (up to the first space),
+// copied into `out`; false if absent
+static bool findParam(const char *query, const char *name, char *out, size_t size)
+{
+    size_t nameLen = strlen(name);
+    for (const char *p = query; *p && *p != ' '; ) {
+        size_t n = strcspn(p, "& ");
+        if (n > nameLen && strncmp(p, name, nameLen) == 0 && p[nameLen] == '=') {
+            size_t len = n - nameLen - 1;
+            if (len >= size) len = size - 1;
+            memcpy(out, p + nameLen + 1, len);
+            out[len] = '\0';
+            return true;
+        }
+        p += n;
+        if (*p == '&') ++p;
+    }
+    return false;
+}
+
+// Value of header `name` in `head` (case-insensitive), copied into `out`;
+// false if absent
+static bool findHeader(const char *head, const char *name, char *out, size_t size)
+{
+    size_t nameLen = strlen(name);
+    for (const char *line = strstr(head, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, name, nameLen) != 0 || line[nameLen] != ':') continue;
+        const char *v = line + nameLen + 1;
+        while (*v == ' ' || *v == '\t') ++v;
+        size_t n = strcspn(v, "\r\n");
+        if (n >= size) n = size - 1;
+        memcpy(out, v, n);
+        out[n] = '\0';
+        return true;
+    }
+    return false;
+}
+
+void localApiHandle(const char *head, LocalApiResponse &res)
+{
+    if (!strstr(head, "\r\n\r\n")) {
+        plainResponse(res, 431, "request head too large\n");
+        return;
+    }
+
+    bool isHead = strncmp(head, "HEAD ", 5) == 0;
+    if (!isHead && strncmp(head, "GET ", 4) != 0) {
+        plainResponse(res, 405, "GET or HEAD only\n");
+        return;
+    }
+    const char *path = head + (isHead ? 5 : 4);
+    size_t pathLen = strcspn(path, " ?");
+
+    const char *query = path[pathLen] == '?' ? path + pathLen + 1 : "";
+
+    BodyBuffer *b = NULL;
+    if (pathLen == 7 && strncmp(path, "/latest", 7) == 0) {
+        b = &g_apiLatest;
+    } else if (pathLen == 8 && strncmp(path, "/history", 8) == 0) {
+        char span[8];
+        if      (!findParam(query, "span", span, sizeof(span))) b = &g_apiHistory;
+        else if (strcmp(span, "30d") == 0)                     b = &g_apiHistory;
+        else if (strcmp(span, "90d") == 0)                     b = &g_apiArchive;
+    }
+    if (!b) {
+        plainResponse(res, 404, "try /latest, /history or /history?span=90d\n");
+        return;
+    }
+    if (!g_apiReady || !b->size) {
+        plainResponse(res, 503, "no data yet\n");
+        return;
+    }
+
+    acquireBody(*b);
+    uint32_t f = b->front;
+    if (b->len[f] == 0) {
+        plainResponse(res, 503, "no data yet\n");
+        return;
+    }
+
+    res.status   = 200;
+    res.body     = b->buf[f];
+    res.len      = b->len[f];
+    res.json     = true;
+    res.sendBody = !isHead;
+    res.etag     = b->etag[f];
+
+    char tag[16], want[24];
+    snprintf(tag, sizeof(tag), "\"%08lx\"", (unsigned long)res.etag);
+    if (findHeader(head, "If-None-Match", want, sizeof(want)) && strcmp(want, tag) == 0) {
+        res.status   = 304;
+        res.sendBody = false;
+    }
+}
+
+static const char *statusText(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 304: return "Not Modified";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 431: return "Request Header Fields Too Large";
+    default:  return "Service Unavailable";
+    }
+}
+
+size_t localApiFormatHead(const LocalApiResponse &res, char *buf, size_t size)
+{
+    char etag[32] = "";
+    if (res.status == 200 || res.status == 304) {
+        snprintf(etag, sizeof(etag), "ETag: \"%08lx\"\r\n", (unsigned long)res.etag);
+    }
+    int n = snprintf(buf, size,
+                     "HTTP/1.1 %d %s\r\n"
+                     "Content-Type: %s\r\n"
+                     "Content-Length: %u\r\n"
+                     "%s"
+                     "Cache-Control: no-cache\r\n"
+                     "Access-Control-Allow-Origin: *\r\n"
+                     "Connection: close\r\n\r\n",
+                     res.status, statusText(res.status),
+                     res.json ? "application/json" : "text/plain",
+                     (unsigned)(res.status == 304 ? 0 : res.len), etag);
+    return n < 0 || (size_t)n >= size ? 0 : (size_t)n;
+}
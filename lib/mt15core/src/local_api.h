@@ -0,0 +1,79 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "analytics.h"
+#include "archive.h"
+#include "history.h"
+#include "sensor_store.h"
+
+// Local read-only HTTP/JSON API, so other consumers at the site (more
+// displays, BMS scripts, tablets) read this display's data instead of
+// spending the org's Meraki quota:
+//
+//   GET /latest    {"serial":..,"fromCache":..,"metrics":[names],
+//                   "units":[..],"latest":[one per metric],
+//                   "stats":[[ewma,min,max,mean,rate per hour],..],
+//                   "alerts":[{"text":..,"metric":name,"since":ts},..],
+//                   "networks":[names],
+//                   "sensors":[[serial,network index|null,ts,values...],..]}
+//   GET /history   {"interval":s,"metrics":[names],
+//                   "buckets":[[start ts,averages...],..]}   oldest first
+//   GET /history?span=90d
+//                  the same from the 90-day archive (archive.h), its
+//                  5-minute points averaged per LOCAL_API_ARCHIVE_INTERVAL_S,
+//                  complete buckets only (so it changes once per bucket);
+//                  span=30d is plain /history
+//
+// Values are in metric order, null where there's no reading. All bodies
+// are built by the fetch task when what they show changes, never per
+// request; responses carry an ETag (the content hash) and answer a
+// matching If-None-Match with 304.
+//
+// Each body lives in its own triple buffer like the snapshots (the fetch
+// task writes, the server task reads), so serving never waits on a fetch.
+
+// Worst case with every value at full width (int16 fixed point: 7 chars
+// plus a comma) and every name escaped
+const size_t LOCAL_API_LATEST_BYTES =
+    1024 + METRIC_COUNT * 5 * 8 + MAX_ALERT_RULES * 80 + MAX_NETWORKS * (2 * NETWORK_NAME_LEN + 3) +
+    MAX_SENSORS * (2 * SERIAL_LEN + 20 + METRIC_COUNT * 8);
+const size_t LOCAL_API_HISTORY_BYTES =
+    512 + MAX_HISTORY_POINTS * (14 + METRIC_COUNT * 8);
+
+// Hourly keeps the archive body near 150 KB; every 5-minute point would be
+// ~1.6 MB, three times over
+const uint32_t LOCAL_API_ARCHIVE_INTERVAL_S = 3600;
+const size_t   LOCAL_API_ARCHIVE_BYTES =
+    512 + (ARCHIVE_SPAN_S / LOCAL_API_ARCHIVE_INTERVAL_S) * (14 + METRIC_COUNT * 8);
+
+// Request heads past this are answered 431 (firmware read buffer size)
+const size_t LOCAL_API_HEAD_BYTES = 1024;
+
+// Allocates the body buffers (3 x each size above, once, via
+// platformAllocLarge()). Until it succeeds the rest is a no-op and every
+// request gets a 503. Without room for the archive's, only
+// /history?span=90d does.
+bool localApiInit();
+
+// Fetch side: rebuilds whichever body's data changed since the last call,
+// from the fetch-side working state (g_latest, g_sensors, g_history,
+// g_archive), and hands it to the server.
+void localApiPublish();
+
+struct LocalApiResponse {
+    int         status;       // 200, 304, 404, 405, 431, 503
+    const char *body;         // JSON, or a short plain-text error
+    size_t      len;
+    bool        json;
+    bool        sendBody;     // false for HEAD and 304
+    uint32_t    etag;         // 200 / 304 only
+};
+
+// Server side: answers one request head (request line and headers, up to
+// the blank line), picking up freshly published bodies first. `body`
+// stays valid until the next call.
+void localApiHandle(const char *head, LocalApiResponse &res);
+
+// Status line and headers for `res`, through the blank line. Returns the
+// length written, or 0 if `size` is too small.
+size_t localApiFormatHead(const LocalApiResponse &res, char *buf, size_t size);
@@ -0,0 +1,495 @@
+#include "meraki_fetch.h"
+
+#include <ArduinoJson.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analytics.h"
+#include "archive.h"
+#include "meraki_http.h"
+#include "snapshot.h"
+#include "state_cache.h"
+
+bool          g_historyNeedsFull = true;
+unsigned long g_lastHistoryOk    = 0;
+
+// ==== FETCH ARENA ====
+
+const size_t METRIC_FILTER_CAPACITY = 768;    // every metric path; sized for 64-bit hosts
+const size_t LATEST_DOC_CAPACITY    = 2048;   // one sensor's filtered readings
+const size_t HISTORY_ITEM_CAPACITY  = 384;    // one metric's {min,max,average}
+const size_t LATEST_PATH_LEN        = 1536;   // serial lists make it long
+
+// What each user holds at its peak
+const size_t LATEST_ARENA_BYTES = arenaBytes(
+    sizeof(SensorStore) + LATEST_PATH_LEN + METRIC_FILTER_CAPACITY + LATEST_DOC_CAPACITY, 4);
+const size_t HISTORY_ARENA_BYTES = arenaBytes(
+    sizeof(HistoryWindow) + sizeof(g_linkNext) + METRIC_FILTER_CAPACITY + HISTORY_ITEM_CAPACITY, 4);
+const size_t FETCH_JOB_ARENA_BYTES =
+    LATEST_ARENA_BYTES > HISTORY_ARENA_BYTES ? LATEST_ARENA_BYTES : HISTORY_ARENA_BYTES;
+const size_t FETCH_ARENA_BYTES =
+    FETCH_JOB_ARENA_BYTES > STATE_CACHE_ARENA_BYTES ? FETCH_JOB_ARENA_BYTES : STATE_CACHE_ARENA_BYTES;
+
+alignas(ARENA_ALIGN) static uint8_t g_fetchArenaBuf[FETCH_ARENA_BYTES];
+Arena g_fetchArena(g_fetchArenaBuf, sizeof(g_fetchArenaBuf));
+
+// ArduinoJson allocator over the arena. Documents give their pool back
+// with the enclosing ArenaScope, so deallocate() has nothing to do.
+struct ArenaJsonAllocator {
+    void *allocate(size_t size) { return g_fetchArena.alloc(size); }
+    void  deallocate(void *) {}
+    void *reallocate(void *, size_t) { return NULL; }   // no shrinkToFit()
+};
+typedef BasicJsonDocument<ArenaJsonAllocator> ArenaJsonDocument;
+
+// The byInterval endpoints return a flat array of buckets. Rather than
+// materialise the whole array, we skip to the '[' and deserialize one
+// bucket at a time into a small document, so memory use is bounded by the
+// size of a single (filtered) bucket no matter how many the API sends.
+//
+// Usage:
+//   JsonArrayReader in(body);
+//   bool empty;
+//   if (!openJsonArray(in, empty)) ...
+//   if (empty) ...   // "[]": zero entries, not a parse error
+//   do { deserializeJson(doc, in, filter); ... } while (nextJsonArrayItem(in));
+
+// One byte of lookahead over a body, so openJsonArray() can see whether
+// the first item or the closing ']' follows the '[' without consuming it
+class JsonArrayReader : public ByteReader {
+public:
+    explicit JsonArrayReader(ByteReader &in) : _in(in), _next(NONE) {}
+
+    int read()
+    {
+        if (_next == NONE) return _in.read();
+        int c = _next;
+        _next = NONE;
+        return c;
+    }
+
+    int peek()
+    {
+        if (_next == NONE) _next = _in.read();
+        return _next;
+    }
+
+private:
+    static const int NONE = -2;   // read() itself returns -1 at the end
+    ByteReader &_in;
+    int         _next;
+};
+
+static bool openJsonArray(JsonArrayReader &body, bool &empty)
+{
+    int c;
+    while ((c = body.read()) >= 0) {
+        if (c != '[') continue;
+        while ((c = body.peek()) == ' ' || c == '\t' || c == '\r' || c == '\n') body.read();
+        empty = c == ']';
+        if (empty) body.read();
+        return true;
+    }
+    return false;
+}
+
+static bool nextJsonArrayItem(JsonArrayReader &body)
+{
+    int c;
+    while ((c = body.read()) >= 0) {
+        if (c == ',') return true;
+        if (c == ']') return false;
+    }
+    return false;
+}
+
+// ==== METRIC PATHS ====
+
+// The value for `metric` inside a reading, following its descriptor's path
+static JsonVariantConst metricValue(JsonVariantConst reading, int metric)
+{
+    const MetricDesc &d = METRICS[metric];
+    for (int k = 0; k < MAX_METRIC_PATH && d.path[k]; ++k) reading = reading[d.path[k]];
+    return reading;
+}
+
+// Adds every metric's path to a deserialization filter. The leaf keeps its
+// whole subtree, so history averages come through as {average,...}.
+static void addMetricFilters(JsonObject filter)
+{
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        const MetricDesc &d = METRICS[m];
+        JsonObject node = filter;
+        int k = 0;
+        for (; k + 1 < MAX_METRIC_PATH && d.path[k + 1]; ++k) {
+            node = node.containsKey(d.path[k]) ? node[d.path[k]].as<JsonObject>()
+                                               : node.createNestedObject(d.path[k]);
+        }
+        node[d.path[k]] = true;
+    }
+}
+
+// ==== LATEST ====
+
+// True if `serial` is one of the comma-separated entries in `list`
+static bool serialListed(const char *list, const char *serial)
+{
+    size_t n = strlen(serial);
+    for (const char *p = list; *p; ) {
+        while (*p == ' ' || *p == ',') ++p;
+        const char *end = p;
+        while (*end && *end != ',' && *end != ' ') ++end;
+        if ((size_t)(end - p) == n && strncmp(p, serial, n) == 0) return true;
+        p = end;
+    }
+    return false;
+}
+
+bool parseLatest(ByteReader &body, SensorStore &store, const char *only)
+{
+    ArenaScope scope(g_fetchArena);
+
+    // Filter: keep only what the overview shows
+    ArenaJsonDocument filter(METRIC_FILTER_CAPACITY);
+    filter["serial"]          = true;
+    filter["network"]["name"] = true;
+    JsonObject r = filter["readings"].createNestedObject();
+    r["ts"]     = true;
+    r["metric"] = true;
+    addMetricFilters(r);
+
+    JsonArrayReader in(body);
+    bool empty;
+    if (!openJsonArray(in, empty)) {
+        platformLog("Root is not array\n");
+        return false;
+    }
+    if (empty) return true;   // no sensors reporting
+
+    // One sensor at a time, so the document only ever holds one sensor's
+    // readings however many the org has
+    ArenaJsonDocument doc(LATEST_DOC_CAPACITY);
+    DeserializationError err;
+    do {
+        err = deserializeJson(doc, in, DeserializationOption::Filter(filter));
+        if (err) break;
+
+        const char *serial = doc["serial"] | "";
+        if (!*serial) continue;   // also what "[]" deserializes to
+        if (only && *only && !serialListed(only, serial) &&
+            strcmp(serial, g_merakiConfig.serial) != 0) {
+            continue;
+        }
+
+        int i = sensorFind(store, serial);
+        if (i < 0) i = sensorAdd(store, serial, doc["network"]["name"] | "");
+        if (i < 0) continue;      // store full
+
+        for (JsonObject r : doc["readings"].as<JsonArray>()) {
+            int metric = metricFromName(r["metric"] | "");
+            if (metric == METRIC_COUNT) continue;
+            JsonVariantConst v = metricValue(r, metric);
+            store.reading[metric][i] = encodeReading(metric, v.is<double>() ? v.as<double>() : NAN);
+
+            uint32_t ts = parseIsoTs(r["ts"] | "");
+            if (ts > store.ts[i]) store.ts[i] = ts;
+        }
+    } while (nextJsonArrayItem(in));
+
+    if (err) {
+        platformLog("JSON parse error: %s\n", err.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Latest-readings path for the configured sensors. The serial list goes in
+// the query when it fits; otherwise we ask for the whole org and filter
+// while parsing (`filterLocally`).
+static void latestPath(char *path, size_t size, bool &filterLocally)
+{
+    const MerakiConfig &cfg = g_merakiConfig;
+    int len = snprintf(path, size,
+                       "/api/v1/organizations/%s/sensor/readings/latest"
+                       "?perPage=100"
+                       "&metrics[]=temperature"
+                       "&metrics[]=humidity"
+                       "&metrics[]=co2"
+                       "&metrics[]=noise"
+                       "&metrics[]=pm25"
+                       "&metrics[]=tvoc"
+                       "&metrics[]=indoorAirQuality",
+                       cfg.orgId);
+    size_t base = (size_t)len;
+
+    filterLocally = false;
+    const char *list = cfg.overviewSerials;
+    if (!list || !*list) return;   // whole org
+
+    if (!serialListed(list, cfg.serial)) {
+        len += snprintf(path + len, size - len, "&serials[]=%s", cfg.serial);
+    }
+    for (const char *p = list; *p && (size_t)len < size; ) {
+        while (*p == ' ' || *p == ',') ++p;
+        const char *end = p;
+        while (*end && *end != ',' && *end != ' ') ++end;
+        if (end > p) {
+            len += snprintf(path + len, size - len, "&serials[]=%.*s", (int)(end - p), p);
+        }
+        p = end;
+    }
+
+    if ((size_t)len >= size) {
+        path[base] = '\0';
+        filterLocally = true;
+    }
+}
+
+bool fetchMT15Once()
+{
+    ArenaScope scope(g_fetchArena);
+
+    char *path = (char *)g_fetchArena.alloc(LATEST_PATH_LEN);
+    // Parse into a scratch store first so a truncated page can't leave the
+    // overview half-updated.
+    SensorStore *scratch = g_fetchArena.make<SensorStore>();
+    if (!path || !scratch) return false;
+    SensorStore &store = *scratch;
+    sensorStoreClear(store);
+
+    bool filterLocally;
+    latestPath(path, LATEST_PATH_LEN, filterLocally);
+
+    const char *only = filterLocally ? g_merakiConfig.overviewSerials : NULL;
+
+    const int MAX_PAGES = MAX_SENSORS / 100 + 1;
+    int pages = 0;
+    for (;;) {
+        if (!merakiGet(path, "HTTP")) return false;
+        bool ok = parseLatest(g_body, store, only);
+        merakiEnd();
+        if (!ok) return false;
+
+        if (!g_linkNext[0] || ++pages >= MAX_PAGES || store.count >= MAX_SENSORS) break;
+        snprintf(path, LATEST_PATH_LEN, "%s", g_linkNext);
+    }
+
+    copySensorStore(g_sensors, store);
+    if (!sensorLatest(g_sensors, g_merakiConfig.serial, g_latest)) {
+        platformLog("MT15 %s not in latest readings\n", g_merakiConfig.serial);
+        for (int m = 0; m < METRIC_COUNT; ++m) g_latest[m] = NAN;
+    }
+
+    platformLog("MT15 latest: T=%.2fC H=%.1f%% CO2=%.0fppm (%d sensors)\n",
+                g_latest[METRIC_TEMP], g_latest[METRIC_HUM], g_latest[METRIC_CO2],
+                g_sensors.count);
+    analyticsUpdate();
+    archiveUpdate();
+
+    return true;
+}
+
+// ==== HISTORY (ALL METRICS) ====
+
+// Maps a byInterval entry to its metric and pulls out the bucket average.
+// Returns METRIC_COUNT for metrics we don't track.
+static int historyItemValue(JsonObject item, float &value)
+{
+    int id = metricFromName(item["metric"] | "");
+    if (id == METRIC_COUNT) return id;
+
+    // Usually {average,...}; humidity is sometimes a bare number
+    JsonVariantConst avg = metricValue(item, id);
+    if (!avg.is<double>()) avg = avg["average"];
+
+    value = avg.is<double>() ? avg.as<float>() : NAN;
+    return id;
+}
+
+bool parseHistoryWindow(ByteReader &body, HistoryWindow &win, bool append)
+{
+    ArenaScope scope(g_fetchArena);
+
+    ArenaJsonDocument filter(METRIC_FILTER_CAPACITY);
+    filter["startTs"] = true;
+    filter["metric"]  = true;
+    addMetricFilters(filter.as<JsonObject>());
+
+    if (!append) win.count = 0;
+    JsonArrayReader in(body);
+    bool empty;
+    if (!openJsonArray(in, empty)) {
+        platformLog("[HTTP-hist] Root is not array\n");
+        return false;
+    }
+    if (empty) return true;   // no buckets in the span (or past the last page)
+
+    // Entries for the same bucket share a startTs, but the API doesn't
+    // promise any grouping, so buckets are looked up by timestamp (latest
+    // added first: in practice a bucket's metrics arrive together).
+    int n = win.count;
+    int items = 0;
+    ArenaJsonDocument item(HISTORY_ITEM_CAPACITY);
+    DeserializationError err;
+    do {
+        err = deserializeJson(item, in, DeserializationOption::Filter(filter));
+        if (err) break;
+
+        float v;
+        int metric = historyItemValue(item.as<JsonObject>(), v);
+        if (metric == METRIC_COUNT) continue;
+
+        // Key on the interval boundary so every fetch agrees on bucket ids
+        uint32_t ts = parseIsoTs(item["startTs"] | "");
+        if (ts == 0) continue;
+        ts -= ts % HISTORY_INTERVAL_S;
+
+        int b = n - 1;
+        while (b >= 0 && win.startTs[b] != ts) --b;
+        if (b < 0) {
+            if (n >= MAX_HISTORY_POINTS) continue;  // keep the first buckets seen
+            b = n++;
+            win.startTs[b] = ts;
+            for (int m = 0; m < METRIC_COUNT; ++m) win.values[b][m] = READING_NONE;
+        }
+        win.values[b][metric] = encodeReading(metric, v);
+        ++items;
+    } while (nextJsonArrayItem(in));
+
+    if (err) {
+        platformLog("[HTTP-hist] JSON parse error: %s\n", err.c_str());
+        return false;
+    }
+    if (items == 0) {
+        platformLog("[HTTP-hist] Empty array\n");
+        return false;
+    }
+
+    win.count = n;
+    return true;
+}
+
+bool mergeHistoryWindow(HistoryRing &hist, const HistoryWindow &win, bool replace)
+{
+    if (win.count == 0) return true;   // nothing new; keep what we hold
+
+    uint32_t oldest = win.startTs[0];
+    for (int b = 1; b < win.count; ++b) {
+        if (win.startTs[b] < oldest) oldest = win.startTs[b];
+    }
+
+    // A window that starts more than one bucket past our newest means we
+    // missed something (long outage, clock jump).
+    if (!replace && hist.count > 0 &&
+        oldest > historyTs(hist, hist.count - 1) + HISTORY_INTERVAL_S) {
+        return false;
+    }
+
+    if (replace) {
+        hist.head  = 0;
+        hist.count = 0;
+    }
+    for (int b = 0; b < win.count; ++b) {
+        int i = historyUpsert(hist, win.startTs[b]);
+        if (i < 0) continue;
+        memcpy(hist.value[historySlot(hist, i)], win.values[b], sizeof(win.values[b]));
+    }
+    return true;
+}
+
+// Fetches the last `span` seconds of buckets and merges them into
+// g_history. With `replace` the ring is rebuilt from the response instead.
+// Sets g_historyNeedsFull if the response doesn't join up with what we
+// already hold.
+static bool fetchHistoryWindow(uint32_t span, bool replace)
+{
+    ArenaScope scope(g_fetchArena);
+
+    const size_t PATH_LEN = sizeof(g_linkNext);
+    char *path = (char *)g_fetchArena.alloc(PATH_LEN);
+    // Parse every page into a scratch window first so a truncated body
+    // can't leave the live history half-updated.
+    HistoryWindow *scratch = g_fetchArena.make<HistoryWindow>();
+    if (!path || !scratch) return false;
+    HistoryWindow &win = *scratch;
+
+    snprintf(path, PATH_LEN,
+             "/api/v1/organizations/%s/sensor/readings/history/byInterval"
+             "?serials[]=%s"
+             "&metrics[]=temperature"
+             "&metrics[]=humidity"
+             "&metrics[]=co2"
+             "&metrics[]=noise"
+             "&metrics[]=pm25"
+             "&metrics[]=tvoc"
+             "&metrics[]=indoorAirQuality"
+             "&interval=%lu"
+             "&perPage=%d"        // daily: 30 buckets x 7 metrics in one page
+             "&timespan=%lu",
+             g_merakiConfig.orgId, g_merakiConfig.serial,
+             (unsigned long)HISTORY_INTERVAL_S, HISTORY_PER_PAGE, (unsigned long)span);
+
+    const int MAX_PAGES = MAX_HISTORY_POINTS * METRIC_COUNT / HISTORY_PER_PAGE + 2;
+    for (int page = 0; ; ++page) {
+        if (!merakiGet(path, "HTTP-hist")) return false;
+        bool ok = parseHistoryWindow(g_body, win, page > 0);
+        merakiEnd();
+        if (!ok) return false;
+
+        if (!g_linkNext[0] || page + 1 >= MAX_PAGES || win.count >= MAX_HISTORY_POINTS) break;
+        snprintf(path, PATH_LEN, "%s", g_linkNext);
+    }
+
+    if (!mergeHistoryWindow(g_history, win, replace)) {
+        platformLog("[HTTP-hist] Gap after newest bucket, need full refresh\n");
+        g_historyNeedsFull = true;
+        return false;
+    }
+
+    platformLog("[HTTP-hist] Merged %d %s buckets, holding %d\n",
+                win.count, replace ? "full" : "recent", g_history.count);
+    return true;
+}
+
+bool fetchMT15History(bool *replaced)
+{
+    if (replaced) *replaced = false;
+
+    // If we haven't merged in over a bucket's length, the short window may
+    // no longer overlap what we hold.
+    if (g_history.count == 0 ||
+        platformMillis() - g_lastHistoryOk > HISTORY_INTERVAL_S * 1000UL) {
+        g_historyNeedsFull = true;
+    }
+
+    bool ok = false;
+    if (!g_historyNeedsFull) {
+        ok = fetchHistoryWindow(HISTORY_RECENT_SPAN_S, false);
+    }
+    if (g_historyNeedsFull) {
+        ok = fetchHistoryWindow(HISTORY_FULL_SPAN_S, true);
+        if (ok) {
+            g_historyNeedsFull = false;
+            if (replaced) *replaced = true;
+        }
+    }
+    if (!ok) return false;
+
+    g_lastHistoryOk = platformMillis();
+
+    // Every daily bucket; at finer resolutions only the newest few
+    int first = g_history.count > 32 ? g_history.count - 8 : 0;
+    for (int i = first; i < g_history.count; ++i) {
+        char label[6];
+        tsToLabel(historyTs(g_history, i), label);
+        platformLog("  bucket[%03d] %s T=%.2f H=%.1f CO2=%.0f PM2.5=%.1f\n",
+                    i, label,
+                    historyValue(g_history, METRIC_TEMP, i),
+                    historyValue(g_history, METRIC_HUM, i),
+                    historyValue(g_history, METRIC_CO2, i),
+                    historyValue(g_history, METRIC_PM25, i));
+    }
+
+    return true;
+}
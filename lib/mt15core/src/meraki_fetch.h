@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include "arena.h"
+#include "history.h"
+#include "platform.h"
+#include "sensor_store.h"
+
+const uint32_t HISTORY_RECENT_SPAN_S = 2 * HISTORY_INTERVAL_S;   // newest two buckets
+const int      HISTORY_PER_PAGE      = 1000;                     // API maximum
+
+// History TTL for the scheduler: hourly, or twice per bucket at finer
+// resolutions (missing a whole bucket forces the 30-day pull)
+const unsigned long HISTORY_REFRESH_MS =
+    HISTORY_INTERVAL_S >= 7200 ? 3600000UL : HISTORY_INTERVAL_S * 500UL;
+
+extern bool          g_historyNeedsFull;   // cold start or gap detected
+extern unsigned long g_lastHistoryOk;      // platformMillis() of last merged fetch
+
+// One byInterval response (all its pages) grouped into buckets, in the
+// order first seen; values as in HistoryRing
+struct HistoryWindow {
+    uint32_t startTs[MAX_HISTORY_POINTS];
+    int16_t  values[MAX_HISTORY_POINTS][METRIC_COUNT];
+    int      count;
+};
+
+// ==== FETCH ARENA ====
+
+// Working memory of the fetch path: scratch stores, JSON documents, request
+// paths and the state-cache blob all come out of this one static block,
+// each scoped to the job or parse that uses it. It is sized for the
+// hungriest user, so the fetch side never allocates from the heap (the
+// transport's TLS buffers aside). Fetch task only, and setup() before it.
+extern Arena g_fetchArena;
+
+// ==== PARSING ====
+
+// Parses one page of a /sensor/readings/latest body (any number of
+// sensors), appending to `store`. With `only` (comma-separated serials)
+// every other sensor except g_merakiConfig.serial is skipped. Sensors past
+// MAX_SENSORS are dropped.
+bool parseLatest(ByteReader &body, SensorStore &store, const char *only = NULL);
+
+// Parses a byInterval body into `win`; with `append` (later pages) its
+// buckets are added to those already there. An empty array ("[]") adds no
+// buckets. False on a JSON error or entries with no metric we track; `win`
+// is only meaningful on success.
+bool parseHistoryWindow(ByteReader &body, HistoryWindow &win, bool append = false);
+
+// Merges `win` into `hist`; with `replace` the ring is rebuilt from it
+// instead. Refuses (returns false) a window that doesn't join up with the
+// newest bucket already held. An empty window leaves `hist` as it is.
+bool mergeHistoryWindow(HistoryRing &hist, const HistoryWindow &win, bool replace);
+
+// ==== FETCHING ====
+
+// Refreshes g_sensors (every overview sensor) and g_latest (the configured
+// serial) from the org-wide latest-readings endpoint: one request per 100
+// sensors, on the shared connection.
+bool fetchMT15Once();
+
+// Keeps g_history current. The 30-day pull (several pages at hourly
+// resolution) only happens on cold start or after a gap; otherwise we
+// re-fetch the newest two buckets (the only ones that can still change)
+// and merge them in. `replaced` (if given) is set when the ring was
+// rebuilt from a 30-day pull, so a hub sends it as a full message.
+bool fetchMT15History(bool *replaced = NULL);
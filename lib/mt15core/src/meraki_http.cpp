@@ -0,0 +1,273 @@
+#include "meraki_http.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+
+#include "perf_stats.h"
+#include "scheduler.h"
+
+MerakiConfig g_merakiConfig = { "api.meraki.com", 443, "", "", "", NULL };
+Transport   *g_transport    = NULL;
+char         g_linkNext[512] = "";
+
+uint32_t g_tlsHandshakes  = 0;
+uint32_t g_reusedRequests = 0;
+
+MerakiBody g_body;
+static bool g_connKeepAlive = false;   // server is willing to reuse the socket
+static long g_retryAfterS   = 0;       // Retry-After of the last response, 0 = none
+static bool g_bodyTimed     = false;   // a 200 body is being read: time it at merakiEnd()
+
+// ==== RESPONSE BODY ====
+
+void MerakiBody::begin(long contentLength, bool chunked)
+{
+    _chunked   = chunked;
+    _remaining = chunked ? 0 : contentLength;  // -1: read until close
+    _firstChunk = true;
+    _failed    = false;
+    _done      = !chunked && contentLength == 0;
+    _startUs   = (uint32_t)platformMicros();
+    _waitUs    = 0;
+}
+
+int MerakiBody::read()
+{
+    if (_done || _failed) return -1;
+    if (_chunked && _remaining == 0 && !nextChunk()) return -1;
+
+    int c = rawRead();
+    if (c < 0) {
+        // Unknown length bodies end when the server closes
+        if (_remaining < 0 && !_conn->connected()) _done = true;
+        else _failed = true;
+        return -1;
+    }
+    if (_remaining > 0 && --_remaining == 0 && !_chunked) _done = true;
+    return c;
+}
+
+int MerakiBody::rawRead()
+{
+    int c = _conn->read();
+    if (c >= 0) return c;
+
+    // Nothing buffered: wait for the network, and keep count of how long
+    unsigned long waitStart = platformMicros();
+    unsigned long start = platformMillis();
+    do {
+        if (!_conn->connected() && _conn->available() <= 0) break;
+        platformDelay(1);
+        c = _conn->read();
+    } while (c < 0 && platformMillis() - start < HTTP_TIMEOUT_MS);
+    _waitUs += platformMicros() - waitStart;
+    return c;
+}
+
+bool MerakiBody::readLine(char *buf, size_t size)
+{
+    size_t len = 0;
+    for (;;) {
+        int c = rawRead();
+        if (c < 0) return false;
+        if (c == '\n') break;
+        if (c != '\r' && len + 1 < size) buf[len++] = (char)c;
+    }
+    buf[len] = '\0';
+    return true;
+}
+
+bool MerakiBody::nextChunk()
+{
+    char line[32];
+    // Each chunk after the first is preceded by the CRLF ending the previous one
+    if (!_firstChunk && !readLine(line, sizeof(line))) {
+        _failed = true;
+        return false;
+    }
+    _firstChunk = false;
+
+    if (!readLine(line, sizeof(line))) {
+        _failed = true;
+        return false;
+    }
+    _remaining = strtol(line, NULL, 16);  // ignores ";ext" suffixes
+    if (_remaining > 0) return true;
+
+    // Last chunk: skip optional trailers up to the blank line
+    while (readLine(line, sizeof(line)) && line[0] != '\0') {}
+    _done = true;
+    return false;
+}
+
+// ==== CONNECTION ====
+
+static bool merakiConnect()
+{
+    if (g_transport->connected()) return true;
+
+    g_transport->stop();
+
+    unsigned long t0 = platformMillis();
+    if (!g_transport->connect(g_merakiConfig.host, g_merakiConfig.port)) {
+        platformLog("[HTTP] connect to %s:%u failed\n",
+                    g_merakiConfig.host, (unsigned)g_merakiConfig.port);
+        return false;
+    }
+    g_tlsHandshakes++;
+    platformLog("[HTTP] connect + handshake %lu ms\n", platformMillis() - t0);
+
+    const Transport &t = *g_transport;
+    if (t.dnsUs >= 0) perfRecord(PERF_DNS, (uint32_t)t.dnsUs);
+    if (t.tcpUs >= 0) perfRecord(PERF_CONNECT, (uint32_t)t.tcpUs);
+    if (t.tlsUs >= 0) perfRecord(PERF_TLS, (uint32_t)t.tlsUs);
+    return true;
+}
+
+// Pulls the rel=next URL out of a Link header value into g_linkNext, as a
+// path: every request goes to g_merakiConfig.host anyway.
+//   <https://api.meraki.com/api/v1/...&startingAfter=...>; rel=next, <...>; rel=last
+static void parseNextLink(const char *value)
+{
+    const char *rel = strstr(value, "rel=next");
+    if (!rel) rel = strstr(value, "rel=\"next\"");
+    if (!rel) return;
+
+    const char *end = rel;
+    while (end > value && *end != '>') --end;
+    const char *start = end;
+    while (start > value && *start != '<') --start;
+    if (*start != '<' || *end != '>') return;
+    ++start;
+
+    const char *scheme = strstr(start, "://");
+    if (scheme && scheme < end) {
+        start = scheme + 3;
+        while (start < end && *start != '/') ++start;
+    }
+
+    size_t len = end - start;
+    if (len == 0 || len >= sizeof(g_linkNext)) return;
+    memcpy(g_linkNext, start, len);
+    g_linkNext[len] = '\0';
+}
+
+// Writes the request and parses the status line + headers. Returns the
+// HTTP status, or -1 if the connection broke before a status arrived.
+static int merakiSendRequest(const char *path)
+{
+    // One write so it leaves as a single TLS record. Static: serial lists
+    // make paths long, and only the fetch task sends requests.
+    static char req[2048];
+    int len = snprintf(req, sizeof(req),
+                       "GET %s HTTP/1.1\r\n"
+                       "Host: %s\r\n"
+                       "X-Cisco-Meraki-API-Key: %s\r\n"
+                       "Accept: application/json\r\n"
+                       "Connection: keep-alive\r\n"
+                       "\r\n",
+                       path, g_merakiConfig.host, g_merakiConfig.apiKey);
+    if (len <= 0 || len >= (int)sizeof(req)) return -1;
+    if (g_transport->write((const uint8_t *)req, len) != (size_t)len) return -1;
+    unsigned long sentUs = platformMicros();
+
+    // Status line: "HTTP/1.1 200 OK". Static and roomy for Link headers,
+    // which carry up to four full URLs.
+    static char line[1024];
+    g_linkNext[0] = '\0';
+    g_retryAfterS = 0;
+    g_body.attach(*g_transport);
+    if (!g_body.readLine(line, sizeof(line)) || strncmp(line, "HTTP/1.", 7) != 0) {
+        return -1;
+    }
+    perfRecord(PERF_TTFB, platformMicros() - sentUs);
+    int status = atoi(line + 9);
+    g_connKeepAlive = line[7] == '1';   // HTTP/1.1 defaults to keep-alive
+
+    long contentLength = -1;
+    bool chunked = false;
+    for (;;) {
+        if (!g_body.readLine(line, sizeof(line))) return -1;
+        if (line[0] == '\0') break;   // end of headers
+
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            contentLength = atol(line + 15);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = strstr(line + 18, "chunked") != NULL;
+        } else if (strncasecmp(line, "Link:", 5) == 0) {
+            parseNextLink(line + 5);
+        } else if (strncasecmp(line, "Retry-After:", 12) == 0) {
+            g_retryAfterS = atol(line + 12);   // Meraki sends seconds, not a date
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            g_connKeepAlive = strstr(line + 11, "close") == NULL &&
+                              strstr(line + 11, "Close") == NULL;
+        }
+    }
+
+    g_body.begin(contentLength, chunked);
+    return status;
+}
+
+void merakiEnd()
+{
+    // Before the drain: that is the caller's parse stopping short, not
+    // part of it
+    if (g_bodyTimed) {
+        uint32_t total = g_body.elapsedUs();
+        uint32_t wait  = std::min(g_body.waitUs(), total);
+        perfRecord(PERF_BODY, wait);
+        perfRecord(PERF_PARSE, total - wait);
+        g_bodyTimed = false;
+    }
+
+    if (!g_body.drain() || !g_body.reusable() || !g_connKeepAlive) {
+        g_transport->stop();
+    }
+}
+
+bool merakiGet(const char *path, const char *tag)
+{
+    rateLimitAcquire();
+
+    bool wasOpen = g_transport->connected();
+    if (!merakiConnect()) return false;
+
+    int status = merakiSendRequest(path);
+
+    // The server may have dropped an idle socket we thought was open;
+    // reconnect once and resend.
+    if (status < 0 && wasOpen) {
+        platformLog("[%s] stale connection, reconnecting\n", tag);
+        g_transport->stop();
+        wasOpen = false;
+        if (!merakiConnect()) return false;
+        status = merakiSendRequest(path);
+    }
+    if (status < 0) {
+        platformLog("[%s] GET failed: no response\n", tag);
+        g_transport->stop();
+        return false;
+    }
+
+    if (wasOpen) g_reusedRequests++;
+
+    platformLog("[%s] Status: %d, %s (handshakes=%lu reused=%lu)\n",
+                tag, status, wasOpen ? "reused" : "new conn",
+                (unsigned long)g_tlsHandshakes,
+                (unsigned long)g_reusedRequests);
+
+    if (status == 429) {
+        rateLimitHoldOff(g_retryAfterS > 0 ? (unsigned long)g_retryAfterS * 1000UL : 0);
+    }
+    if (status != 200) {
+        platformLog("[%s] Non-200 status\n", tag);
+        merakiEnd();
+        return false;
+    }
+
+    g_bodyTimed = true;
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include "platform.h"
+
+// Where requests go. Filled in by the application before the first request
+// (the firmware from its #defines, the host tools from the command line).
+struct MerakiConfig {
+    const char *host;
+    uint16_t    port;
+    const char *apiKey;
+    const char *orgId;
+    const char *serial;             // sensor behind the live and history pages
+    const char *overviewSerials;    // comma-separated; NULL/"" = whole org
+};
+
+extern MerakiConfig g_merakiConfig;
+
+// The connection all requests share; owned by the application.
+extern Transport *g_transport;
+
+// Path of the next page from the last response's Link header ("" on the
+// last page). Paginated endpoints are followed by re-requesting it.
+extern char g_linkNext[512];
+
+// How long to wait for the server between bytes before giving up
+const unsigned long HTTP_TIMEOUT_MS = 5000;
+
+// Connection reuse counters (printed with every request)
+extern uint32_t g_tlsHandshakes;    // fresh connects to the Meraki host
+extern uint32_t g_reusedRequests;   // requests sent on an already-open connection
+
+// Response body reader for the persistent connection. It strips chunked
+// transfer encoding so ArduinoJson sees plain JSON, and tracks how much of
+// the body is left so the remainder can be drained before the next request
+// goes out on the same socket.
+class MerakiBody : public ByteReader {
+public:
+    // Point the reader at a connection (for status/header lines).
+    void attach(Transport &conn)
+    {
+        _conn = &conn;
+    }
+
+    // Start a body of the given framing on the attached connection.
+    void begin(long contentLength, bool chunked);
+
+    // Body fully consumed and framing intact: the socket can be reused.
+    bool reusable() const { return _done && !_failed && _remaining >= 0; }
+
+    // Read and discard whatever is left of the body.
+    bool drain()
+    {
+        while (read() >= 0) {}
+        return _done && !_failed;
+    }
+
+    int read() override;
+
+    // Blocking single-byte read from the socket, bounded by HTTP_TIMEOUT_MS.
+    int rawRead();
+
+    // Reads one CRLF-terminated line (CRLF stripped). False on timeout.
+    bool readLine(char *buf, size_t size);
+
+    // Since begin(): all of it, and the part spent waiting for bytes to
+    // arrive. The rest went to whoever was reading.
+    uint32_t elapsedUs() const { return (uint32_t)platformMicros() - _startUs; }
+    uint32_t waitUs() const { return _waitUs; }
+
+private:
+    bool nextChunk();
+
+    Transport *_conn      = NULL;
+    long       _remaining = 0;
+    bool       _chunked   = false;
+    bool       _firstChunk = true;
+    bool       _done      = true;
+    bool       _failed    = false;
+    uint32_t   _startUs   = 0;   // platformMicros(), truncated
+    uint32_t   _waitUs    = 0;
+};
+
+extern MerakiBody g_body;
+
+// Issues a GET against the Meraki API on the persistent connection and
+// leaves g_body positioned at the start of the response body. Waits for a
+// rate-limit token first and reports a 429 (with its Retry-After) to the
+// scheduler. Only returns true for a 200; always pair with merakiEnd().
+// Connect phases and time to first byte go to the perf rings here; body
+// and parse time at merakiEnd().
+bool merakiGet(const char *path, const char *tag);
+
+// Finishes the current response. The rest of the body is drained so the
+// next request starts on a clean socket; if that isn't possible the
+// connection is closed and the next request pays for a new handshake.
+void merakiEnd();
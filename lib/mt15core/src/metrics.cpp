@@ -0,0 +1,43 @@
+#include "metrics.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// Slot -> MetricId, generated from METRICS by the compile-time search in
+// metrics.h
+const uint8_t METRIC_BY_SLOT[METRIC_HASH_SLOTS] = {
+    metricInSlot(0),  metricInSlot(1),  metricInSlot(2),  metricInSlot(3),
+    metricInSlot(4),  metricInSlot(5),  metricInSlot(6),  metricInSlot(7),
+    metricInSlot(8),  metricInSlot(9),  metricInSlot(10), metricInSlot(11),
+    metricInSlot(12), metricInSlot(13), metricInSlot(14), metricInSlot(15),
+};
+static_assert(METRIC_HASH_SLOTS == 16, "METRIC_BY_SLOT lists every slot");
+static_assert(metricHashPerfect(METRIC_HASH_SEED), "metric names collide");
+
+int16_t encodeReading(int metric, double value)
+{
+    if (isnan(value)) return READING_NONE;
+    double v = value * METRICS[metric].scale;
+    if (v >= INT16_MAX) return INT16_MAX;
+    if (v <= INT16_MIN + 1) return INT16_MIN + 1;
+    return (int16_t)lround(v);
+}
+
+void formatMetricValue(char *buf, size_t size, int metric, float value)
+{
+    if (isnan(value)) {
+        snprintf(buf, size, "--");
+    } else {
+        snprintf(buf, size, "%.*f", METRICS[metric].precision, value);
+    }
+}
+
+void formatMetricShort(char *buf, size_t size, int metric, float value)
+{
+    const MetricDesc &d = METRICS[metric];
+    if (isnan(value)) {
+        snprintf(buf, size, "--");
+    } else {
+        snprintf(buf, size, "%.*f%s", d.shortPrecision, value, d.shortUnit);
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Metrics we track, in display order
+enum MetricId {
+    METRIC_TEMP  = 0,
+    METRIC_HUM   = 1,
+    METRIC_CO2   = 2,
+    METRIC_NOISE = 3,
+    METRIC_PM25  = 4,
+    METRIC_TVOC  = 5,
+    METRIC_IAQ   = 6,
+    METRIC_COUNT = 7
+};
+
+// ==== DESCRIPTORS ====
+
+// Everything metric-specific lives here: the parsers, formatters and page
+// layouts all loop over this table, so adding a metric is one new row (plus
+// its MetricId).
+const int MAX_METRIC_PATH = 3;
+
+struct MetricDesc {
+    const char *name;                    // "metric" value in API readings
+    const char *path[MAX_METRIC_PATH];   // keys from a reading to the value
+    const char *label;                   // live page, size 1
+    const char *unit;                    // after live values; GLYPH_CHARS only
+    uint8_t     precision;               // live value decimals
+    const char *shortUnit;               // after axis labels / overview cells
+    uint8_t     shortPrecision;
+    float       scale;                   // stored fixed point: value * scale
+    const char *historyTitle;            // size 2, must fit 320 px
+    float       margin;                  // history y-range padding
+    const char *overviewHeader;          // NULL = no overview column
+    int16_t     overviewX;
+};
+
+// Units: C, %, ppm, dB, ug/m3, ppb, IAQ score (0-100). In the history
+// byInterval responses the value at `path` is an {average,...} object
+// (humidity sometimes sends a bare number).
+constexpr MetricDesc METRICS[METRIC_COUNT] = {
+    { "temperature",      { "temperature", "celsius" },           "Temp:",  "C",     2, "C", 1,
+      100.0f, "Temp last 30 days (C)", 0.5f,  "Temp", 172 },
+    { "humidity",         { "humidity", "relativePercentage" },   "Hum :",  "%",     0, "%", 0,
+      10.0f,  "Humidity last 30 days", 3.0f,  "Hum",  206 },
+    { "co2",              { "co2", "concentration" },             "CO2 :",  "ppm",   0, "",  0,
+      1.0f,   "CO2 30 days (ppm)",     50.0f, "CO2",  236 },
+    { "noise",            { "noise", "ambient", "level" },        "dB  :",  "dB",    0, "",  0,
+      10.0f,  "Noise 30 days (dB)",    2.0f,  NULL,   0   },
+    { "pm25",             { "pm25", "concentration" },            "PM2.5:", "ug/m3", 0, "",  0,
+      10.0f,  "PM2.5 30 days (ug/m3)", 2.0f,  "PM",   266 },
+    { "tvoc",             { "tvoc", "concentration" },            "TVOC:",  "ppb",   0, "",  0,
+      1.0f,   "TVOC 30 days (ppb)",    20.0f, NULL,   0   },
+    { "indoorAirQuality", { "indoorAirQuality", "score" },        "IAQ :",  "/100",  0, "",  0,
+      10.0f,  "IAQ last 30 days",      5.0f,  "IAQ",  296 },
+};
+
+// ==== NAME LOOKUP ====
+
+// Readings name their metric as a string. Instead of a strcmp chain we
+// hash the name into a 16-slot table whose seed is searched for at compile
+// time so that every known name lands in its own slot; a lookup is one
+// hash plus a single compare to reject names we don't track.
+const int      METRIC_HASH_BITS  = 4;
+const int      METRIC_HASH_SLOTS = 1 << METRIC_HASH_BITS;
+const uint32_t FNV_PRIME         = 16777619u;
+
+constexpr uint32_t metricNameHash(const char *s, uint32_t h)
+{
+    return *s ? metricNameHash(s + 1, (h ^ (uint8_t)*s) * FNV_PRIME) : h;
+}
+
+constexpr int metricSlot(const char *name, uint32_t seed)
+{
+    return (int)(metricNameHash(name, seed) >> (32 - METRIC_HASH_BITS));
+}
+
+constexpr bool metricSlotFree(int i, int j, uint32_t seed)
+{
+    return j >= METRIC_COUNT ||
+           (metricSlot(METRICS[i].name, seed) != metricSlot(METRICS[j].name, seed) &&
+            metricSlotFree(i, j + 1, seed));
+}
+
+constexpr bool metricHashPerfect(uint32_t seed, int i = 0)
+{
+    return i >= METRIC_COUNT ||
+           (metricSlotFree(i, i + 1, seed) && metricHashPerfect(seed, i + 1));
+}
+
+constexpr uint32_t findMetricHashSeed(uint32_t seed)
+{
+    return metricHashPerfect(seed) ? seed : findMetricHashSeed(seed + 1);
+}
+
+constexpr uint32_t METRIC_HASH_SEED = findMetricHashSeed(2166136261u);
+
+// MetricId in `slot`, or METRIC_COUNT
+constexpr int metricInSlot(int slot, int m = 0)
+{
+    return m >= METRIC_COUNT                                     ? METRIC_COUNT
+         : metricSlot(METRICS[m].name, METRIC_HASH_SEED) == slot ? m
+         : metricInSlot(slot, m + 1);
+}
+
+extern const uint8_t METRIC_BY_SLOT[METRIC_HASH_SLOTS];
+
+// MetricId for an API metric name, METRIC_COUNT if we don't track it.
+inline int metricFromName(const char *name)
+{
+    int m = METRIC_BY_SLOT[metricSlot(name, METRIC_HASH_SEED)];
+    return m < METRIC_COUNT && strcmp(METRICS[m].name, name) == 0 ? m : METRIC_COUNT;
+}
+
+// ==== FIXED POINT ====
+
+// The sensor store and the history ring keep readings as value * scale in
+// 16 bits.
+const int16_t READING_NONE = INT16_MIN;   // no reading
+
+// Saturates to the 16-bit range; NaN becomes READING_NONE.
+int16_t encodeReading(int metric, double value);
+
+inline float decodeReading(int metric, int16_t v)
+{
+    return v == READING_NONE ? NAN : v / METRICS[metric].scale;
+}
+
+// ==== FORMATTING ====
+
+// Live page value without its unit (drawn a size smaller), "22.51"; "--"
+// for NaN
+void formatMetricValue(char *buf, size_t size, int metric, float value);
+
+// Compact form for axis labels and overview cells, "22.5C"; "--" for NaN
+void formatMetricShort(char *buf, size_t size, int metric, float value);
@@ -0,0 +1,248 @@
+#include "mqtt_client.h"
+
+#include <string.h>
+
+// Control packet types (high nibble of the first byte)
+enum {
+    MQTT_CONNECT    = 1,
+    MQTT_CONNACK    = 2,
+    MQTT_PUBLISH    = 3,
+    MQTT_PUBACK     = 4,
+    MQTT_SUBSCRIBE  = 8,
+    MQTT_SUBACK     = 9,
+    MQTT_PINGREQ    = 12,
+    MQTT_PINGRESP   = 13,
+    MQTT_DISCONNECT = 14
+};
+
+// ==== ENCODING ====
+
+// Length-prefixed UTF-8 string; false if it doesn't fit
+static bool putString(uint8_t *buf, size_t size, size_t &pos, const char *s)
+{
+    size_t len = strlen(s);
+    if (len > 0xFFFF || pos + 2 + len > size) return false;
+    buf[pos++] = (uint8_t)(len >> 8);
+    buf[pos++] = (uint8_t)len;
+    memcpy(buf + pos, s, len);
+    pos += len;
+    return true;
+}
+
+bool MqttClient::send(const uint8_t *buf, size_t len)
+{
+    if (_conn.write(buf, len) != len) return false;
+    _lastSent = platformMillis();
+    return true;
+}
+
+// ==== DECODING ====
+
+int MqttClient::readByte()
+{
+    int c = _conn.read();
+    if (c >= 0) return c;
+
+    unsigned long start = platformMillis();
+    do {
+        if (!_conn.connected() && _conn.available() <= 0) return -1;
+        platformDelay(1);
+        c = _conn.read();
+    } while (c < 0 && platformMillis() - start < MQTT_TIMEOUT_MS);
+    return c;
+}
+
+bool MqttClient::readPacket()
+{
+    int first = readByte();
+    if (first < 0) return false;
+
+    // Remaining length: 7 bits per byte, at most 4 bytes
+    size_t len = 0;
+    for (int i = 0, shift = 0;; ++i, shift += 7) {
+        int b = readByte();
+        if (b < 0 || i == 4) return false;
+        len |= (size_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+
+    _type = (uint8_t)first;
+    if (len > sizeof(_buf)) {
+        for (size_t i = 0; i < len; ++i) {
+            if (readByte() < 0) return false;
+        }
+        _oversize++;
+        _type = 0;
+        _len  = 0;
+    } else {
+        for (size_t i = 0; i < len; ++i) {
+            int b = readByte();
+            if (b < 0) return false;
+            _buf[i] = (uint8_t)b;
+        }
+        _len = len;
+    }
+    _lastRecv = platformMillis();
+    return true;
+}
+
+// ==== CLIENT ====
+
+// Header byte, remaining length, body; one write so it leaves in one segment
+static bool frame(uint8_t *out, size_t size, size_t &outLen, uint8_t first,
+                  const uint8_t *body, size_t len)
+{
+    size_t pos = 0;
+    out[pos++] = first;
+    size_t rest = len;
+    do {
+        uint8_t b = rest & 0x7F;
+        rest >>= 7;
+        out[pos++] = rest ? (uint8_t)(b | 0x80) : b;
+    } while (rest && pos < 5);
+    if (rest || pos + len > size) return false;
+    memcpy(out + pos, body, len);
+    outLen = pos + len;
+    return true;
+}
+
+bool MqttClient::connect(const char *host, uint16_t port, const char *clientId,
+                         const char *user, const char *pass)
+{
+    stop();
+    if (!_conn.connect(host, port)) return false;
+
+    bool hasUser = user && *user;
+    bool hasPass = hasUser && pass && *pass;   // 3.1.1: no password without a user
+
+    uint8_t body[256];
+    size_t  pos = 0;
+    bool    ok  = putString(body, sizeof(body), pos, "MQTT");
+    body[pos++] = 4;   // protocol level 3.1.1
+    body[pos++] = (uint8_t)(0x02 | (hasUser ? 0x80 : 0) | (hasPass ? 0x40 : 0));   // clean session
+    body[pos++] = (uint8_t)(MQTT_KEEPALIVE_S >> 8);
+    body[pos++] = (uint8_t)MQTT_KEEPALIVE_S;
+    ok = ok && putString(body, sizeof(body), pos, clientId);
+    if (hasUser) ok = ok && putString(body, sizeof(body), pos, user);
+    if (hasPass) ok = ok && putString(body, sizeof(body), pos, pass);
+
+    size_t len;
+    if (!ok || !frame(_buf, sizeof(_buf), len, MQTT_CONNECT << 4, body, pos) || !send(_buf, len)) {
+        _conn.stop();
+        return false;
+    }
+
+    _up = true;
+    _lastRecv = platformMillis();
+    if (!waitFor(MQTT_CONNACK, NULL) || _len < 2 || _buf[1] != 0) {
+        if (_len >= 2) platformLog("[mqtt] broker refused: code %u\n", (unsigned)_buf[1]);
+        stop();
+        return false;
+    }
+    return true;
+}
+
+bool MqttClient::subscribe(const char *filter)
+{
+    if (!_up) return false;
+
+    uint16_t id = ++_packetId ? _packetId : ++_packetId;   // 0 isn't allowed
+    uint8_t  body[MQTT_MAX_TOPIC + 8];
+    size_t   pos = 0;
+    body[pos++] = (uint8_t)(id >> 8);
+    body[pos++] = (uint8_t)id;
+    bool ok = putString(body, sizeof(body) - 1, pos, filter);
+    body[pos++] = 0;   // QoS 0
+
+    size_t len;
+    if (!ok || !frame(_buf, sizeof(_buf), len, (MQTT_SUBSCRIBE << 4) | 0x02, body, pos) ||
+        !send(_buf, len)) {
+        stop();
+        return false;
+    }
+    if (!waitFor(MQTT_SUBACK, NULL) || _len < 3) {
+        stop();
+        return false;
+    }
+    return ((_buf[0] << 8) | _buf[1]) == id && _buf[2] != 0x80;
+}
+
+// Reads packets until one of `type` arrives, handing PUBLISHes to `fn` on
+// the way (NULL drops them)
+bool MqttClient::waitFor(uint8_t type, MessageFn fn)
+{
+    unsigned long start = platformMillis();
+    while (platformMillis() - start < MQTT_TIMEOUT_MS) {
+        if (!readPacket()) return false;
+        if ((_type >> 4) == type) return true;
+        if ((_type >> 4) == MQTT_PUBLISH && fn) dispatch(fn);
+    }
+    return false;
+}
+
+void MqttClient::dispatch(MessageFn fn)
+{
+    if (_len < 2) return;
+    size_t topicLen = (_buf[0] << 8) | _buf[1];
+    size_t pos = 2 + topicLen;
+    int qos = (_type >> 1) & 3;
+    if (qos > 0) pos += 2;   // packet id
+    if (pos > _len || topicLen >= MQTT_MAX_TOPIC) {
+        _oversize++;
+        return;
+    }
+
+    char topic[MQTT_MAX_TOPIC];
+    memcpy(topic, _buf + 2, topicLen);
+    topic[topicLen] = '\0';
+
+    if (qos == 1) {   // we subscribe at 0, but a broker may not downgrade
+        uint8_t ack[4] = { MQTT_PUBACK << 4, 2, _buf[2 + topicLen], _buf[3 + topicLen] };
+        send(ack, sizeof(ack));
+    }
+    fn(topic, _buf + pos, _len - pos);
+}
+
+bool MqttClient::loop(MessageFn fn)
+{
+    if (!_up) return false;
+
+    while (_conn.available() > 0) {
+        if (!readPacket()) {
+            stop();
+            return false;
+        }
+        if ((_type >> 4) == MQTT_PUBLISH) dispatch(fn);
+    }
+    if (!_conn.connected()) {
+        stop();
+        return false;
+    }
+
+    // Ping at 3/4 of the keep-alive; give up when the broker has been
+    // silent for 1.5 of it (a PINGRESP counts)
+    unsigned long now = platformMillis();
+    if (now - _lastRecv > MQTT_KEEPALIVE_S * 1500UL) {
+        platformLog("[mqtt] broker silent for %lu ms\n", now - _lastRecv);
+        stop();
+        return false;
+    }
+    if (now - _lastSent >= MQTT_KEEPALIVE_S * 750UL) {
+        uint8_t ping[2] = { MQTT_PINGREQ << 4, 0 };
+        if (!send(ping, sizeof(ping))) {
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void MqttClient::stop()
+{
+    if (_up && _conn.connected()) {
+        uint8_t bye[2] = { MQTT_DISCONNECT << 4, 0 };
+        _conn.write(bye, sizeof(bye));
+    }
+    _conn.stop();
+    _up = false;
+}
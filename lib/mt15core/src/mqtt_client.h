@@ -0,0 +1,60 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "platform.h"
+
+// Minimal MQTT 3.1.1 subscriber over a Transport (plain TCP to the site's
+// broker on the device, POSIX TCP on the host): CONNECT, SUBSCRIBE at
+// QoS 0, incoming PUBLISH, keep-alive pings. Nothing is ever published and
+// there is no session state, so a reconnect is just connect() again.
+
+const uint16_t      MQTT_KEEPALIVE_S  = 60;
+const unsigned long MQTT_TIMEOUT_MS   = 5000;   // CONNACK / SUBACK / rest of a packet
+const size_t        MQTT_MAX_PACKET   = 512;    // larger packets are skipped
+const size_t        MQTT_MAX_TOPIC    = 128;
+
+class MqttClient {
+public:
+    // topic is NUL-terminated; payload isn't
+    typedef void (*MessageFn)(const char *topic, const uint8_t *payload, size_t len);
+
+    explicit MqttClient(Transport &conn) : _conn(conn) {}
+
+    // TCP connect plus CONNECT (clean session); true once the broker has
+    // accepted. `user`/`pass` may be NULL or "".
+    bool connect(const char *host, uint16_t port, const char *clientId,
+                 const char *user, const char *pass);
+
+    // SUBSCRIBE at QoS 0; true once SUBACK grants it.
+    bool subscribe(const char *filter);
+
+    // Handles whatever has arrived without waiting for more, calling `fn`
+    // for every PUBLISH, and pings when the keep-alive is due. False once
+    // the connection is gone (closed, malformed, or the broker went quiet).
+    bool loop(MessageFn fn);
+
+    bool connected() const { return _up; }
+    void stop();
+
+    // Packets > MQTT_MAX_PACKET or with an over-long topic, skipped
+    uint32_t oversize() const { return _oversize; }
+
+private:
+    bool send(const uint8_t *buf, size_t len);
+    int  readByte();   // bounded by MQTT_TIMEOUT_MS; -1 on timeout / close
+    // One packet into _buf (type in _type, body length in _len); false on
+    // error. Oversize bodies are drained and reported as length 0.
+    bool readPacket();
+    bool waitFor(uint8_t type, MessageFn fn);
+    void dispatch(MessageFn fn);
+
+    Transport    &_conn;
+    bool          _up = false;
+    uint16_t      _packetId = 0;
+    unsigned long _lastSent = 0;   // platformMillis()
+    unsigned long _lastRecv = 0;
+    uint8_t       _type = 0;
+    size_t        _len = 0;
+    uint8_t       _buf[MQTT_MAX_PACKET];
+    uint32_t      _oversize = 0;
+};
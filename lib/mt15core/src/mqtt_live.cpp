@@ -0,0 +1,160 @@
+#include "mqtt_live.h"
+
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "analytics.h"
+#include "archive.h"
+#include "history.h"
+#include "meraki_http.h"
+#include "snapshot.h"
+
+MqttLiveConfig g_mqttConfig = { NULL, 1883, NULL, NULL, NULL, "meraki/v1/mt", NULL };
+MqttLiveStats  g_mqttStats  = {};
+
+// Topic leaf -> metric and the payload key holding the value. From the MT
+// MQTT docs; this is the one place to touch if a firmware renames one.
+struct MqttTopic {
+    const char *leaf;
+    int         metric;
+    const char *key;
+};
+
+static const MqttTopic MQTT_TOPICS[] = {
+    { "temperature",             METRIC_TEMP,  "celsius" },
+    { "humidity",                METRIC_HUM,   "humidity" },
+    { "CO2",                     METRIC_CO2,   "CO2" },
+    { "ambientNoise",            METRIC_NOISE, "ambientNoise" },
+    { "PM2_5MassConcentration",  METRIC_PM25,  "PM2_5MassConcentration" },
+    { "TVOC",                    METRIC_TVOC,  "TVOC" },
+    { "iaqIndex",                METRIC_IAQ,   "iaqIndex" },
+};
+
+// A payload is one timestamp and a value or two
+const size_t MQTT_DOC_CAPACITY = 256;
+
+static MqttClient   *g_mqtt = NULL;
+static bool          g_subscribed   = false;
+static bool          g_changed      = false;
+static unsigned long g_lastMessage  = 0;
+static unsigned long g_retryAt      = 0;
+static unsigned long g_retryDelay   = MQTT_RETRY_MIN_MS;
+
+// ==== MESSAGES ====
+
+static void onMessage(const char *topic, const uint8_t *payload, size_t len)
+{
+    const char *leaf = strrchr(topic, '/');
+    leaf = leaf ? leaf + 1 : topic;
+
+    const MqttTopic *t = NULL;
+    for (size_t i = 0; i < sizeof(MQTT_TOPICS) / sizeof(MQTT_TOPICS[0]); ++i) {
+        if (strcmp(MQTT_TOPICS[i].leaf, leaf) == 0) t = &MQTT_TOPICS[i];
+    }
+    if (!t) {
+        g_mqttStats.ignored++;   // battery, door, water...
+        return;
+    }
+
+    StaticJsonDocument<MQTT_DOC_CAPACITY> doc;
+    if (deserializeJson(doc, (const char *)payload, len) || !doc[t->key].is<float>()) {
+        g_mqttStats.ignored++;
+        return;
+    }
+    double   value = doc[t->key].as<double>();
+    uint32_t ts    = parseIsoTs(doc["ts"] | "");
+
+    g_latest[t->metric] = value;
+    int s = sensorFind(g_sensors, g_merakiConfig.serial);
+    if (s >= 0) {
+        g_sensors.reading[t->metric][s] = encodeReading(t->metric, value);
+        if (ts > g_sensors.ts[s]) g_sensors.ts[s] = ts;
+    }
+
+    g_mqttStats.messages++;
+    g_lastMessage = platformMillis();
+    g_changed = true;
+}
+
+// ==== SESSION ====
+
+void mqttLiveInit(Transport &conn)
+{
+    static MqttClient client(conn);
+    g_mqtt = &client;
+
+    // Brokers drop the older of two sessions with one id
+    static char clientId[16];
+    if (!g_mqttConfig.clientId || !*g_mqttConfig.clientId) {
+        snprintf(clientId, sizeof(clientId), "mt15-%08lx", (unsigned long)platformRandom());
+        g_mqttConfig.clientId = clientId;
+    }
+}
+
+static void openSession()
+{
+    const MqttLiveConfig &c = g_mqttConfig;
+    char filter[MQTT_MAX_TOPIC];
+    snprintf(filter, sizeof(filter), "%s/+/ble/%s/+", c.topicPrefix, c.sensorMac);
+
+    g_subscribed = g_mqtt->connect(c.host, c.port, c.clientId, c.user, c.pass) &&
+                   g_mqtt->subscribe(filter);
+    if (g_subscribed) {
+        g_mqttStats.connects++;
+        g_retryDelay = MQTT_RETRY_MIN_MS;
+        platformLog("[mqtt] subscribed to %s on %s:%u\n", filter, c.host, (unsigned)c.port);
+        return;
+    }
+
+    g_mqtt->stop();
+    g_retryAt = platformMillis() + g_retryDelay;
+    platformLog("[mqtt] %s:%u unreachable, polling; retry in %lu ms\n", c.host,
+                (unsigned)c.port, g_retryDelay);
+    g_retryDelay = g_retryDelay * 2 < MQTT_RETRY_MAX_MS ? g_retryDelay * 2 : MQTT_RETRY_MAX_MS;
+}
+
+bool mqttLivePoll(unsigned long waitMs)
+{
+    const MqttLiveConfig &c = g_mqttConfig;
+    if (!g_mqtt || !c.host || !*c.host || !c.sensorMac || !*c.sensorMac) {
+        platformDelay(waitMs);
+        return false;
+    }
+
+    unsigned long end = platformMillis() + waitMs;
+    g_changed = false;
+
+    for (;;) {
+        unsigned long now = platformMillis();
+        if (!g_subscribed && reached(g_retryAt, now)) openSession();
+
+        if (g_subscribed && !g_mqtt->loop(onMessage)) {
+            g_subscribed = false;
+            g_mqttStats.drops++;
+            g_retryAt = platformMillis();   // straight back once, then backoff
+            platformLog("[mqtt] connection lost\n");
+        }
+
+        // Metrics arrive as separate topics a few ms apart: let the rest of
+        // the burst land before reporting the change
+        now = platformMillis();
+        bool settled = g_changed && reached(g_lastMessage + MQTT_COALESCE_MS, now);
+        if (settled || reached(end, now)) {
+            if (g_changed) {
+                analyticsUpdate();
+                archiveUpdate();
+            }
+            return g_changed;
+        }
+
+        unsigned long left = end - now;
+        platformDelay(left < MQTT_POLL_MS ? left : MQTT_POLL_MS);
+    }
+}
+
+bool mqttLiveActive()
+{
+    return g_subscribed && g_mqttStats.messages > 0 &&
+           !reached(g_lastMessage + MQTT_STALE_MS, platformMillis());
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include "mqtt_client.h"
+#include "platform.h"
+
+// Live readings pushed over MQTT. MT sensors publish every reading to the
+// site's broker (Dashboard: Environmental > MQTT brokers), one topic per
+// metric:
+//
+//   <prefix>/<networkId>/ble/<sensor MAC>/<metric>   {"ts": "...", "<key>": value}
+//
+// We subscribe to the configured sensor's topics and write each message
+// into g_latest and the sensor's overview row as it arrives. The HTTP
+// latest-readings poll doesn't stop, it slows down (mqttLiveActive()): the
+// overview covers sensors we don't subscribe to, and it catches anything
+// the broker dropped. History always comes over HTTP.
+//
+// If the broker can't be reached we retry with backoff and the poll runs
+// at its normal rate in the meantime, so a dead broker costs freshness,
+// never data.
+
+struct MqttLiveConfig {
+    const char *host;          // NULL/"" = MQTT off
+    uint16_t    port;
+    const char *clientId;      // NULL/"" = "mt15-" + random, per boot
+    const char *user;          // NULL/"" = anonymous
+    const char *pass;
+    const char *topicPrefix;   // "meraki/v1/mt"
+    const char *sensorMac;     // "AA:BB:CC:DD:EE:FF", as in the topic
+};
+
+extern MqttLiveConfig g_mqttConfig;
+
+struct MqttLiveStats {
+    uint32_t connects, drops;   // sessions opened / lost
+    uint32_t messages;          // applied to the working state
+    uint32_t ignored;           // unknown leaf, bad JSON, no value
+};
+
+extern MqttLiveStats g_mqttStats;   // fetch side
+
+const unsigned long MQTT_POLL_MS        = 50;       // socket check while idle
+const unsigned long MQTT_COALESCE_MS    = 200;      // one sensor's burst of topics
+const unsigned long MQTT_RETRY_MIN_MS   = 5000;
+const unsigned long MQTT_RETRY_MAX_MS   = 5 * 60 * 1000UL;
+const unsigned long MQTT_STALE_MS       = 5 * 60 * 1000UL;   // MTs report at least this often
+
+// Latest-readings poll TTL while live: the overview and a safety net only
+const unsigned long MQTT_OVERVIEW_REFRESH_MS = 10 * 60 * 1000UL;
+
+// Gives the client its connection (plain TCP to the broker). Once, before
+// the first poll.
+void mqttLiveInit(Transport &conn);
+
+// Fetch side, in place of sleeping: waits up to `waitMs` for messages,
+// (re)connecting when the retry backoff allows. Returns true, a little
+// after the first of a burst, once the working state has changed.
+bool mqttLivePoll(unsigned long waitMs);
+
+// Subscribed and heard from within MQTT_STALE_MS: readings are live
+bool mqttLiveActive();
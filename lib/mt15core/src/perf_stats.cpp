@@ -0,0 +1,73 @@
+#include "perf_stats.h"
+
+#include <algorithm>
+
+#include "meraki_fetch.h"
+#include "platform.h"
+
+const char *const PERF_STAGE_NAMES[PERF_STAGE_COUNT] = {
+    "DNS", "TCP connect", "TLS", "TTFB", "Body read", "JSON parse",
+    "Frame", "Input lag", "Loop jitter"
+};
+
+PerfRing   g_perf[PERF_STAGE_COUNT];
+FrameStats g_frameStats;
+MemStats   g_memStats;
+
+void perfRecord(int stage, uint32_t us)
+{
+    PerfRing &r = g_perf[stage];
+    r.us[r.head] = us;
+    r.head = (r.head + 1) % PERF_SAMPLES;
+    if (r.count < PERF_SAMPLES) r.count++;
+}
+
+PerfSummary perfSummary(const PerfRing &ring)
+{
+    PerfSummary s = {};
+    int n = ring.count;
+    if (n == 0) return s;
+
+    // Order doesn't matter for any of these, so the used slots are simply
+    // the first `count` until the ring has wrapped
+    uint32_t sorted[PERF_SAMPLES];
+    std::copy(ring.us, ring.us + n, sorted);
+    std::sort(sorted, sorted + n);
+
+    uint64_t sum = 0;
+    for (int i = 0; i < n; ++i) sum += sorted[i];
+
+    s.minUs = sorted[0];
+    s.avgUs = (uint32_t)(sum / n);
+    s.p95Us = sorted[(n * 95 + 99) / 100 - 1];   // nearest rank
+    s.count = (uint16_t)n;
+    return s;
+}
+
+// ==== MEMORY ====
+
+void memSample(bool log)
+{
+    MemStats &s = g_memStats;
+    bool first = s.samples++ == 0;
+
+    s.freeHeap     = (uint32_t)platformFreeHeap();
+    s.minFreeHeap  = (uint32_t)platformMinFreeHeap();
+    s.largestBlock = (uint32_t)platformLargestFreeBlock();
+    if (first || s.largestBlock < s.minLargestBlock) s.minLargestBlock = s.largestBlock;
+    s.fragPct = s.freeHeap ? (uint8_t)(100 - (uint64_t)s.largestBlock * 100 / s.freeHeap) : 0;
+    if (s.fragPct > s.maxFragPct) s.maxFragPct = s.fragPct;
+
+    s.arenaHighWater = (uint32_t)g_fetchArena.highWater();
+    s.arenaBytes     = (uint32_t)g_fetchArena.size();
+    s.arenaFailures  = g_fetchArena.failures();
+
+    if (!log) return;
+    platformLog("[mem] heap %lu (min %lu), largest block %lu (min %lu), frag %u%% (max %u%%), "
+                "arena %lu/%lu%s\n",
+                (unsigned long)s.freeHeap, (unsigned long)s.minFreeHeap,
+                (unsigned long)s.largestBlock, (unsigned long)s.minLargestBlock,
+                (unsigned)s.fragPct, (unsigned)s.maxFragPct,
+                (unsigned long)s.arenaHighWater, (unsigned long)s.arenaBytes,
+                s.arenaFailures ? " OVERFLOWED" : "");
+}
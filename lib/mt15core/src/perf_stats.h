@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+
+// Per-stage latency samples for the diagnostics page. Every stage keeps its
+// last PERF_SAMPLES durations in a fixed ring; summaries (min/avg/p95) are
+// worked out from the ring when asked for, never kept up to date per sample.
+//
+// Each ring has one writer: the fetch stages belong to the fetch task and
+// reach the UI as summaries copied into every snapshot, the UI stages are
+// recorded and read on the UI side only.
+
+enum PerfStage {
+    PERF_DNS     = 0,   // name lookup (fresh connections only)
+    PERF_CONNECT = 1,   // TCP connect
+    PERF_TLS     = 2,   // TLS handshake, TCP connect included where the
+                        // transport can't split them (WiFiClientSecure)
+    PERF_TTFB    = 3,   // request written -> status line
+    PERF_BODY    = 4,   // waiting on the network for body bytes
+    PERF_PARSE   = 5,   // rest of the body's time: JSON parse (and decryption)
+    PERF_FETCH_STAGES,
+
+    PERF_RENDER  = PERF_FETCH_STAGES,   // one UI frame: render pass and push
+    PERF_INPUT,                         // touch sample -> its page change visible
+    PERF_LOOP_JITTER,                   // loop()'s timed wake-up, late by this much
+    PERF_STAGE_COUNT
+};
+
+extern const char *const PERF_STAGE_NAMES[PERF_STAGE_COUNT];
+
+const int PERF_SAMPLES = 32;
+
+struct PerfRing {
+    uint32_t us[PERF_SAMPLES];
+    uint8_t  head;    // next slot written
+    uint8_t  count;
+};
+
+struct PerfSummary {
+    uint32_t minUs, avgUs, p95Us;
+    uint16_t count;   // samples behind it (0 = nothing measured yet)
+};
+
+extern PerfRing g_perf[PERF_STAGE_COUNT];
+
+void perfRecord(int stage, uint32_t us);
+
+PerfSummary perfSummary(const PerfRing &ring);
+
+// ==== FRAMES ====
+
+// UI loop wake-ups by cause and the frames they led to (frame_sched.*);
+// frame times are PERF_RENDER. UI side only.
+struct FrameStats {
+    uint32_t wakes;
+    uint32_t touchWakes, dataWakes, timerWakes;
+    uint32_t frames;
+};
+
+extern FrameStats g_frameStats;
+
+// ==== MEMORY ====
+
+// Heap and fetch-arena counters, sampled by the fetch task after every job
+// (right after TLS and parsing have had their turn) and published with the
+// snapshot. Flat lows and highs over weeks of uptime mean a steady state.
+struct MemStats {
+    uint32_t samples;
+    uint32_t freeHeap, minFreeHeap;       // internal heap now / lowest since boot
+    uint32_t largestBlock, minLargestBlock;
+    uint8_t  fragPct, maxFragPct;         // 100 - largest block / free heap
+    uint32_t arenaHighWater, arenaBytes;  // g_fetchArena
+    uint32_t arenaFailures;
+};
+
+extern MemStats g_memStats;   // fetch side
+
+// Takes a sample into g_memStats; logs it when `log` is set.
+void memSample(bool log);
@@ -0,0 +1,131 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Thin platform layer under the MT15 core. The firmware implements it on
+// top of Arduino/M5Core2 (see main.cpp), the host build on top of POSIX and
+// an in-memory framebuffer (see host/). Nothing in the core includes an
+// Arduino or M5 header.
+
+// ==== CLOCK / LOG ====
+
+unsigned long platformMillis();
+unsigned long platformMicros();
+void          platformDelay(unsigned long ms);
+uint32_t      platformRandom();   // for jitter; differs between devices
+void          platformLog(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// True once platformMillis() `now` is at or past `deadline`. millis() wraps
+// after ~50 days, so compare through the difference, never directly.
+inline bool reached(unsigned long deadline, unsigned long now)
+{
+    return (long)(now - deadline) >= 0;
+}
+
+// ==== MEMORY ====
+
+// Internal heap, for the diagnostics page; 0 where it can't be measured.
+size_t platformFreeHeap();
+size_t platformMinFreeHeap();        // lowest it has been since boot
+size_t platformLargestFreeBlock();   // biggest single allocation that would succeed
+
+// Boot-time allocation of a big buffer that is never freed: PSRAM on the
+// device where present, so it doesn't cost internal heap. NULL on failure.
+void *platformAllocLarge(size_t size);
+
+// ==== STORAGE ====
+
+// Small named blobs that survive a reboot (LittleFS on the device, files in
+// a directory on the host). Saves replace the old blob atomically, so a
+// power cut leaves either the old or the new one.
+long platformLoadBlob(const char *name, uint8_t *buf, size_t size);   // bytes, -1 if absent
+bool platformSaveBlob(const char *name, const uint8_t *data, size_t len);
+
+// ==== BYTE STREAMS ====
+
+// What the JSON parsers read from: an HTTP body on the device or against a
+// mock server, a fixture file on the host. Also satisfies ArduinoJson's
+// custom reader contract (read() + readBytes()).
+class ByteReader {
+public:
+    virtual ~ByteReader() {}
+
+    // Next byte, or -1 at end of input / on error.
+    virtual int read() = 0;
+
+    size_t readBytes(char *buf, size_t len)
+    {
+        size_t n = 0;
+        while (n < len) {
+            int c = read();
+            if (c < 0) break;
+            buf[n++] = (char)c;
+        }
+        return n;
+    }
+};
+
+// A byte-oriented connection to a server (TLS on the device, plain TCP on
+// the host). Reads never block: read() returns -1 when nothing is buffered.
+class Transport {
+public:
+    virtual ~Transport() {}
+
+    virtual bool   connect(const char *host, uint16_t port) = 0;
+    virtual bool   connected() = 0;
+    virtual void   stop() = 0;
+    virtual size_t write(const uint8_t *buf, size_t len) = 0;
+    virtual int    available() = 0;
+    virtual int    read() = 0;
+
+    // Phases of the last successful connect() in microseconds, -1 where
+    // this transport doesn't time the phase on its own (no TLS on the host;
+    // the device's TCP connect is inside its TLS time).
+    long dnsUs = -1, tcpUs = -1, tlsUs = -1;
+};
+
+// ==== MULTICAST ====
+
+// UDP to / from one multicast group, for hub mode (hub.h). lwIP sockets on
+// the device, POSIX ones on the host. Datagrams are whole or not at all.
+class Multicast {
+public:
+    virtual ~Multicast() {}
+
+    // Joins `group` (dotted quad) on `port` to receive, or just targets it
+    // to send. Safe to call again after a failure.
+    virtual bool begin(const char *group, uint16_t port, bool receive) = 0;
+    virtual bool send(const uint8_t *buf, size_t len) = 0;
+
+    // One datagram into `buf`: its length, 0 if none came within
+    // `timeoutMs`, -1 on error. Longer datagrams are truncated.
+    virtual int  receive(uint8_t *buf, size_t size, unsigned long timeoutMs) = 0;
+};
+
+// ==== DISPLAY ====
+
+// RGB565 colours, same values as TFT_eSPI's TFT_* constants
+const uint16_t COLOR_BLACK    = 0x0000;
+const uint16_t COLOR_WHITE    = 0xFFFF;
+const uint16_t COLOR_GREEN    = 0x07E0;
+const uint16_t COLOR_RED      = 0xF800;
+const uint16_t COLOR_YELLOW   = 0xFFE0;
+const uint16_t COLOR_CYAN     = 0x07FF;
+const uint16_t COLOR_DARKGREY = 0x7BEF;
+const uint16_t COLOR_DARKCYAN = 0x03EF;
+
+// A 16-bit drawing surface: the panel, an off-screen sprite, or a host
+// framebuffer. Text is the classic 6x8 GLCD font scaled by `size`, drawn
+// from its top-left corner with the glyph cells painted in `bg`.
+class Display {
+public:
+    virtual ~Display() {}
+
+    virtual void fillRect(int x, int y, int w, int h, uint16_t color) = 0;
+    virtual void drawRect(int x, int y, int w, int h, uint16_t color) = 0;
+    virtual void drawLine(int x0, int y0, int x1, int y1, uint16_t color) = 0;
+    virtual void pushImage(int x, int y, int w, int h, const uint16_t *pixels) = 0;
+    virtual void drawText(const char *text, int x, int y, int size,
+                          uint16_t fg, uint16_t bg) = 0;
+    virtual int  textWidth(const char *text, int size) = 0;
+};
@@ -0,0 +1,146 @@
+#include "scheduler.h"
+
+#include "platform.h"
+
+static SchedulerConfig g_sched       = {};
+static bool            g_schedActive = false;
+
+static unsigned long g_jobDue[JOB_COUNT];
+static int           g_jobFailures[JOB_COUNT];
+
+static float         g_tokens    = 0;
+static unsigned long g_tokensAt  = 0;
+static unsigned long g_holdUntil = 0;
+static bool          g_holding   = false;
+
+// Uniform in [0, range)
+static unsigned long jitter(unsigned long range)
+{
+    return range ? platformRandom() % range : 0;
+}
+
+// ==== JOBS ====
+
+void schedulerInit(const SchedulerConfig &cfg)
+{
+    g_sched = cfg;
+    g_schedActive = true;
+
+    unsigned long now = platformMillis();
+    for (int j = 0; j < JOB_COUNT; ++j) {
+        g_jobDue[j] = now + jitter(cfg.startSpreadMs);
+        g_jobFailures[j] = 0;
+    }
+    g_tokens   = cfg.burst;
+    g_tokensAt = now;
+    g_holding  = false;
+}
+
+int schedulerNextJob()
+{
+    unsigned long now = platformMillis();
+    int job = -1;
+    for (int j = 0; j < JOB_COUNT; ++j) {
+        if (!reached(g_jobDue[j], now)) continue;
+        if (job < 0 || (long)(g_jobDue[j] - g_jobDue[job]) < 0) job = j;
+    }
+    return job;
+}
+
+unsigned long schedulerIdleMs()
+{
+    unsigned long now  = platformMillis();
+    unsigned long idle = (unsigned long)-1;
+    for (int j = 0; j < JOB_COUNT; ++j) {
+        if (reached(g_jobDue[j], now)) return 0;
+        unsigned long left = g_jobDue[j] - now;
+        if (left < idle) idle = left;
+    }
+    return idle;
+}
+
+void schedulerJobDone(int job, bool ok)
+{
+    unsigned long now = platformMillis();
+    unsigned long wait;
+    if (ok) {
+        g_jobFailures[job] = 0;
+        unsigned long ttl = g_sched.ttlMs[job];
+        wait = ttl - ttl / 10 + jitter(ttl / 5);   // TTL +-10 %
+    } else {
+        // min * 2^(failures-1), capped; then "equal jitter": half of it
+        // fixed, half random, so a retry never comes straight back
+        int n = ++g_jobFailures[job];
+        unsigned long backoff = g_sched.backoffMinMs;
+        while (--n > 0 && backoff < g_sched.backoffMaxMs) backoff *= 2;
+        if (backoff > g_sched.backoffMaxMs) backoff = g_sched.backoffMaxMs;
+        wait = backoff / 2 + jitter(backoff / 2 + 1);
+        platformLog("[sched] job %d failed %d times, retry in %lu ms\n",
+                    job, g_jobFailures[job], wait);
+    }
+    g_jobDue[job] = now + wait;
+
+    // Nothing goes out during a 429 hold-off anyway
+    if (g_holding && !reached(g_holdUntil, g_jobDue[job])) g_jobDue[job] = g_holdUntil;
+}
+
+void schedulerSetTtl(int job, unsigned long ttlMs)
+{
+    unsigned long old = g_sched.ttlMs[job];
+    if (ttlMs == old) return;
+    g_sched.ttlMs[job] = ttlMs;
+
+    unsigned long now = platformMillis();
+    if (ttlMs < old && g_jobFailures[job] == 0 && !reached(now + ttlMs, g_jobDue[job])) {
+        g_jobDue[job] = now + jitter(ttlMs / 10 + 1);
+    }
+}
+
+int schedulerFailures(int job)
+{
+    return g_jobFailures[job];
+}
+
+// ==== RATE LIMIT ====
+
+void rateLimitAcquire()
+{
+    if (!g_schedActive) return;
+
+    unsigned long now = platformMillis();
+    if (g_holding) {
+        if (!reached(g_holdUntil, now)) platformDelay(g_holdUntil - now);
+        g_holding = false;
+        now = platformMillis();
+    }
+
+    // After a hold-off g_tokensAt is its end, so refilling starts from
+    // there; the delay can wake a tick early, and the unsigned difference
+    // would then wrap to a full burst
+    if (reached(g_tokensAt, now)) {
+        g_tokens += (now - g_tokensAt) * g_sched.requestsPerS / 1000.0f;
+        if (g_tokens > g_sched.burst) g_tokens = g_sched.burst;
+        g_tokensAt = now;
+    }
+
+    if (g_tokens < 1.0f) {
+        unsigned long wait = (unsigned long)((1.0f - g_tokens) * 1000.0f / g_sched.requestsPerS) + 1;
+        platformDelay(wait);
+        g_tokens   = 1.0f;
+        g_tokensAt = platformMillis();
+    }
+    g_tokens -= 1.0f;
+}
+
+void rateLimitHoldOff(unsigned long retryAfterMs)
+{
+    if (!g_schedActive) return;
+
+    if (retryAfterMs == 0) retryAfterMs = g_sched.backoffMinMs;
+    unsigned long until = platformMillis() + retryAfterMs + jitter(retryAfterMs / 2 + 1);
+    if (!g_holding || reached(g_holdUntil, until)) g_holdUntil = until;
+    g_holding  = true;
+    g_tokens   = 0;   // come back slowly, not with a full burst
+    g_tokensAt = g_holdUntil;
+    platformLog("[sched] 429: holding requests for %lu ms\n", g_holdUntil - platformMillis());
+}
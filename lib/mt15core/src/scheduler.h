@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+
+// Refresh scheduling for the fetch task. Many displays usually share one
+// org's API budget, so everything here is about spending it evenly and
+// never in step with the other displays:
+//
+//   per job      a TTL, jittered by +-10 % so displays that booted
+//                together drift apart, and after a failure exponential
+//                backoff with jitter instead of the next TTL
+//   per device   a token bucket every request draws from, sized to this
+//                display's share of the org limit (pages included)
+//   on 429       every request holds off for Retry-After plus jitter: the
+//                limit is org-wide, so the other job would hit it too
+//
+// Only the fetch task calls into this.
+
+enum RefreshJob {
+    JOB_LATEST  = 0,   // fetchMT15Once()
+    JOB_HISTORY = 1,   // fetchMT15History()
+    JOB_COUNT   = 2
+};
+
+// Meraki's limit is 10 requests/s per organization
+const float MERAKI_ORG_REQUESTS_PER_S = 10.0f;
+
+struct SchedulerConfig {
+    unsigned long ttlMs[JOB_COUNT];
+    float         requestsPerS;    // token refill: org limit / displays sharing it
+    float         burst;           // bucket size, in requests
+    unsigned long backoffMinMs;    // first retry after a failure; also the
+                                   // 429 hold-off when there's no Retry-After
+    unsigned long backoffMaxMs;
+    unsigned long startSpreadMs;   // first runs land randomly in [0, this)
+};
+
+// Starts every job within startSpreadMs. Before this is called requests
+// aren't rate limited at all (the host tools rely on that).
+void schedulerInit(const SchedulerConfig &cfg);
+
+// The job that is due now (oldest deadline first), or -1.
+int schedulerNextJob();
+
+// Time until the next job is due, 0 if one already is.
+unsigned long schedulerIdleMs();
+
+// Reschedules `job`: after its TTL on success, after a backoff on failure.
+void schedulerJobDone(int job, bool ok);
+
+// Changes `job`'s TTL from the next run on. A shorter TTL also pulls the
+// pending run in, so going back to the faster rate takes effect at once.
+void schedulerSetTtl(int job, unsigned long ttlMs);
+
+// Consecutive failures of `job` (0 after a success)
+int schedulerFailures(int job);
+
+// Called before every request: blocks until a token is free and any 429
+// hold-off has passed.
+void rateLimitAcquire();
+
+// A 429 arrived: hold every request off for `retryAfterMs` (0 = unknown,
+// use backoffMinMs) plus jitter.
+void rateLimitHoldOff(unsigned long retryAfterMs);
@@ -0,0 +1,65 @@
+#include "sensor_store.h"
+
+#include <string.h>
+
+void sensorStoreClear(SensorStore &s)
+{
+    s.count = 0;
+    s.networkCount = 0;
+}
+
+static uint8_t internNetwork(SensorStore &s, const char *name)
+{
+    if (!name || !*name) return NETWORK_NONE;
+    for (int n = 0; n < s.networkCount; ++n) {
+        if (strncmp(s.networkName[n], name, NETWORK_NAME_LEN - 1) == 0) return n;
+    }
+    if (s.networkCount >= MAX_NETWORKS) return NETWORK_NONE;
+
+    strncpy(s.networkName[s.networkCount], name, NETWORK_NAME_LEN - 1);
+    s.networkName[s.networkCount][NETWORK_NAME_LEN - 1] = '\0';
+    return s.networkCount++;
+}
+
+int sensorAdd(SensorStore &s, const char *serial, const char *networkName)
+{
+    if (s.count >= MAX_SENSORS) return -1;
+
+    int i = s.count++;
+    strncpy(s.serial[i], serial, SERIAL_LEN - 1);
+    s.serial[i][SERIAL_LEN - 1] = '\0';
+    s.network[i] = internNetwork(s, networkName);
+    s.ts[i] = 0;
+    for (int m = 0; m < METRIC_COUNT; ++m) s.reading[m][i] = READING_NONE;
+    return i;
+}
+
+int sensorFind(const SensorStore &s, const char *serial)
+{
+    for (int i = 0; i < s.count; ++i) {
+        if (strncmp(s.serial[i], serial, SERIAL_LEN - 1) == 0) return i;
+    }
+    return -1;
+}
+
+bool sensorLatest(const SensorStore &s, const char *serial, double latest[METRIC_COUNT])
+{
+    int i = sensorFind(s, serial);
+    if (i < 0) return false;
+    for (int m = 0; m < METRIC_COUNT; ++m) latest[m] = sensorReading(s, m, i);
+    return true;
+}
+
+void copySensorStore(SensorStore &dst, const SensorStore &src)
+{
+    int n = src.count;
+    dst.count = src.count;
+    dst.networkCount = src.networkCount;
+    memcpy(dst.networkName, src.networkName, src.networkCount * sizeof(src.networkName[0]));
+    memcpy(dst.serial, src.serial, n * sizeof(src.serial[0]));
+    memcpy(dst.network, src.network, n * sizeof(src.network[0]));
+    memcpy(dst.ts, src.ts, n * sizeof(src.ts[0]));
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        memcpy(dst.reading[m], src.reading[m], n * sizeof(src.reading[m][0]));
+    }
+}
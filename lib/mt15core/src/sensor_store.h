@@ -0,0 +1,50 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include "metrics.h"
+
+// Latest readings for every sensor on the overview, column-oriented: one
+// array per metric indexed by sensor, so a pass over one metric (drawing a
+// column, hashing the visible rows) touches only that metric's memory.
+// Values are fixed point (MetricDesc::scale) in 16 bits; with the serial,
+// network index and timestamp a sensor costs 34 bytes.
+const int MAX_SENSORS      = 256;
+const int MAX_NETWORKS     = 16;
+const int SERIAL_LEN       = 15;    // "Q3CA-ABCD-1234" + NUL
+const int NETWORK_NAME_LEN = 24;
+
+const uint8_t NETWORK_NONE = 0xFF;
+
+struct SensorStore {
+    uint16_t count;
+    uint8_t  networkCount;
+    char     networkName[MAX_NETWORKS][NETWORK_NAME_LEN];
+
+    char     serial[MAX_SENSORS][SERIAL_LEN];
+    uint8_t  network[MAX_SENSORS];                 // index into networkName
+    uint32_t ts[MAX_SENSORS];                      // newest reading, unix s
+    int16_t  reading[METRIC_COUNT][MAX_SENSORS];
+};
+
+// NaN where the sensor didn't report the metric
+inline float sensorReading(const SensorStore &s, int metric, int sensor)
+{
+    return decodeReading(metric, s.reading[metric][sensor]);
+}
+
+void sensorStoreClear(SensorStore &s);
+
+// Appends a sensor with no readings. Returns its index, or -1 when full.
+// Network names are interned; past MAX_NETWORKS the sensor gets
+// NETWORK_NONE.
+int sensorAdd(SensorStore &s, const char *serial, const char *networkName);
+
+// Index of `serial`, or -1.
+int sensorFind(const SensorStore &s, const char *serial);
+
+// Copies `serial`'s readings into latest[] (NaN where it didn't report).
+// False, leaving latest[] untouched, if the sensor isn't in the store.
+bool sensorLatest(const SensorStore &s, const char *serial, double latest[METRIC_COUNT]);
+
+// Copies only the rows in use (a full-struct copy would move all 256).
+void copySensorStore(SensorStore &dst, const SensorStore &src);
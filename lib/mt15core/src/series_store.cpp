@@ -0,0 +1,352 @@
+#include "series_store.h"
+
+// Worst case per entry; a chunk that can't take one more is closed
+const uint32_t SERIES_CHUNK_BITS = SERIES_CHUNK_BYTES * 8;
+const uint32_t TS_MAX_BITS       = 4 + 32;          // '1111' + raw delta-of-delta
+const uint32_t VALUE_MAX_BITS    = 4 + 16;          // '1111' + raw value
+
+// ==== BITS ====
+
+// MSB first; n <= 32
+static void putBits(SeriesChunk &c, uint32_t v, int n)
+{
+    while (n > 0) {
+        int used = c.bits & 7;
+        int room = 8 - used;
+        int take = n < room ? n : room;
+        uint8_t part = (uint8_t)((v >> (n - take)) & ((1u << take) - 1));
+        if (used == 0) c.data[c.bits >> 3] = 0;
+        c.data[c.bits >> 3] |= (uint8_t)(part << (room - take));
+        c.bits += take;
+        n -= take;
+    }
+}
+
+static uint32_t getBits(const uint8_t *data, uint32_t &pos, int n)
+{
+    uint32_t v = 0;
+    while (n > 0) {
+        int used = pos & 7;
+        int room = 8 - used;
+        int take = n < room ? n : room;
+        v = (v << take) | ((data[pos >> 3] >> (room - take)) & ((1u << take) - 1));
+        pos += take;
+        n -= take;
+    }
+    return v;
+}
+
+static inline int32_t signExtend(uint32_t v, int n)
+{
+    return n >= 32 ? (int32_t)v : (int32_t)(v << (32 - n)) >> (32 - n);
+}
+
+// ==== ENCODING ====
+
+static void encodeTs(SeriesChunk &c, SeriesStream &st, uint32_t ts)
+{
+    if (c.count == 0) {
+        putBits(c, ts, 32);
+        st.delta = 0;
+    } else {
+        int32_t delta = (int32_t)(ts - st.prev);
+        int32_t dod   = delta - st.delta;
+        if (dod == 0) {
+            putBits(c, 0, 1);
+        } else if (dod >= -64 && dod <= 63) {
+            putBits(c, 0x2, 2);
+            putBits(c, (uint32_t)dod & 0x7F, 7);
+        } else if (dod >= -256 && dod <= 255) {
+            putBits(c, 0x6, 3);
+            putBits(c, (uint32_t)dod & 0x1FF, 9);
+        } else if (dod >= -2048 && dod <= 2047) {
+            putBits(c, 0xE, 4);
+            putBits(c, (uint32_t)dod & 0xFFF, 12);
+        } else {
+            putBits(c, 0xF, 4);
+            putBits(c, (uint32_t)dod, 32);
+        }
+        st.delta = delta;
+    }
+    st.prev = ts;
+}
+
+static void encodeValue(SeriesChunk &c, SeriesStream &st, int16_t v)
+{
+    int32_t d = v - (int16_t)st.prev;
+    if (c.count == 0) {
+        putBits(c, (uint16_t)v, 16);
+    } else if (d == 0) {
+        putBits(c, 0, 1);
+    } else if (d >= -4 && d <= 3) {
+        putBits(c, 0x2, 2);
+        putBits(c, (uint32_t)d & 0x7, 3);
+    } else if (d >= -16 && d <= 15) {
+        putBits(c, 0x6, 3);
+        putBits(c, (uint32_t)d & 0x1F, 5);
+    } else if (d >= -128 && d <= 127) {
+        putBits(c, 0xE, 4);
+        putBits(c, (uint32_t)d & 0xFF, 8);
+    } else {
+        putBits(c, 0xF, 4);   // big jumps, gaps (READING_NONE) and back
+        putBits(c, (uint16_t)v, 16);
+    }
+    st.prev = (uint16_t)v;
+}
+
+// ==== POOL ====
+
+static uint16_t allocChunk(SeriesStore &s)
+{
+    uint16_t i = s.freeHead;
+    s.freeHead = s.chunks[i].next;
+    s.freeCount--;
+    return i;
+}
+
+static void freeChunk(SeriesStore &s, uint16_t i)
+{
+    s.chunks[i].next = s.freeHead;
+    s.freeHead = i;
+    s.freeCount++;
+}
+
+// Recycles every chunk that holds only points before s.start. A stream's
+// newest chunk stays: appends go there.
+static void freeBeforeStart(SeriesStore &s)
+{
+    for (int k = 0; k < SERIES_STREAMS; ++k) {
+        SeriesStream &st = s.stream[k];
+        while (st.head != st.tail) {
+            const SeriesChunk &c = s.chunks[st.head];
+            if (c.first + c.count > s.start) break;
+            uint16_t next = c.next;
+            freeChunk(s, st.head);
+            st.head = next;
+        }
+    }
+}
+
+// Pool dry: give up the oldest points until some stream's oldest chunk is
+// free. False if no stream has a chunk to spare.
+static bool evictOldest(SeriesStore &s)
+{
+    uint32_t cut   = 0;
+    bool     found = false;
+    for (int k = 0; k < SERIES_STREAMS; ++k) {
+        const SeriesStream &st = s.stream[k];
+        if (st.head == st.tail) continue;
+        const SeriesChunk &c = s.chunks[st.head];
+        uint32_t end = c.first + c.count;
+        if (!found || end < cut) cut = end;
+        found = true;
+    }
+    if (!found) return false;
+
+    if (cut > s.start) s.start = cut;
+    freeBeforeStart(s);
+    return true;
+}
+
+// ==== STORE ====
+
+bool seriesInit(SeriesStore &s, SeriesChunk *chunks, int count, uint32_t maxPoints)
+{
+    s.chunks = NULL;
+    if (!chunks || count < 2 * SERIES_STREAMS || count >= SERIES_NO_CHUNK) return false;
+
+    for (int i = 0; i < count; ++i) {
+        chunks[i].next = i + 1 < count ? (uint16_t)(i + 1) : SERIES_NO_CHUNK;
+    }
+    s.chunks     = chunks;
+    s.chunkCount = (uint16_t)count;
+    s.freeHead   = 0;
+    s.freeCount  = (uint16_t)count;
+    s.maxPoints  = maxPoints;
+    s.start      = 0;
+    s.end        = 0;
+    s.lastTs     = 0;
+    for (int k = 0; k < SERIES_STREAMS; ++k) {
+        s.stream[k].head = s.stream[k].tail = SERIES_NO_CHUNK;
+    }
+    return true;
+}
+
+bool seriesAppend(SeriesStore &s, uint32_t ts, const int16_t values[METRIC_COUNT])
+{
+    if (!s.chunks || (s.end > s.start && ts <= s.lastTs)) return false;
+
+    // Streams whose newest chunk can't take a worst-case entry get a new
+    // one; find them all first so a point goes in whole or not at all
+    bool fresh[SERIES_STREAMS];
+    int  needed = 0;
+    for (int k = 0; k < SERIES_STREAMS; ++k) {
+        uint16_t tail = s.stream[k].tail;
+        uint32_t need = k == 0 ? TS_MAX_BITS : VALUE_MAX_BITS;
+        fresh[k] = tail == SERIES_NO_CHUNK || s.chunks[tail].bits + need > SERIES_CHUNK_BITS;
+        needed += fresh[k];
+    }
+    while (s.freeCount < needed) {
+        if (!evictOldest(s)) return false;
+    }
+
+    for (int k = 0; k < SERIES_STREAMS; ++k) {
+        SeriesStream &st = s.stream[k];
+        if (fresh[k]) {
+            uint16_t i = allocChunk(s);
+            SeriesChunk &c = s.chunks[i];
+            c.first = s.end;
+            c.count = 0;
+            c.bits  = 0;
+            c.next  = SERIES_NO_CHUNK;
+            if (st.tail != SERIES_NO_CHUNK) s.chunks[st.tail].next = i;
+            else st.head = i;
+            st.tail = i;
+        }
+        SeriesChunk &c = s.chunks[st.tail];
+        if (k == 0) encodeTs(c, st, ts);
+        else encodeValue(c, st, values[k - 1]);
+        c.count++;
+    }
+
+    s.end++;
+    s.lastTs = ts;
+    if (s.end - s.start > s.maxPoints) {
+        s.start = s.end - s.maxPoints;
+        freeBeforeStart(s);
+    }
+    return true;
+}
+
+size_t seriesBytesUsed(const SeriesStore &s)
+{
+    return s.chunks ? (size_t)(s.chunkCount - s.freeCount) * sizeof(SeriesChunk) : 0;
+}
+
+uint32_t seriesStreamBits(const SeriesStore &s, int k)
+{
+    uint32_t bits = 0;
+    if (!s.chunks) return 0;
+    for (uint16_t i = s.stream[k].head; i != SERIES_NO_CHUNK; i = s.chunks[i].next) {
+        bits += s.chunks[i].bits;
+    }
+    return bits;
+}
+
+// ==== READING ====
+
+static void openChunk(const SeriesStore &s, SeriesDecoder &d, uint16_t chunk)
+{
+    d.chunk = chunk;
+    d.left  = chunk == SERIES_NO_CHUNK ? 0 : s.chunks[chunk].count;
+    d.pos   = 0;
+}
+
+// Moves on to the next chunk when this one is used up; false at the end
+static inline bool nextEntry(const SeriesStore &s, SeriesDecoder &d)
+{
+    while (d.left == 0) {
+        if (d.chunk == SERIES_NO_CHUNK) return false;
+        openChunk(s, d, s.chunks[d.chunk].next);
+    }
+    d.left--;
+    return true;
+}
+
+static bool stepTs(const SeriesStore &s, SeriesDecoder &d)
+{
+    if (!nextEntry(s, d)) return false;
+    const uint8_t *data = s.chunks[d.chunk].data;
+    if (d.pos == 0) {
+        d.prev  = getBits(data, d.pos, 32);
+        d.delta = 0;
+        return true;
+    }
+
+    int n;
+    if (!getBits(data, d.pos, 1))      n = 0;
+    else if (!getBits(data, d.pos, 1)) n = 7;
+    else if (!getBits(data, d.pos, 1)) n = 9;
+    else if (!getBits(data, d.pos, 1)) n = 12;
+    else                               n = 32;
+    int32_t dod = n ? signExtend(getBits(data, d.pos, n), n) : 0;
+
+    d.delta += dod;
+    d.prev  += (uint32_t)d.delta;
+    return true;
+}
+
+static bool stepValue(const SeriesStore &s, SeriesDecoder &d)
+{
+    if (!nextEntry(s, d)) return false;
+    const uint8_t *data = s.chunks[d.chunk].data;
+    if (d.pos == 0) {
+        d.prev = getBits(data, d.pos, 16);
+        return true;
+    }
+
+    int n;
+    if (!getBits(data, d.pos, 1))      return true;   // repeat
+    else if (!getBits(data, d.pos, 1)) n = 3;
+    else if (!getBits(data, d.pos, 1)) n = 5;
+    else if (!getBits(data, d.pos, 1)) n = 8;
+    else {
+        d.prev = getBits(data, d.pos, 16);
+        return true;
+    }
+    d.prev = (uint16_t)((int16_t)d.prev + signExtend(getBits(data, d.pos, n), n));
+    return true;
+}
+
+void seriesSeek(const SeriesStore &s, int metric, uint32_t fromTs, SeriesCursor &c)
+{
+    c.store  = &s;
+    c.metric = metric;
+    c.point  = s.end;
+    if (!s.chunks || s.end == s.start) return;
+
+    // Timestamps: the last chunk starting at or before fromTs (each chunk
+    // opens with its first timestamp raw), then entry by entry
+    uint16_t k = s.stream[0].head;
+    for (uint16_t i = s.chunks[k].next; i != SERIES_NO_CHUNK; i = s.chunks[i].next) {
+        uint32_t pos = 0;
+        if (s.chunks[i].first > s.start && getBits(s.chunks[i].data, pos, 32) > fromTs) break;
+        k = i;
+    }
+    openChunk(s, c.ts, k);
+    uint32_t p = s.chunks[k].first;
+    for (;; ++p) {
+        SeriesDecoder before = c.ts;
+        if (!stepTs(s, c.ts)) return;   // nothing at or after fromTs
+        if (p >= s.start && c.ts.prev >= fromTs) {
+            c.ts = before;
+            break;
+        }
+    }
+
+    // Values: the chunk holding point p, decoded up to it
+    uint16_t v = s.stream[1 + metric].head;
+    while (s.chunks[v].first + s.chunks[v].count <= p) v = s.chunks[v].next;
+    openChunk(s, c.value, v);
+    for (uint32_t q = s.chunks[v].first; q < p; ++q) stepValue(s, c.value);
+    c.point = p;
+}
+
+bool seriesNext(SeriesCursor &c, uint32_t &ts, int16_t &value)
+{
+    if (c.point >= c.store->end) return false;
+    if (!stepTs(*c.store, c.ts) || !stepValue(*c.store, c.value)) return false;
+    ts    = c.ts.prev;
+    value = (int16_t)(uint16_t)c.value.prev;
+    c.point++;
+    return true;
+}
+
+bool seriesNextValue(SeriesCursor &c, int16_t &value)
+{
+    if (c.point >= c.store->end) return false;
+    if (!stepValue(*c.store, c.value)) return false;
+    value = (int16_t)(uint16_t)c.value.prev;
+    c.point++;
+    return true;
+}
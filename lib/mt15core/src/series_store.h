@@ -0,0 +1,113 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "metrics.h"
+
+// Compressed time series for windows longer than the 30-day ring: months
+// of buckets for every metric, after Facebook's Gorilla. One stream holds
+// the timestamps, one per metric the values:
+//
+//   timestamps   delta-of-delta in '0' / '10' / '110' / '1110' / '1111'
+//                tagged widths: a regular series costs one bit a point,
+//                a gap a few bits on either side
+//   values       the 16-bit fixed point of the history ring (MetricDesc::
+//                scale, READING_NONE for gaps), so nothing is lost on the
+//                way in; delta from the previous value in the same tagged
+//                widths (0, 3, 5, 8 bits, else the raw value): a repeat
+//                costs one bit, typical drift 5 to 8
+//
+// Gorilla XORs the values instead. That pays off for doubles, whose
+// neighbours share sign, exponent and top mantissa bits; on small
+// integers a change of one across a power of two (20.47 -> 20.48 C)
+// flips a dozen bits, and XOR came out ~40 % larger on MT-like data
+// (host/mt15_series_bench.cpp).
+//
+// Streams are chains of fixed-size chunks from one pool the caller
+// provides; each chunk starts with a raw value and decodes on its own.
+// Appending is O(1): bits go on the end of each stream's newest chunk.
+// The oldest chunks are recycled once points fall out of the window
+// (maxPoints), or earlier if the pool runs dry, so the store only ever
+// loses its oldest data. Readers walk a stream front to back with a
+// SeriesCursor.
+//
+// Fetch side only; a cursor is invalidated by the next append.
+
+const int      SERIES_STREAMS     = METRIC_COUNT + 1;   // timestamps, then one per metric
+const size_t   SERIES_CHUNK_BYTES = 128;
+const uint16_t SERIES_NO_CHUNK    = 0xFFFF;
+
+struct SeriesChunk {
+    uint32_t first;   // point number of the first entry
+    uint16_t count;   // entries
+    uint16_t bits;    // used bits of data[]
+    uint16_t next;    // newer chunk of the same stream, or SERIES_NO_CHUNK
+    uint8_t  data[SERIES_CHUNK_BYTES];
+};
+
+// Encoder state at the end of a stream's newest chunk
+struct SeriesStream {
+    uint16_t head, tail;   // oldest / newest chunk
+    uint32_t prev;         // last timestamp or value
+    int32_t  delta;        // timestamps: last delta
+};
+
+struct SeriesStore {
+    SeriesChunk *chunks;          // the pool; NULL until seriesInit()
+    uint16_t     chunkCount;
+    uint16_t     freeHead;        // free list through SeriesChunk::next
+    uint16_t     freeCount;
+    uint32_t     maxPoints;       // window: older points are dropped
+    uint32_t     start;           // point number of the oldest readable point
+    uint32_t     end;             // point number the next append gets
+    uint32_t     lastTs;
+    SeriesStream stream[SERIES_STREAMS];
+};
+
+// Sets `s` up over `count` chunks (at least 2 per stream), empty.
+bool seriesInit(SeriesStore &s, SeriesChunk *chunks, int count, uint32_t maxPoints);
+
+// Appends one point: a timestamp (unix s, newer than the last) and a value
+// per metric. False if the timestamp goes backwards or `s` isn't set up.
+bool seriesAppend(SeriesStore &s, uint32_t ts, const int16_t values[METRIC_COUNT]);
+
+inline uint32_t seriesCount(const SeriesStore &s)
+{
+    return s.end - s.start;
+}
+
+// Pool bytes holding data, all streams
+size_t seriesBytesUsed(const SeriesStore &s);
+
+// Bits stream `k` (0 = timestamps, 1 + MetricId) takes, over the chunks it
+// holds now; for sizing the pool.
+uint32_t seriesStreamBits(const SeriesStore &s, int k);
+
+// ==== READING ====
+
+struct SeriesDecoder {
+    uint16_t chunk;
+    uint16_t left;    // entries still to read in `chunk`
+    uint32_t pos;     // bit position in `chunk`
+    uint32_t prev;
+    int32_t  delta;
+};
+
+struct SeriesCursor {
+    const SeriesStore *store;
+    int                metric;
+    uint32_t           point;   // point number seriesNext() returns next
+    SeriesDecoder      ts, value;
+};
+
+// Positions `c` on `metric`'s first point at or after `fromTs` (0 = the
+// oldest held).
+void seriesSeek(const SeriesStore &s, int metric, uint32_t fromTs, SeriesCursor &c);
+
+// The next point, oldest first; false past the newest.
+bool seriesNext(SeriesCursor &c, uint32_t &ts, int16_t &value);
+
+// seriesNext() without the timestamp, for reading several metrics
+// together: every point is in every stream, so cursors seeked to the same
+// point stay in step, and only one of them needs to decode timestamps.
+// Don't mix with seriesNext() on the same cursor.
+bool seriesNextValue(SeriesCursor &c, int16_t &value);
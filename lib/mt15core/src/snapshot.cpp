@@ -0,0 +1,57 @@
+#include "snapshot.h"
+
+#include <math.h>
+#include <string.h>
+#include <atomic>
+
+#include "state_cache.h"
+
+WifiState   g_wifiState = WIFI_CONNECTING;
+double      g_latest[METRIC_COUNT] = { NAN, NAN, NAN, NAN, NAN, NAN, NAN };
+HistoryRing g_history = {};
+SensorStore g_sensors = {};
+
+// Lock-free SPSC triple buffer. The fetch side fills its back buffer and
+// swaps it into the middle slot; the UI swaps the middle slot for its front
+// buffer only when the fresh bit is set. Both sides are wait-free and the
+// UI always sees a complete snapshot.
+static SensorSnapshot        g_snapBuf[3] = {};
+static std::atomic<uint32_t> g_snapMiddle(1);  // buffer index | SNAP_FRESH
+static uint32_t              g_snapBack  = 0;  // fetch side only
+static uint32_t              g_snapFront = 2;  // UI only
+static const uint32_t        SNAP_FRESH  = 0x80;
+
+void publishSnapshot()
+{
+    static uint32_t seq = 0;
+
+    SensorSnapshot &s = g_snapBuf[g_snapBack];
+    s.seq  = ++seq;
+    s.wifi = g_wifiState;
+    memcpy(s.latest, g_latest, sizeof(s.latest));
+    copyHistory(s.history, g_history);
+    copySensorStore(s.sensors, g_sensors);
+    s.analytics = g_analytics;
+    s.fromCache = g_stateFromCache;
+    for (int st = 0; st < PERF_FETCH_STAGES; ++st) s.perf[st] = perfSummary(g_perf[st]);
+    s.mem = g_memStats;
+
+    uint32_t prev = g_snapMiddle.exchange(g_snapBack | SNAP_FRESH,
+                                          std::memory_order_acq_rel);
+    g_snapBack = prev & ~SNAP_FRESH;
+}
+
+bool acquireSnapshot()
+{
+    if (!(g_snapMiddle.load(std::memory_order_acquire) & SNAP_FRESH)) {
+        return false;
+    }
+    uint32_t prev = g_snapMiddle.exchange(g_snapFront, std::memory_order_acq_rel);
+    g_snapFront = prev & ~SNAP_FRESH;
+    return true;
+}
+
+const SensorSnapshot &uiSnapshot()
+{
+    return g_snapBuf[g_snapFront];
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include "analytics.h"
+#include "history.h"
+#include "perf_stats.h"
+#include "sensor_store.h"
+
+enum WifiState {
+    WIFI_CONNECTING = 0,
+    WIFI_OK         = 1,
+    WIFI_FAIL       = 2
+};
+
+// Everything the UI draws from. The fetch side never touches a snapshot the
+// UI is reading, so pages can be drawn at any time without locking.
+struct SensorSnapshot {
+    uint32_t    seq;                    // bumps on every publish
+    WifiState   wifi;
+    double      latest[METRIC_COUNT];
+    HistoryRing history;
+    SensorStore sensors;                // org overview
+    AnalyticsSummary analytics;         // trends and alerts of `latest`
+    bool        fromCache;              // restored at boot, not fetched yet
+    PerfSummary perf[PERF_FETCH_STAGES];   // fetch task's stage timings
+    MemStats    mem;
+};
+
+// Fetch-side working state, copied out by publishSnapshot(). Latest values
+// are indexed by MetricId; units: C, %, ppm, dB, ug/m3, ppb, IAQ score
+// (0-100).
+extern WifiState   g_wifiState;
+extern double      g_latest[METRIC_COUNT];
+extern HistoryRing g_history;
+extern SensorStore g_sensors;
+
+// Fetch side: copy the working state into the back buffer and hand it over.
+void publishSnapshot();
+
+// UI: pick up the newest published snapshot, if there is one.
+bool acquireSnapshot();
+
+// UI: the snapshot currently on screen. Stable until the next acquireSnapshot().
+const SensorSnapshot &uiSnapshot();
@@ -0,0 +1,106 @@
+#include "sparkline.h"
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include "ui.h"
+
+// One strip of the plot, SPARK_STRIP_ROWS x SCREEN_W. Static: drawing only
+// happens on the UI side.
+static uint16_t g_strip[SPARK_STRIP_ROWS * SCREEN_W];
+
+// A strip covers plot rows [top, top + rows) and columns [0, w)
+struct Strip {
+    int top, rows, w;
+
+    inline void plot(int x, int y, uint16_t color) const
+    {
+        if (y >= top && y < top + rows && x >= 0 && x < w) {
+            g_strip[(y - top) * w + x] = color;
+        }
+    }
+
+    void vline(int x, int y0, int y1, uint16_t color) const
+    {
+        if (x < 0 || x >= w) return;
+        y0 = std::max(y0, top);
+        y1 = std::min(y1, top + rows - 1);
+        for (int y = y0; y <= y1; ++y) g_strip[(y - top) * w + x] = color;
+    }
+
+    void hline(int y, uint16_t color) const
+    {
+        if (y < top || y >= top + rows) return;
+        uint16_t *row = g_strip + (y - top) * w;
+        for (int x = 0; x < w; ++x) row[x] = color;
+    }
+
+    // Bresenham, skipping segments that miss the strip entirely
+    void line(int x0, int y0, int x1, int y1, uint16_t color) const
+    {
+        if (std::max(y0, y1) < top || std::min(y0, y1) >= top + rows) return;
+
+        int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+        int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+        int err = dx + dy;
+        for (;;) {
+            plot(x0, y0, color);
+            if (x0 == x1 && y0 == y1) break;
+            int e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x0 += sx; }
+            if (e2 <= dx) { err += dx; y0 += sy; }
+        }
+    }
+};
+
+int drawSparkGeometry(Display &gfx, int x0, int y0, const SparkGeometry &g,
+                      const SparkStyle &st)
+{
+    int w = std::min((int)st.w, SCREEN_W);
+    int totalRows = sparkRows(st);
+
+    if (g.message) {
+        gfx.fillRect(x0, y0, w, totalRows, st.background);
+        gfx.drawText(g.message, x0, y0, 1, st.text, st.background);
+        return 8;
+    }
+
+    // Frame, grid, ticks, band and line, rasterised a strip at a time; the
+    // ticks hang SPARK_TICK_LEN rows below the frame.
+    for (int top = 0; top < totalRows; top += SPARK_STRIP_ROWS) {
+        Strip s = { top, std::min(SPARK_STRIP_ROWS, totalRows - top), w };
+        std::fill(g_strip, g_strip + s.rows * w, st.background);
+
+        for (int t = 0; t < g.ticks; ++t) {
+            s.vline(g.tickX[t], 0, st.h + SPARK_TICK_LEN, st.grid);
+        }
+
+        for (int c = 0; c < g.columns; ++c) {
+            s.vline(c, g.bandTop[c], g.bandBottom[c], st.band);   // empty: top > bottom
+        }
+
+        s.hline(0, st.frame);
+        s.hline(st.h - 1, st.frame);
+        s.vline(0, 0, st.h - 1, st.frame);
+        s.vline(w - 1, 0, st.h - 1, st.frame);
+
+        for (int i = 1; i < g.points; ++i) {
+            s.line(g.x[i - 1], g.y[i - 1], g.x[i], g.y[i], st.line);
+        }
+
+        gfx.pushImage(x0, y0 + top, w, s.rows, g_strip);
+    }
+
+    // Y-axis labels to the right of the frame
+    gfx.drawText(g.maxLabel, x0 + st.w + 4, y0, 1, st.text, st.background);
+    gfx.drawText(g.minLabel, x0 + st.w + 4, y0 + st.h - 8, 1, st.text, st.background);
+
+    // MM/DD under each tick, roughly centred and kept on screen
+    int labelY = y0 + st.h + SPARK_TICK_LEN + 2;
+    for (int t = 0; t < g.ticks; ++t) {
+        int textX = std::min(std::max(x0 + g.tickX[t] - 10, 0), SCREEN_W - 24);
+        gfx.drawText(g.tickLabel[t], textX, labelY, 1, st.text, st.background);
+    }
+
+    return labelY + 8 - y0;
+}
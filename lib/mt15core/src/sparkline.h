@@ -0,0 +1,203 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include "history.h"
+#include "platform.h"
+
+// Sparkline engine shared by every history plot. Drawing is split in two:
+//
+//   buildSparkGeometry()  once per data change: range scan, downsampling
+//                         to the frame width, then every kept point, tick
+//                         and label turned into plot-relative screen
+//                         coordinates (fixed point, no per-point divide)
+//                         and cached in a SparkGeometry.
+//   drawSparkGeometry()   any number of times: integer-only rasterising of
+//                         the cached geometry into a small strip buffer,
+//                         pushed with one pushImage() per strip instead of
+//                         one transaction per line segment.
+//
+// A series is anything with
+//   int size() const; float value(int i) const;   // NaN = no data
+//   uint32_t ts(int i) const;                      // unix s, for tick labels
+//   void formatValue(char *buf, size_t size, float v) const;
+
+// A series longer than the frame is wide is cut down to one point per
+// column with Largest-Triangle-Three-Buckets, which keeps the peaks and
+// dips a plain stride would skip. With `envelope` each column also gets
+// the min..max of every point that fell into it, drawn as a band behind
+// the line.
+const int MAX_SPARK_W      = 320;   // the screen
+const int MAX_SPARK_POINTS = MAX_HISTORY_POINTS < MAX_SPARK_W ? MAX_HISTORY_POINTS : MAX_SPARK_W;
+const int MAX_SPARK_TICKS  = 8;
+const int SPARK_TICK_LEN   = 2;    // below the frame
+const int SPARK_STRIP_ROWS = 16;   // rows per pushImage
+
+struct SparkStyle {
+    int16_t  w, h;         // frame size
+    float    margin;       // y-range padding
+    int16_t  tickEvery;    // points between ticks, counted back from the newest
+    bool     envelope;     // min/max band when points outnumber columns
+    uint16_t line, band, frame, grid, text, background;
+};
+
+struct SparkGeometry {
+    const char *message;                 // non-NULL: nothing to plot, say this
+    int16_t     points;
+    int16_t     x[MAX_SPARK_POINTS];     // relative to the frame's top-left
+    int16_t     y[MAX_SPARK_POINTS];
+    int16_t     columns;                 // envelope width, 0 = none
+    int16_t     bandTop[MAX_SPARK_POINTS];      // per column; top > bottom = empty
+    int16_t     bandBottom[MAX_SPARK_POINTS];
+    int16_t     ticks;
+    int16_t     tickX[MAX_SPARK_TICKS];
+    char        tickLabel[MAX_SPARK_TICKS][6];
+    char        maxLabel[12], minLabel[12];
+};
+
+// Indices of the points LTTB keeps out of `n` (NaN = gap, never kept),
+// at most `target` of them, first and last included. Calls keep(i) in
+// increasing i.
+template <class Series, class Keep>
+void sparkDownsample(const Series &s, int n, int target, Keep keep)
+{
+    int a = 0;
+    while (a < n && isnan(s.value(a))) ++a;
+    if (a == n) return;
+    keep(a);
+
+    // Bucket b spans [1 + b*(n-2)/(target-2), 1 + (b+1)*(n-2)/(target-2))
+    int inner = target - 2;
+    for (int b = 0; b < inner; ++b) {
+        int lo = 1 + (int)((int64_t)b * (n - 2) / inner);
+        int hi = 1 + (int)((int64_t)(b + 1) * (n - 2) / inner);
+        int nextHi = b + 1 < inner ? 1 + (int)((int64_t)(b + 2) * (n - 2) / inner) : n;
+
+        // Third corner: the average of the next bucket
+        float cx = 0, cy = 0;
+        int   cn = 0;
+        for (int i = hi; i < nextHi; ++i) {
+            float v = s.value(i);
+            if (isnan(v)) continue;
+            cx += i;
+            cy += v;
+            cn++;
+        }
+        float av = s.value(a);
+        if (cn == 0) {
+            cx = (hi + nextHi) * 0.5f;
+            cy = av;
+        } else {
+            cx /= cn;
+            cy /= cn;
+        }
+
+        int   best = -1;
+        float bestArea = -1.0f;
+        for (int i = lo > a + 1 ? lo : a + 1; i < hi; ++i) {
+            float v = s.value(i);
+            if (isnan(v)) continue;
+            float area = fabsf((a - cx) * (v - av) - (a - i) * (cy - av));
+            if (area > bestArea) {
+                bestArea = area;
+                best = i;
+            }
+        }
+        if (best >= 0) {
+            keep(best);
+            a = best;
+        }
+    }
+
+    int last = n - 1;
+    while (last > a && isnan(s.value(last))) --last;
+    if (last > a) keep(last);
+}
+
+template <class Series>
+void buildSparkGeometry(SparkGeometry &g, const Series &s, const SparkStyle &st)
+{
+    g.points  = 0;
+    g.columns = 0;
+    g.ticks   = 0;
+    g.message = NULL;
+
+    int n = s.size();
+    if (n <= 1) {
+        g.message = "Not enough data";
+        return;
+    }
+
+    float vMin = INFINITY, vMax = -INFINITY;
+    for (int i = 0; i < n; ++i) {
+        float v = s.value(i);
+        if (isnan(v)) continue;
+        if (v < vMin) vMin = v;
+        if (v > vMax) vMax = v;
+    }
+    if (vMin > vMax) {
+        g.message = "No valid data";
+        return;
+    }
+    vMin -= st.margin;
+    vMax += st.margin;
+
+    // Q16.16: one step for x, one scale for y, then a multiply per point
+    int32_t xStep  = ((int32_t)(st.w - 1) << 16) / (n - 1);
+    float   yScale = (st.h - 2) * 65536.0f / (vMax - vMin + 1e-6f);
+    auto px = [&](int i) { return (int16_t)(((int64_t)i * xStep) >> 16); };
+    auto py = [&](float v) {
+        return (int16_t)(st.h - 1 - ((int32_t)((v - vMin) * yScale) >> 16));
+    };
+
+    // Gaps are bridged
+    auto keep = [&](int i) {
+        g.x[g.points] = px(i);
+        g.y[g.points] = py(s.value(i));
+        g.points++;
+    };
+    int target = st.w < MAX_SPARK_POINTS ? st.w : MAX_SPARK_POINTS;
+    if (n <= target) {
+        for (int i = 0; i < n; ++i) {
+            if (!isnan(s.value(i))) keep(i);
+        }
+    } else {
+        sparkDownsample(s, n, target, keep);
+    }
+
+    if (st.envelope && n > st.w && st.w <= MAX_SPARK_POINTS) {
+        g.columns = st.w;
+        for (int c = 0; c < g.columns; ++c) {
+            g.bandTop[c]    = INT16_MAX;
+            g.bandBottom[c] = INT16_MIN;
+        }
+        for (int i = 0; i < n; ++i) {
+            float v = s.value(i);
+            if (isnan(v)) continue;
+            int16_t c = px(i), y = py(v);
+            if (y < g.bandTop[c])    g.bandTop[c]    = y;
+            if (y > g.bandBottom[c]) g.bandBottom[c] = y;
+        }
+    }
+
+    for (int i = n - 1; i >= 0 && g.ticks < MAX_SPARK_TICKS; i -= st.tickEvery) {
+        g.tickX[g.ticks] = px(i);
+        tsToLabel(s.ts(i), g.tickLabel[g.ticks]);
+        g.ticks++;
+    }
+
+    s.formatValue(g.maxLabel, sizeof(g.maxLabel), vMax);
+    s.formatValue(g.minLabel, sizeof(g.minLabel), vMin);
+}
+
+// Rows of the rasterised block: frame plus ticks. drawSparkGeometry()
+// always paints the whole st.w x sparkRows() block (background included),
+// so callers only need to clear around it.
+inline int sparkRows(const SparkStyle &st)
+{
+    return st.h + SPARK_TICK_LEN + 1;
+}
+
+// Draws `g` with its frame's top-left at (x0, y0). Returns the height of
+// everything drawn below y0 (frame, ticks and labels).
+int drawSparkGeometry(Display &gfx, int x0, int y0, const SparkGeometry &g,
+                      const SparkStyle &st);
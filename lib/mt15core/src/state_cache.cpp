@@ -0,0 +1,231 @@
+#include "state_cache.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "meraki_fetch.h"
+#include "platform.h"
+#include "snapshot.h"
+
+bool g_stateFromCache = false;
+
+static const uint8_t STATE_CACHE_MAGIC[4] = { 'M', 'T', '1', '5' };
+
+static uint32_t      g_savedCrc = 0;                      // CRC of the blob on flash
+static bool          g_saved    = false;                  // written since boot
+static unsigned long g_savedAt  = 0;
+
+static uint32_t crc32(const uint8_t *p, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// ==== ENCODE ====
+
+struct BlobWriter {
+    uint8_t *p, *end;
+    bool     ok;
+
+    void put(const void *data, size_t len)
+    {
+        if (!ok || (size_t)(end - p) < len) {
+            ok = false;
+            return;
+        }
+        memcpy(p, data, len);
+        p += len;
+    }
+    template <class T> void put(T v) { put(&v, sizeof(v)); }
+};
+
+size_t encodeStateCache(uint8_t *buf, size_t size, int maxBuckets)
+{
+    if (size < sizeof(StateCacheHeader)) return 0;
+    BlobWriter w = { buf + sizeof(StateCacheHeader), buf + size, true };
+
+    for (int m = 0; m < METRIC_COUNT; ++m) w.put((float)g_latest[m]);
+
+    const HistoryRing &h = g_history;
+    int first = h.count > maxBuckets ? h.count - maxBuckets : 0;
+    w.put((uint16_t)(h.count - first));
+    for (int i = first; i < h.count; ++i) {
+        w.put(historyTs(h, i));
+        w.put(h.value[historySlot(h, i)], sizeof(h.value[0]));
+    }
+
+    const SensorStore &s = g_sensors;
+    int n = s.count;
+    w.put((uint16_t)n);
+    w.put((uint8_t)s.networkCount);
+    for (int i = 0; i < s.networkCount; ++i) {
+        w.put(s.networkName[i], strlen(s.networkName[i]) + 1);
+    }
+    w.put(s.serial, n * sizeof(s.serial[0]));
+    w.put(s.network, n * sizeof(s.network[0]));
+    w.put(s.ts, n * sizeof(s.ts[0]));
+    for (int m = 0; m < METRIC_COUNT; ++m) w.put(s.reading[m], n * sizeof(s.reading[m][0]));
+
+    if (!w.ok) return 0;
+
+    StateCacheHeader hdr;
+    memcpy(hdr.magic, STATE_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version     = STATE_CACHE_VERSION;
+    hdr.metricCount = METRIC_COUNT;
+    hdr.interval    = HISTORY_INTERVAL_S;
+    hdr.payloadLen  = (uint32_t)(w.p - buf - sizeof(hdr));
+    hdr.crc         = crc32(buf + sizeof(hdr), hdr.payloadLen);
+    memcpy(buf, &hdr, sizeof(hdr));
+    return sizeof(hdr) + hdr.payloadLen;
+}
+
+// ==== DECODE ====
+
+struct BlobReader {
+    const uint8_t *p, *end;
+    bool           ok;
+
+    void get(void *data, size_t len)
+    {
+        if (!ok || (size_t)(end - p) < len) {
+            ok = false;
+            return;
+        }
+        memcpy(data, p, len);
+        p += len;
+    }
+    template <class T> T get()
+    {
+        T v = T();
+        get(&v, sizeof(v));
+        return v;
+    }
+};
+
+bool decodeStateCache(const uint8_t *buf, size_t len, bool mergeHistory)
+{
+    StateCacheHeader hdr;
+    if (len < sizeof(hdr)) return false;
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (memcmp(hdr.magic, STATE_CACHE_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != STATE_CACHE_VERSION || hdr.metricCount != METRIC_COUNT ||
+        hdr.interval != HISTORY_INTERVAL_S ||
+        hdr.payloadLen > len - sizeof(hdr) ||
+        crc32(buf + sizeof(hdr), hdr.payloadLen) != hdr.crc) {
+        return false;
+    }
+    BlobReader r = { buf + sizeof(hdr), buf + sizeof(hdr) + hdr.payloadLen, true };
+
+    // Decode into scratch copies; the working state only changes once the
+    // whole blob has checked out.
+    ArenaScope scope(g_fetchArena);
+    double      *latest   = (double *)g_fetchArena.alloc(sizeof(g_latest));
+    HistoryRing *histPtr  = g_fetchArena.make<HistoryRing>();
+    SensorStore *storePtr = g_fetchArena.make<SensorStore>();
+    if (!latest || !histPtr || !storePtr) return false;
+    HistoryRing &hist  = *histPtr;
+    SensorStore &store = *storePtr;
+
+    for (int m = 0; m < METRIC_COUNT; ++m) latest[m] = r.get<float>();
+
+    hist.head  = 0;
+    hist.count = r.get<uint16_t>();
+    if (hist.count > MAX_HISTORY_POINTS) return false;
+    for (int i = 0; i < hist.count; ++i) {
+        hist.startTs[i] = r.get<uint32_t>();
+        r.get(hist.value[i], sizeof(hist.value[i]));
+    }
+
+    int n = r.get<uint16_t>();
+    int networks = r.get<uint8_t>();
+    if (n > MAX_SENSORS || networks > MAX_NETWORKS) return false;
+    store.count = n;
+    store.networkCount = networks;
+    for (int i = 0; i < networks && r.ok; ++i) {
+        const uint8_t *nul = (const uint8_t *)memchr(r.p, '\0', r.end - r.p);
+        if (!nul || nul - r.p >= NETWORK_NAME_LEN) return false;
+        r.get(store.networkName[i], nul - r.p + 1);
+    }
+    r.get(store.serial, n * sizeof(store.serial[0]));
+    r.get(store.network, n * sizeof(store.network[0]));
+    r.get(store.ts, n * sizeof(store.ts[0]));
+    for (int m = 0; m < METRIC_COUNT; ++m) r.get(store.reading[m], n * sizeof(store.reading[m][0]));
+    if (!r.ok) return false;
+
+    for (int i = 0; i < n; ++i) {
+        store.serial[i][SERIAL_LEN - 1] = '\0';
+        if (store.network[i] >= networks) store.network[i] = NETWORK_NONE;
+    }
+
+    memcpy(g_latest, latest, sizeof(g_latest));
+    if (!mergeHistory) {
+        copyHistory(g_history, hist);
+    } else {
+        for (int i = 0; i < hist.count; ++i) {
+            int at = historyUpsert(g_history, hist.startTs[i]);
+            if (at < 0) continue;   // older than a full ring
+            memcpy(g_history.value[historySlot(g_history, at)], hist.value[i], sizeof(hist.value[i]));
+        }
+    }
+    copySensorStore(g_sensors, store);
+    return true;
+}
+
+// ==== FLASH ====
+
+bool loadStateCache()
+{
+    ArenaScope scope(g_fetchArena);
+    uint8_t *buf = (uint8_t *)g_fetchArena.alloc(MAX_STATE_CACHE_BYTES);
+    if (!buf) return false;
+
+    long len = platformLoadBlob(STATE_CACHE_BLOB, buf, MAX_STATE_CACHE_BYTES);
+    if (len < 0) return false;
+    if (!decodeStateCache(buf, (size_t)len)) {
+        platformLog("[cache] ignoring invalid or outdated blob (%ld bytes)\n", len);
+        return false;
+    }
+
+    StateCacheHeader hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+    g_savedCrc = hdr.crc;
+
+    g_stateFromCache = true;
+    if (g_history.count > 0) g_historyNeedsFull = false;
+    platformLog("[cache] restored %d buckets, %d sensors (%ld bytes)\n",
+                g_history.count, g_sensors.count, len);
+    return true;
+}
+
+bool saveStateCache()
+{
+    ArenaScope scope(g_fetchArena);
+    uint8_t *buf = (uint8_t *)g_fetchArena.alloc(MAX_STATE_CACHE_BYTES);
+    if (!buf) return false;
+
+    size_t len = encodeStateCache(buf, MAX_STATE_CACHE_BYTES);
+    if (len == 0) {
+        platformLog("[cache] state doesn't fit in %u bytes\n", (unsigned)MAX_STATE_CACHE_BYTES);
+        return false;
+    }
+
+    StateCacheHeader hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (hdr.crc == g_savedCrc) return false;
+    if (g_saved && platformMillis() - g_savedAt < STATE_CACHE_SAVE_INTERVAL_MS) return false;
+
+    unsigned long t0 = platformMillis();
+    if (!platformSaveBlob(STATE_CACHE_BLOB, buf, len)) {
+        platformLog("[cache] write failed\n");
+        return false;
+    }
+    g_savedCrc = hdr.crc;
+    g_saved    = true;
+    g_savedAt  = platformMillis();
+    platformLog("[cache] wrote %u bytes in %lu ms\n", (unsigned)len, g_savedAt - t0);
+    return true;
+}
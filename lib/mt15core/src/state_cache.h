@@ -0,0 +1,76 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "history.h"
+#include "sensor_store.h"
+
+// Boot cache: the fetch side's working state (g_latest, g_history,
+// g_sensors) as one compact, versioned blob, so the first frame after a
+// power blip shows the last data we had instead of dashes while WiFi and
+// the first fetches are still going.
+//
+// Layout, little-endian (both the ESP32 and our hosts are):
+//   header    "MT15", version, METRIC_COUNT, history bucket length,
+//             payload bytes, CRC-32 of payload
+//   latest    METRIC_COUNT floats
+//   history   bucket count, then oldest first: startTs + the ring's
+//             METRIC_COUNT fixed-point averages
+//   sensors   sensor count, network names (NUL-terminated), then the
+//             store's columns for the used rows only: serials, network
+//             indices, timestamps, one int16 column per metric
+//
+// A blob with another version, metric count or bucket length is ignored,
+// not migrated: the next fetch rebuilds everything anyway.
+//
+// Hub mode (hub.h) sends the same blobs over the LAN, some with only the
+// newest history buckets.
+const uint16_t STATE_CACHE_VERSION = 2;
+const char     STATE_CACHE_BLOB[]  = "state";
+
+struct StateCacheHeader {
+    uint8_t  magic[4];
+    uint16_t version;
+    uint16_t metricCount;
+    uint32_t interval;
+    uint32_t payloadLen;
+    uint32_t crc;
+};
+
+// Header + latest + full history + full store
+const size_t MAX_STATE_CACHE_BYTES =
+    sizeof(StateCacheHeader) + METRIC_COUNT * sizeof(float) +
+    2 + MAX_HISTORY_POINTS * (4 + METRIC_COUNT * 2) +
+    3 + MAX_NETWORKS * NETWORK_NAME_LEN + MAX_SENSORS * (SERIAL_LEN + 1 + 4 + METRIC_COUNT * 2);
+
+// Fetch arena use at its peak, loading: the blob plus scratch copies of
+// everything it restores
+const size_t STATE_CACHE_ARENA_BYTES = arenaBytes(
+    MAX_STATE_CACHE_BYTES + sizeof(double) * METRIC_COUNT + sizeof(HistoryRing) +
+    sizeof(SensorStore), 4);
+
+// Flash wear cap: live readings change every refresh, so changed state is
+// written at most this often (about 1 MB/day at 200 sensors).
+const unsigned long STATE_CACHE_SAVE_INTERVAL_MS = 15 * 60 * 1000UL;
+
+// Working state came from the cache and no fetch has replaced it yet
+extern bool g_stateFromCache;
+
+// Serialises the working state into `buf`, history limited to the newest
+// `maxBuckets`. Returns its length, 0 if it doesn't fit.
+size_t encodeStateCache(uint8_t *buf, size_t size, int maxBuckets = MAX_HISTORY_POINTS);
+
+// Validates a blob and only then installs it into the working state. With
+// `mergeHistory` its buckets are merged into g_history instead of
+// replacing it (for blobs that carry only the newest few).
+bool decodeStateCache(const uint8_t *buf, size_t len, bool mergeHistory = false);
+
+// Boot: restores the working state from flash. On success history goes
+// straight to incremental refreshes (a gap since the blob was written is
+// caught by the usual merge check).
+bool loadStateCache();
+
+// Fetch side, after each refresh: writes the state if it differs from what
+// is on flash and the last write is STATE_CACHE_SAVE_INTERVAL_MS old.
+// Returns true if it wrote.
+bool saveStateCache();
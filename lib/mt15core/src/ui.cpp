@@ -0,0 +1,756 @@
+#include "ui.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "glyph_atlas.h"
+#include "metrics.h"
+#include "sparkline.h"
+#include "mt15_icon.h"   // provides mt15_icon_map[] (RGB565, 160x100)
+
+int g_currentPage    = PAGE_LIVE;
+int g_overviewScroll = 0;
+
+Display *g_canvas      = NULL;
+bool     g_trackDamage = false;
+Rect     g_damage[MAX_DAMAGE];
+int      g_damageCount = 0;
+
+enum WidgetId {
+    WID_ICON,
+    WID_TITLE,
+    WID_WIFI,                                   // status badge
+    WID_SOURCE,                                 // cached-data note
+    WID_ALERT,                                  // alert banner
+    WID_LABEL_FIRST,                            // one per MetricId
+    WID_VALUE_FIRST = WID_LABEL_FIRST + METRIC_COUNT,
+    WID_HIST_TITLE  = WID_VALUE_FIRST + METRIC_COUNT,
+    WID_HIST_PLOT,                              // sparkline + axis labels
+    WID_OVERVIEW,                               // whole sensor table
+    WID_DIAG,                                   // whole diagnostics page
+    WID_COUNT
+};
+
+// Pages sharing a group share widgets; all history pages use one title and
+// one plot, so swiping between them only redraws those two.
+enum WidgetGroup {
+    GROUP_LIVE     = 0,
+    GROUP_HISTORY  = 1,
+    GROUP_OVERVIEW = 2,
+    GROUP_DIAG     = 3
+};
+
+struct Widget {
+    int16_t  x, y;
+    int16_t  w, h;          // extent currently drawn (0 = nothing)
+    uint8_t  group;
+    bool     onScreen;
+    uint32_t key;           // content hash of what is drawn
+};
+
+static Widget g_widgets[WID_COUNT];
+
+static inline int pageGroup(int page)
+{
+    if (page == PAGE_LIVE)     return GROUP_LIVE;
+    if (page == PAGE_OVERVIEW) return GROUP_OVERVIEW;
+    if (page == PAGE_DIAG)     return GROUP_DIAG;
+    return GROUP_HISTORY;
+}
+
+uint32_t contentHash(const void *data, size_t len, uint32_t h)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void addDamage(int x, int y, int w, int h)
+{
+    if (!g_trackDamage || w <= 0 || h <= 0) return;
+
+    if (g_damageCount < MAX_DAMAGE) {
+        g_damage[g_damageCount++] = { (int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h };
+        return;
+    }
+
+    // Out of slots: grow the last rectangle to cover this one too
+    Rect &r = g_damage[MAX_DAMAGE - 1];
+    int x1 = std::max(r.x + r.w, x + w);
+    int y1 = std::max(r.y + r.h, y + h);
+    r.x = std::min((int)r.x, x);
+    r.y = std::min((int)r.y, y);
+    r.w = x1 - r.x;
+    r.h = y1 - r.y;
+}
+
+static void initWidget(int id, int group, int x, int y)
+{
+    Widget &wg = g_widgets[id];
+    wg.x = x;
+    wg.y = y;
+    wg.w = wg.h = 0;
+    wg.group = group;
+    wg.onScreen = false;
+    wg.key = 0;
+}
+
+void initWidgets()
+{
+    initWidget(WID_ICON,  GROUP_LIVE, ICON_X, ICON_Y);
+    initWidget(WID_TITLE, GROUP_LIVE, TITLE_X, TITLE_Y);
+    initWidget(WID_WIFI,  GROUP_LIVE, WIFI_STATUS_X, WIFI_STATUS_Y);
+    initWidget(WID_SOURCE, GROUP_LIVE, SOURCE_X, SOURCE_Y);
+    initWidget(WID_ALERT,  GROUP_LIVE, ALERT_X, ALERT_Y);
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        int x = (m % METRIC_COLS) * METRIC_COL_W;
+        int y = METRIC_BASE_Y + (m / METRIC_COLS) * METRIC_LINE_H;
+        initWidget(WID_LABEL_FIRST + m, GROUP_LIVE, x + METRIC_LABEL_X, y + METRIC_LABEL_DY);
+        initWidget(WID_VALUE_FIRST + m, GROUP_LIVE, x + METRIC_VALUE_X, y);
+    }
+    initWidget(WID_HIST_TITLE, GROUP_HISTORY, HIST_TITLE_X, HIST_TITLE_Y);
+    initWidget(WID_HIST_PLOT,  GROUP_HISTORY, HIST_AREA_X, HIST_AREA_Y);
+    initWidget(WID_OVERVIEW,   GROUP_OVERVIEW, 0, 0);
+    initWidget(WID_DIAG,       GROUP_DIAG, 0, 0);
+}
+
+// Clears whatever the widget has drawn.
+static void widgetErase(Widget &wg)
+{
+    if (wg.onScreen && wg.w > 0 && wg.h > 0) {
+        g_canvas->fillRect(wg.x, wg.y, wg.w, wg.h, COLOR_BLACK);
+        addDamage(wg.x, wg.y, wg.w, wg.h);
+    }
+    wg.onScreen = false;
+    wg.w = wg.h = 0;
+}
+
+// Text widget (labels, values, status badge). The glyphs are drawn with an
+// opaque background, so only the tail of a longer previous string needs
+// clearing.
+static void widgetText(int id, const char *text, uint16_t color, int size)
+{
+    Widget &wg = g_widgets[id];
+    uint32_t key = contentHash(text, strlen(text), color ^ ((uint32_t)size << 16));
+    if (wg.onScreen && wg.key == key) return;
+
+    Display &gfx = *g_canvas;
+    int w = gfx.textWidth(text, size);
+    int h = 8 * size;
+    gfx.drawText(text, wg.x, wg.y, size, color, COLOR_BLACK);
+
+    int oldW = wg.onScreen ? wg.w : 0;
+    int oldH = wg.onScreen ? wg.h : 0;
+    if (oldW > w) gfx.fillRect(wg.x + w, wg.y, oldW - w, oldH, COLOR_BLACK);
+    if (oldH > h) gfx.fillRect(wg.x, wg.y + h, w, oldH - h, COLOR_BLACK);
+    addDamage(wg.x, wg.y, std::max(w, oldW), std::max(h, oldH));
+
+    wg.w = w;
+    wg.h = h;
+    wg.key = key;
+    wg.onScreen = true;
+}
+
+// Large readout (live values): the value in READOUT_SIZE glyphs, then its
+// unit a size smaller on the same baseline. The widget remembers which
+// cell each character went into; a new value only pushes the cells whose
+// glyph, face or position changed, so 22.51 -> 22.52 C is one glyph. The
+// strips above and below the unit's shorter cells and the gap before it
+// are cells too, cleared when their column range changes.
+const int READOUT_MAX_CELLS = 16;
+
+struct ReadoutCell {
+    int16_t          x;
+    uint8_t          w;
+    int8_t           dy;      // cell top below the widget's
+    int8_t           glyph;
+    const GlyphFace *face;    // NULL = blank
+};
+
+struct Readout {
+    int         count;
+    ReadoutCell cell[READOUT_MAX_CELLS];
+};
+
+static Readout g_readouts[METRIC_COUNT];   // WID_VALUE_FIRST + MetricId
+
+static void readoutCell(Readout &r, int &x, const GlyphFace *face, int dy, int glyph, int w)
+{
+    if (r.count == READOUT_MAX_CELLS) return;
+    r.cell[r.count++] = { (int16_t)x, (uint8_t)w, (int8_t)dy, (int8_t)glyph, face };
+    x += w;
+}
+
+static inline bool sameCell(const ReadoutCell &a, const ReadoutCell &b)
+{
+    return a.x == b.x && a.w == b.w && a.dy == b.dy && a.glyph == b.glyph && a.face == b.face;
+}
+
+// One cell over the widget's full height
+static void drawReadoutCell(const Widget &wg, const ReadoutCell &c, int h)
+{
+    Display &gfx = *g_canvas;
+    if (!c.face) {
+        gfx.fillRect(c.x, wg.y, c.w, h, COLOR_BLACK);
+        return;
+    }
+    int bottom = c.dy + c.face->height;
+    gfx.pushImage(c.x, wg.y + c.dy, c.w, c.face->height, glyphCell(*c.face, c.glyph));
+    if (c.dy > 0)     gfx.fillRect(c.x, wg.y, c.w, c.dy, COLOR_BLACK);
+    if (bottom < h)   gfx.fillRect(c.x, wg.y + bottom, c.w, h - bottom, COLOR_BLACK);
+}
+
+static void widgetReadout(int id, const char *value, const char *unit, uint16_t color)
+{
+    Widget  &wg  = g_widgets[id];
+    Readout &old = g_readouts[id - WID_VALUE_FIRST];
+    uint32_t key = contentHash(unit, strlen(unit), contentHash(value, strlen(value), color));
+    if (wg.onScreen && wg.key == key) return;
+
+    const GlyphFace *digits = glyphFace(READOUT_SIZE, color, COLOR_BLACK);
+    const GlyphFace *units  = glyphFace(READOUT_UNIT_SIZE, color, COLOR_BLACK);
+    if (!digits || !units) {
+        // No memory for the atlas: doubled GLCD text instead
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%s %s", value, unit);
+        old.count = 0;
+        widgetText(id, buf, color, 2);
+        return;
+    }
+    if (!wg.onScreen) old.count = 0;
+
+    Readout next;
+    next.count = 0;
+    int x  = wg.x;
+    int dy = digits->baseline - units->baseline;
+    for (const char *p = value; *p; ++p) {
+        int g = glyphIndex(*p);
+        readoutCell(next, x, digits, 0, g, digits->advance[g]);
+    }
+    readoutCell(next, x, NULL, 0, 0, READOUT_UNIT_GAP);
+    for (const char *p = unit; *p; ++p) {
+        int g = glyphIndex(*p);
+        readoutCell(next, x, units, dy, g, units->advance[g]);
+    }
+
+    // Changed cells, with neighbours merged into one damage rectangle
+    int h = digits->height;
+    int runX = 0, runEnd = 0;
+    for (int i = 0; i < next.count; ++i) {
+        const ReadoutCell &c = next.cell[i];
+        if (i < old.count && sameCell(c, old.cell[i])) continue;
+        drawReadoutCell(wg, c, h);
+        if (c.x != runEnd) {
+            addDamage(runX, wg.y, runEnd - runX, h);
+            runX = c.x;
+        }
+        runEnd = c.x + c.w;
+    }
+    addDamage(runX, wg.y, runEnd - runX, h);
+
+    int w    = x - wg.x;
+    int oldW = wg.onScreen ? wg.w : 0;
+    int oldH = wg.onScreen ? wg.h : 0;
+    if (oldW > w) {
+        g_canvas->fillRect(x, wg.y, oldW - w, oldH, COLOR_BLACK);
+        addDamage(x, wg.y, oldW - w, oldH);
+    }
+
+    old = next;
+    wg.w = w;
+    wg.h = h;
+    wg.key = key;
+    wg.onScreen = true;
+}
+
+// Alert banner: the first ALERT_LINES raised rules, each with how long its
+// metric has been beyond the trip level ("CO2 high 25m"). Redrawn when an
+// alert comes or goes or a duration ticks over; nothing when all is well.
+static void widgetAlerts(int id, const AnalyticsSummary &a)
+{
+    Widget &wg = g_widgets[id];
+    char    lines[ALERT_LINES][24] = {};
+    int     n = 0;
+    for (int r = 0; r < ALERT_RULE_COUNT && n < ALERT_LINES; ++r) {
+        if (!(a.alertMask & (1u << r))) continue;
+        unsigned long min = (a.ts - a.alertSince[r]) / 60;
+        if (min < 100) snprintf(lines[n], sizeof(lines[n]), "%s %lum", ALERT_RULES[r].text, min);
+        else           snprintf(lines[n], sizeof(lines[n]), "%s %luh", ALERT_RULES[r].text, min / 60);
+        n++;
+    }
+    uint32_t key = contentHash(lines, sizeof(lines), n);
+    if (wg.onScreen && wg.key == key) return;
+
+    widgetErase(wg);
+    if (n) {
+        Display &gfx = *g_canvas;
+        int h = n * ALERT_LINE_H + 1;
+        gfx.fillRect(wg.x, wg.y, ALERT_W, h, COLOR_RED);
+        for (int i = 0; i < n; ++i) {
+            gfx.drawText(lines[i], wg.x + 3, wg.y + 2 + i * ALERT_LINE_H, 1, COLOR_WHITE, COLOR_RED);
+        }
+        addDamage(wg.x, wg.y, ALERT_W, h);
+        wg.w = ALERT_W;
+        wg.h = h;
+    }
+    wg.key = key;
+    wg.onScreen = true;
+}
+
+// Fixed image; drawn once when its page group comes on screen.
+static void widgetImage(int id, int w, int h, const uint16_t *pixels)
+{
+    Widget &wg = g_widgets[id];
+    if (wg.onScreen) return;
+
+    g_canvas->pushImage(wg.x, wg.y, w, h, pixels);
+    addDamage(wg.x, wg.y, w, h);
+    wg.w = w;
+    wg.h = h;
+    wg.key = 0;
+    wg.onScreen = true;
+}
+
+// One metric of the history ring, as a sparkline series
+struct HistorySeries {
+    const HistoryRing &hist;
+    int                metric;
+
+    int      size() const { return hist.count; }
+    float    value(int i) const { return historyValue(hist, metric, i); }
+    uint32_t ts(int i) const { return historyTs(hist, i); }
+    void     formatValue(char *buf, size_t size, float v) const
+    {
+        formatMetricShort(buf, size, metric, v);
+    }
+};
+
+static const SparkStyle HISTORY_SPARK = {
+    HIST_PLOT_W, HIST_PLOT_H,
+    0.0f,                                        // margin: per metric
+    (int16_t)(7 * 86400 / HISTORY_INTERVAL_S),   // weekly ticks
+    true,                                        // band (hourly and finer)
+    COLOR_CYAN, COLOR_DARKCYAN, COLOR_DARKGREY, COLOR_DARKGREY, COLOR_WHITE, COLOR_BLACK
+};
+
+// Geometry per metric, rebuilt only when that metric's history or the plot
+// width changes
+static SparkGeometry g_sparkGeom[METRIC_COUNT];
+static uint32_t      g_sparkKey[METRIC_COUNT];
+static bool          g_sparkBuilt[METRIC_COUNT];
+
+int drawSparkline(Display &gfx, int x0, int y0, int metric, const HistoryRing &hist)
+{
+    SparkStyle style = HISTORY_SPARK;
+    style.margin = METRICS[metric].margin;
+
+    uint32_t key = contentHash(&style.w, sizeof(style.w), historyKey(metric, hist));
+    if (!g_sparkBuilt[metric] || g_sparkKey[metric] != key) {
+        HistorySeries series = { hist, metric };
+        buildSparkGeometry(g_sparkGeom[metric], series, style);
+        g_sparkKey[metric]   = key;
+        g_sparkBuilt[metric] = true;
+    }
+    return drawSparkGeometry(gfx, x0, y0, g_sparkGeom[metric], style);
+}
+
+uint32_t historyKey(int metric, const HistoryRing &hist)
+{
+    uint32_t key = contentHash(&metric, sizeof(metric));
+    for (int i = 0; i < hist.count; ++i) {
+        uint32_t ts = historyTs(hist, i);
+        int16_t  v  = hist.value[historySlot(hist, i)][metric];
+        key = contentHash(&ts, sizeof(ts), key);
+        key = contentHash(&v, sizeof(v), key);
+    }
+    return key;
+}
+
+// Sparkline widget. Keyed on the metric and every bucket it plots, so a
+// refresh that didn't change this metric's history leaves the plot alone.
+static void widgetSparkline(int id, int metric, const HistoryRing &hist)
+{
+    Widget &wg = g_widgets[id];
+
+    uint32_t key = historyKey(metric, hist);
+    if (wg.onScreen && wg.key == key) return;
+
+    // The plot block repaints itself; only the labels around it need
+    // clearing
+    int oldH = 0;
+    if (wg.onScreen) {
+        int rows = sparkRows(HISTORY_SPARK);
+        oldH = wg.h;
+        g_canvas->fillRect(wg.x + HIST_PLOT_W, wg.y, wg.w - HIST_PLOT_W, oldH, COLOR_BLACK);
+        if (oldH > rows) {
+            g_canvas->fillRect(wg.x, wg.y + rows, HIST_PLOT_W, oldH - rows, COLOR_BLACK);
+        }
+    }
+    wg.h = drawSparkline(*g_canvas, wg.x, wg.y, metric, hist);
+    wg.w = SCREEN_W - wg.x;   // tick labels are clamped to the screen edge
+    addDamage(wg.x, wg.y, wg.w, std::max((int)wg.h, oldH));
+    wg.key = key;
+    wg.onScreen = true;
+}
+
+// ==== OVERVIEW ====
+
+const int OVERVIEW_SERIAL_X   = 4;
+const int OVERVIEW_NETWORK_X  = 94;
+const int OVERVIEW_NETWORK_CH = 12;   // characters shown of the network name
+
+static int maxOverviewScroll(const SensorStore &sensors)
+{
+    return std::max(0, (int)sensors.count - OVERVIEW_ROWS);
+}
+
+bool scrollOverview(int rows, const SensorStore &sensors)
+{
+    int next = std::min(std::max(g_overviewScroll + rows, 0), maxOverviewScroll(sensors));
+    if (next == g_overviewScroll) return false;
+    g_overviewScroll = next;
+    return true;
+}
+
+static uint32_t newestReadingTs(const SensorStore &sensors)
+{
+    uint32_t newest = 0;
+    for (int i = 0; i < sensors.count; ++i) newest = std::max(newest, sensors.ts[i]);
+    return newest;
+}
+
+uint32_t overviewKey(const SensorStore &sensors, int first)
+{
+    first = std::min(first, maxOverviewScroll(sensors));
+    int last = std::min((int)sensors.count, first + OVERVIEW_ROWS);
+    int rows = last - first;
+
+    uint32_t newest = newestReadingTs(sensors);
+    uint32_t key = contentHash(&sensors.count, sizeof(sensors.count));
+    key = contentHash(&first, sizeof(first), key);
+    key = contentHash(&newest, sizeof(newest), key);
+    if (rows <= 0) return key;
+
+    // Column by column, matching the store's layout
+    key = contentHash(sensors.serial[first], rows * sizeof(sensors.serial[0]), key);
+    key = contentHash(&sensors.network[first], rows * sizeof(sensors.network[0]), key);
+    key = contentHash(&sensors.ts[first], rows * sizeof(sensors.ts[0]), key);
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        if (!METRICS[m].overviewHeader) continue;
+        const int16_t *col = sensors.reading[m];
+        key = contentHash(&col[first], rows * sizeof(col[0]), key);
+    }
+    for (int n = 0; n < sensors.networkCount; ++n) {
+        key = contentHash(sensors.networkName[n], strlen(sensors.networkName[n]), key);
+    }
+    return key;
+}
+
+// Draws the table onto whatever is there; callers clear first.
+static void drawOverview(Display &gfx, const SensorStore &sensors, int first)
+{
+    first = std::min(first, maxOverviewScroll(sensors));
+    int last = std::min((int)sensors.count, first + OVERVIEW_ROWS);
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "Sensors (%u)", (unsigned)sensors.count);
+    gfx.drawText(buf, OVERVIEW_TITLE_X, OVERVIEW_TITLE_Y, 2, COLOR_WHITE, COLOR_BLACK);
+    if (sensors.count > OVERVIEW_ROWS) {
+        snprintf(buf, sizeof(buf), "%d-%d", first + 1, last);
+        gfx.drawText(buf, SCREEN_W - 4 - gfx.textWidth(buf, 1), OVERVIEW_TITLE_Y + 4, 1,
+                     COLOR_DARKGREY, COLOR_BLACK);
+    }
+
+    if (sensors.count == 0) {
+        gfx.drawText("No sensors yet", OVERVIEW_SERIAL_X, OVERVIEW_ROW_Y, 1,
+                     COLOR_WHITE, COLOR_BLACK);
+        return;
+    }
+
+    gfx.drawText("Serial",  OVERVIEW_SERIAL_X,  OVERVIEW_HEADER_Y, 1, COLOR_DARKGREY, COLOR_BLACK);
+    gfx.drawText("Network", OVERVIEW_NETWORK_X, OVERVIEW_HEADER_Y, 1, COLOR_DARKGREY, COLOR_BLACK);
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        const MetricDesc &d = METRICS[m];
+        if (!d.overviewHeader) continue;
+        gfx.drawText(d.overviewHeader, d.overviewX, OVERVIEW_HEADER_Y, 1,
+                     COLOR_DARKGREY, COLOR_BLACK);
+    }
+
+    uint32_t newest = newestReadingTs(sensors);
+    for (int i = first; i < last; ++i) {
+        int y = OVERVIEW_ROW_Y + (i - first) * OVERVIEW_ROW_H;
+        bool stale = sensors.ts[i] + SENSOR_STALE_S < newest;
+        uint16_t fg = stale ? COLOR_DARKGREY : COLOR_WHITE;
+
+        gfx.drawText(sensors.serial[i], OVERVIEW_SERIAL_X, y, 1, fg, COLOR_BLACK);
+        if (sensors.network[i] != NETWORK_NONE) {
+            snprintf(buf, sizeof(buf), "%.*s", OVERVIEW_NETWORK_CH,
+                     sensors.networkName[sensors.network[i]]);
+            gfx.drawText(buf, OVERVIEW_NETWORK_X, y, 1, fg, COLOR_BLACK);
+        }
+
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            const MetricDesc &d = METRICS[m];
+            if (!d.overviewHeader) continue;
+            float v = sensorReading(sensors, m, i);
+            formatMetricShort(buf, sizeof(buf), m, v);
+            uint16_t color = isnan(v) || stale ? COLOR_DARKGREY : COLOR_GREEN;
+            gfx.drawText(buf, d.overviewX, y, 1, color, COLOR_BLACK);
+        }
+    }
+}
+
+// Table widget. Any change to the visible rows or the scroll position
+// redraws the lot; it only happens once per refresh or scroll step.
+static void widgetOverview(int id, const SensorStore &sensors, int first)
+{
+    Widget &wg = g_widgets[id];
+
+    uint32_t key = overviewKey(sensors, first);
+    if (wg.onScreen && wg.key == key) return;
+
+    widgetErase(wg);
+    drawOverview(*g_canvas, sensors, first);
+    wg.w = SCREEN_W;
+    wg.h = SCREEN_H;
+    addDamage(wg.x, wg.y, wg.w, wg.h);
+    wg.key = key;
+    wg.onScreen = true;
+}
+
+void renderOverviewCanvas(Display &gfx, const SensorStore &sensors, int first)
+{
+    gfx.fillRect(0, 0, SCREEN_W, SCREEN_H, COLOR_BLACK);
+    drawOverview(gfx, sensors, first);
+}
+
+// ==== DIAGNOSTICS ====
+
+const int DIAG_STAGE_X = 4;
+const int DIAG_COUNT_X = 100;
+const int DIAG_MIN_X   = 136;
+const int DIAG_AVG_X   = 196;
+const int DIAG_P95_X   = 256;
+const int DIAG_VALUE_X = 100;
+const int DIAG_LOW_X   = 196;   // lowest / worst seen
+const int DIAG_WAKE_X  = 142;   // loop wake-ups, beside the title
+
+struct DiagInfo {
+    PerfSummary perf[PERF_STAGE_COUNT];
+    MemStats    mem;   // lows and highs from the fetch side, the rest live
+    FrameStats  frames;
+};
+
+static void collectDiag(DiagInfo &d, const SensorSnapshot &snap)
+{
+    memset(&d, 0, sizeof(d));   // padding too: the whole struct is hashed
+    for (int st = 0; st < PERF_STAGE_COUNT; ++st) {
+        d.perf[st] = st < PERF_FETCH_STAGES ? snap.perf[st] : perfSummary(g_perf[st]);
+    }
+    d.mem    = snap.mem;
+    d.frames = g_frameStats;
+    d.mem.freeHeap     = (uint32_t)platformFreeHeap();
+    d.mem.largestBlock = (uint32_t)platformLargestFreeBlock();
+    if (d.mem.freeHeap) {
+        d.mem.fragPct = (uint8_t)(100 - (uint64_t)d.mem.largestBlock * 100 / d.mem.freeHeap);
+    }
+}
+
+uint32_t diagKey(const SensorSnapshot &snap)
+{
+    DiagInfo d;
+    collectDiag(d, snap);
+    return contentHash(&d, sizeof(d));
+}
+
+// Milliseconds with one decimal; "--" before the first sample
+static void formatMs(char *buf, size_t size, uint32_t us, bool have)
+{
+    if (!have) snprintf(buf, size, "--");
+    else       snprintf(buf, size, "%.1f", us / 1000.0f);
+}
+
+static void formatKb(char *buf, size_t size, uint32_t bytes)
+{
+    if (bytes == 0) snprintf(buf, size, "--");
+    else            snprintf(buf, size, "%lu KB", (unsigned long)(bytes / 1024));
+}
+
+// "<label>  <now>  <lowLabel> <low>", sizes in KB
+static void drawDiagMemRow(Display &gfx, int row, const char *label, uint32_t now,
+                           const char *lowLabel, uint32_t low)
+{
+    char buf[24];
+    int y = DIAG_MEM_Y + row * DIAG_ROW_H;
+    gfx.drawText(label, DIAG_STAGE_X, y, 1, COLOR_WHITE, COLOR_BLACK);
+    formatKb(buf, sizeof(buf), now);
+    gfx.drawText(buf, DIAG_VALUE_X, y, 1, COLOR_GREEN, COLOR_BLACK);
+    if (low == 0) return;
+    char kb[16];
+    formatKb(kb, sizeof(kb), low);
+    snprintf(buf, sizeof(buf), "%s %s", lowLabel, kb);
+    gfx.drawText(buf, DIAG_LOW_X, y, 1, COLOR_DARKGREY, COLOR_BLACK);
+}
+
+static void drawDiag(Display &gfx, const SensorSnapshot &snap)
+{
+    DiagInfo d;
+    collectDiag(d, snap);
+
+    gfx.drawText("Diagnostics", DIAG_TITLE_X, DIAG_TITLE_Y, 2, COLOR_WHITE, COLOR_BLACK);
+
+    char buf[64];
+    const FrameStats &f = d.frames;
+    snprintf(buf, sizeof(buf), "wakes %lu  frames %lu",
+             (unsigned long)f.wakes, (unsigned long)f.frames);
+    gfx.drawText(buf, DIAG_WAKE_X, DIAG_TITLE_Y, 1, COLOR_DARKGREY, COLOR_BLACK);
+    snprintf(buf, sizeof(buf), "tch %lu dat %lu tmr %lu", (unsigned long)f.touchWakes,
+             (unsigned long)f.dataWakes, (unsigned long)f.timerWakes);
+    gfx.drawText(buf, DIAG_WAKE_X, DIAG_TITLE_Y + 9, 1, COLOR_DARKGREY, COLOR_BLACK);
+
+    gfx.drawText("Stage", DIAG_STAGE_X, DIAG_HEADER_Y, 1, COLOR_DARKGREY, COLOR_BLACK);
+    gfx.drawText("n",     DIAG_COUNT_X, DIAG_HEADER_Y, 1, COLOR_DARKGREY, COLOR_BLACK);
+    gfx.drawText("min ms", DIAG_MIN_X,  DIAG_HEADER_Y, 1, COLOR_DARKGREY, COLOR_BLACK);
+    gfx.drawText("avg ms", DIAG_AVG_X,  DIAG_HEADER_Y, 1, COLOR_DARKGREY, COLOR_BLACK);
+    gfx.drawText("p95 ms", DIAG_P95_X,  DIAG_HEADER_Y, 1, COLOR_DARKGREY, COLOR_BLACK);
+
+    for (int st = 0; st < PERF_STAGE_COUNT; ++st) {
+        const PerfSummary &p = d.perf[st];
+        bool have = p.count > 0;
+        uint16_t fg = have ? COLOR_GREEN : COLOR_DARKGREY;
+        int y = DIAG_ROW_Y + st * DIAG_ROW_H;
+
+        gfx.drawText(PERF_STAGE_NAMES[st], DIAG_STAGE_X, y, 1, COLOR_WHITE, COLOR_BLACK);
+        snprintf(buf, sizeof(buf), "%u", (unsigned)p.count);
+        gfx.drawText(buf, DIAG_COUNT_X, y, 1, fg, COLOR_BLACK);
+        formatMs(buf, sizeof(buf), p.minUs, have);
+        gfx.drawText(buf, DIAG_MIN_X, y, 1, fg, COLOR_BLACK);
+        formatMs(buf, sizeof(buf), p.avgUs, have);
+        gfx.drawText(buf, DIAG_AVG_X, y, 1, fg, COLOR_BLACK);
+        formatMs(buf, sizeof(buf), p.p95Us, have);
+        gfx.drawText(buf, DIAG_P95_X, y, 1, fg, COLOR_BLACK);
+    }
+
+    const MemStats &m = d.mem;
+    drawDiagMemRow(gfx, 0, "Free heap", m.freeHeap, "min", m.minFreeHeap);
+    drawDiagMemRow(gfx, 1, "Largest block", m.largestBlock, "min", m.minLargestBlock);
+
+    int y = DIAG_MEM_Y + 2 * DIAG_ROW_H;
+    gfx.drawText("Fragmentation", DIAG_STAGE_X, y, 1, COLOR_WHITE, COLOR_BLACK);
+    if (m.freeHeap) {
+        snprintf(buf, sizeof(buf), "%u%%", (unsigned)m.fragPct);
+        gfx.drawText(buf, DIAG_VALUE_X, y, 1, COLOR_GREEN, COLOR_BLACK);
+        snprintf(buf, sizeof(buf), "max %u%%", (unsigned)m.maxFragPct);
+        gfx.drawText(buf, DIAG_LOW_X, y, 1, COLOR_DARKGREY, COLOR_BLACK);
+    } else {
+        gfx.drawText("--", DIAG_VALUE_X, y, 1, COLOR_GREEN, COLOR_BLACK);
+    }
+
+    y += DIAG_ROW_H;
+    gfx.drawText("Fetch arena", DIAG_STAGE_X, y, 1, COLOR_WHITE, COLOR_BLACK);
+    snprintf(buf, sizeof(buf), "%lu/%lu KB", (unsigned long)(m.arenaHighWater / 1024),
+             (unsigned long)((m.arenaBytes + 1023) / 1024));
+    gfx.drawText(buf, DIAG_VALUE_X, y, 1, m.arenaFailures ? COLOR_RED : COLOR_GREEN,
+                 COLOR_BLACK);
+    if (m.arenaFailures) {
+        snprintf(buf, sizeof(buf), "%lu overflows", (unsigned long)m.arenaFailures);
+        gfx.drawText(buf, DIAG_LOW_X, y, 1, COLOR_RED, COLOR_BLACK);
+    }
+}
+
+// Page-sized widget like the overview; redraws whenever diagKey() moved.
+static void widgetDiag(int id, const SensorSnapshot &snap)
+{
+    Widget &wg = g_widgets[id];
+
+    uint32_t key = diagKey(snap);
+    if (wg.onScreen && wg.key == key) return;
+
+    widgetErase(wg);
+    drawDiag(*g_canvas, snap);
+    wg.w = SCREEN_W;
+    wg.h = SCREEN_H;
+    addDamage(wg.x, wg.y, wg.w, wg.h);
+    wg.key = key;
+    wg.onScreen = true;
+}
+
+void renderDiagCanvas(Display &gfx, const SensorSnapshot &snap)
+{
+    gfx.fillRect(0, 0, SCREEN_W, SCREEN_H, COLOR_BLACK);
+    drawDiag(gfx, snap);
+}
+
+// ==== PAGES ====
+
+void renderLivePage(const SensorSnapshot &snap)
+{
+    widgetImage(WID_ICON, ICON_W, ICON_H, (const uint16_t *)mt15_icon_map);
+    widgetText(WID_TITLE, "Meraki MT15", COLOR_WHITE, 2);
+
+    switch (snap.wifi) {
+    case WIFI_OK:   widgetText(WID_WIFI, "WiFi OK",   COLOR_GREEN,  2); break;
+    case WIFI_FAIL: widgetText(WID_WIFI, "WiFi FAIL", COLOR_RED,    2); break;
+    default:        widgetText(WID_WIFI, "WiFi ...",  COLOR_YELLOW, 2); break;
+    }
+    widgetText(WID_SOURCE, snap.fromCache ? "saved data" : "", COLOR_YELLOW, 1);
+    widgetAlerts(WID_ALERT, snap.analytics);
+
+    // Values of a metric with a raised alert turn red
+    uint16_t color[METRIC_COUNT];
+    for (int m = 0; m < METRIC_COUNT; ++m) color[m] = COLOR_GREEN;
+    for (int r = 0; r < ALERT_RULE_COUNT; ++r) {
+        if (snap.analytics.alertMask & (1u << r)) color[ALERT_RULES[r].metric] = COLOR_RED;
+    }
+
+    char buf[16];
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        widgetText(WID_LABEL_FIRST + m, METRICS[m].label, COLOR_WHITE, 1);
+        formatMetricValue(buf, sizeof(buf), m, snap.latest[m]);
+        widgetReadout(WID_VALUE_FIRST + m, buf, METRICS[m].unit, color[m]);
+    }
+}
+
+static void renderHistoryPage(const SensorSnapshot &snap, int metric)
+{
+    widgetText(WID_HIST_TITLE, METRICS[metric].historyTitle, COLOR_WHITE, 2);
+    widgetSparkline(WID_HIST_PLOT, metric, snap.history);
+}
+
+void renderHistoryCanvas(Display &gfx, int metric, const HistoryRing &hist)
+{
+    // Everything except the plot block, which paints itself
+    int plotBottom = HIST_AREA_Y + sparkRows(HISTORY_SPARK);
+    int plotRight  = HIST_AREA_X + HIST_PLOT_W;
+    gfx.fillRect(0, 0, SCREEN_W, HIST_AREA_Y, COLOR_BLACK);
+    gfx.fillRect(0, HIST_AREA_Y, HIST_AREA_X, plotBottom - HIST_AREA_Y, COLOR_BLACK);
+    gfx.fillRect(plotRight, HIST_AREA_Y, SCREEN_W - plotRight, plotBottom - HIST_AREA_Y,
+                 COLOR_BLACK);
+    gfx.fillRect(0, plotBottom, SCREEN_W, SCREEN_H - plotBottom, COLOR_BLACK);
+    gfx.drawText(METRICS[metric].historyTitle, HIST_TITLE_X, HIST_TITLE_Y, 2,
+                 COLOR_WHITE, COLOR_BLACK);
+    drawSparkline(gfx, HIST_AREA_X, HIST_AREA_Y, metric, hist);
+}
+
+void renderPageDirect(const SensorSnapshot &snap)
+{
+    int group = pageGroup(g_currentPage);
+    for (int id = 0; id < WID_COUNT; ++id) {
+        if (g_widgets[id].group != group) widgetErase(g_widgets[id]);
+    }
+
+    if (g_currentPage == PAGE_LIVE) {
+        renderLivePage(snap);
+    } else if (g_currentPage == PAGE_OVERVIEW) {
+        widgetOverview(WID_OVERVIEW, snap.sensors, g_overviewScroll);
+    } else if (g_currentPage == PAGE_DIAG) {
+        widgetDiag(WID_DIAG, snap);
+    } else {
+        renderHistoryPage(snap, g_currentPage - PAGE_HISTORY_FIRST);
+    }
+}
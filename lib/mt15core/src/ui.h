@@ -0,0 +1,149 @@
+#pragma once
+#include <stdint.h>
+#include "platform.h"
+#include "snapshot.h"
+
+// Layout constants
+const int SCREEN_W    = 320;
+const int SCREEN_H    = 240;
+
+const int ICON_X      = 10;
+const int ICON_Y      = 10;
+const int ICON_W      = 160;
+const int ICON_H      = 100;
+
+const int TITLE_X       = 190;
+const int TITLE_Y       = 10;
+
+const int WIFI_STATUS_X = 190;
+const int WIFI_STATUS_Y = 55;   // below title
+
+const int SOURCE_X = 190;
+const int SOURCE_Y = 80;        // below WiFi status: "saved data" at boot
+
+// Alert banner: a red box, one line per raised alert rule (analytics.h)
+const int ALERT_X      = 190;
+const int ALERT_Y      = 91;
+const int ALERT_W      = SCREEN_W - ALERT_X - 4;
+const int ALERT_LINE_H = 10;
+const int ALERT_LINES  = 2;
+
+// Live readouts: two columns below the icon, a size-1 label then the value
+// in large glyphs (glyph_atlas.h) with its unit a size smaller
+const int METRIC_COLS       = 2;
+const int METRIC_COL_W      = SCREEN_W / METRIC_COLS;
+const int METRIC_LABEL_X    = 6;
+const int METRIC_VALUE_X    = METRIC_LABEL_X + 38;   // after "PM2.5:"
+const int METRIC_BASE_Y     = ICON_Y + ICON_H + 4;   // below icon
+const int METRIC_LINE_H     = 31;
+const int READOUT_SIZE      = 1;                     // GLYPH_CELL_H index: 30 px
+const int READOUT_UNIT_SIZE = 0;                     // 20 px
+const int READOUT_UNIT_GAP  = 4;
+const int METRIC_LABEL_DY   = 16;                    // on the readout's baseline
+
+// History page: title above, plot + axis/tick labels below
+const int HIST_TITLE_X = 10;
+const int HIST_TITLE_Y = 10;
+const int HIST_AREA_X  = 10;
+const int HIST_AREA_Y  = 40;
+const int HIST_PLOT_W  = 280;   // narrower so labels fit on right
+const int HIST_PLOT_H  = 180;
+
+// Overview page: one row per org sensor, scrolled a row at a time
+const int OVERVIEW_TITLE_X  = 4;
+const int OVERVIEW_TITLE_Y  = 4;
+const int OVERVIEW_HEADER_Y = 26;
+const int OVERVIEW_ROW_Y    = 40;
+const int OVERVIEW_ROW_H    = 12;
+const int OVERVIEW_ROWS     = (SCREEN_H - OVERVIEW_ROW_Y) / OVERVIEW_ROW_H;
+
+// Diagnostics page: stage table, then heap and fetch arena
+const int DIAG_TITLE_X  = 4;
+const int DIAG_TITLE_Y  = 4;
+const int DIAG_HEADER_Y = 26;
+const int DIAG_ROW_Y    = 40;
+const int DIAG_ROW_H    = 14;
+const int DIAG_MEM_Y    = DIAG_ROW_Y + PERF_STAGE_COUNT * DIAG_ROW_H + 10;
+
+// Rows whose newest reading trails the org's newest by this much are greyed
+const uint32_t SENSOR_STALE_S = 3600;
+
+// ==== PAGES ====
+
+enum PageId {
+    PAGE_LIVE          = 0,
+    PAGE_OVERVIEW      = 1,
+    PAGE_HISTORY_FIRST = 2,   // one history page per MetricId, in order
+    PAGE_DIAG          = PAGE_HISTORY_FIRST + METRIC_COUNT,
+    PAGE_MAX
+};
+
+extern int g_currentPage;
+extern int g_overviewScroll;   // first overview row on screen
+
+// Moves the overview by `rows` (positive = further down the list), clamped
+// so the last page of rows stays full. Returns true if it moved.
+bool scrollOverview(int rows, const SensorStore &sensors);
+
+// ==== RETAINED WIDGETS ====
+
+// The UI keeps a record of what every widget last put on its canvas. Pages
+// are rendered by handing each widget its current content; a widget only
+// draws when that content differs from what it drew before, so a refresh
+// where nothing changed costs no SPI traffic at all.
+//
+// When the canvas is an off-screen sprite, widgets also record the
+// rectangles they touched (g_damage) so the application can push just those
+// to the panel. When the canvas is the panel itself, changing pages erases
+// only the rectangles the old page used instead of the whole screen.
+
+struct Rect {
+    int16_t x, y, w, h;
+};
+
+extern Display *g_canvas;        // where widgets draw
+extern bool     g_trackDamage;   // record touched rectangles in g_damage
+
+const int MAX_DAMAGE = 48;
+extern Rect g_damage[MAX_DAMAGE];
+extern int  g_damageCount;
+
+// FNV-1a, used to fingerprint widget content
+uint32_t contentHash(const void *data, size_t len, uint32_t h = 2166136261u);
+
+// Fingerprint of everything a history plot shows for `metric`
+uint32_t historyKey(int metric, const HistoryRing &hist);
+
+void initWidgets();
+
+// Draws the plot for `metric` into `gfx` with its top-left at (x0, y0).
+// Returns the height of everything drawn below y0 (border, ticks and labels
+// included). Screen geometry is cached per metric until its history
+// changes (sparkline.h).
+int drawSparkline(Display &gfx, int x0, int y0, int metric, const HistoryRing &hist);
+
+// Fingerprint of everything the overview shows from row `first`
+uint32_t overviewKey(const SensorStore &sensors, int first);
+
+// Live page through the widgets on g_canvas.
+void renderLivePage(const SensorSnapshot &snap);
+
+// Whole history page for `metric` onto a blank full-screen surface; used to
+// fill page caches and for host renders.
+void renderHistoryCanvas(Display &gfx, int metric, const HistoryRing &hist);
+
+// Whole overview page from row `first` onto a blank full-screen surface.
+void renderOverviewCanvas(Display &gfx, const SensorStore &sensors, int first);
+
+// Fingerprint of everything the diagnostics page shows: the snapshot's
+// fetch timings, the UI's own rings and the heap. It changes with almost
+// every sample, so callers limit how often they act on it.
+uint32_t diagKey(const SensorSnapshot &snap);
+
+// Whole diagnostics page onto a blank full-screen surface.
+void renderDiagCanvas(Display &gfx, const SensorSnapshot &snap);
+
+// Direct mode: brings g_canvas (the panel) in line with g_currentPage.
+// Widgets of another page group are erased first; everything else only
+// redraws if its content changed. Safe to call as often as we like.
+void renderPageDirect(const SensorSnapshot &snap);
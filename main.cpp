@@ -1,9 +1,26 @@
+#include <LittleFS.h>
 #include <M5Core2.h>
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
-#include <HTTPClient.h>
-#include <ArduinoJson.h>
-#include "mt15_icon.h"   // provides mt15_icon_map[] (RGB565, 160x100)
+#include <esp_heap_caps.h>
+#include <lwip/sockets.h>
+#include <stdarg.h>
+
+// Portable core (lib/mt15core): parsing, history store, layout, drawing
+#include "analytics.h"
+#include "archive.h"
+#include "frame_sched.h"
+#include "gesture.h"
+#include "hub.h"
+#include "local_api.h"
+#include "meraki_fetch.h"
+#include "meraki_http.h"
+#include "mqtt_live.h"
+#include "perf_stats.h"
+#include "scheduler.h"
+#include "snapshot.h"
+#include "state_cache.h"
+#include "ui.h"
 
 // ==== WIFI / MERAKI CONFIG ====
 
@@ -12,804 +29,772 @@
 #define MERAKI_API_KEY  "API_KEY"
 #define MERAKI_ORG_ID   "Org_ID"
 #define MT15_SERIAL     "Serial_Number"
-
-// Latest metrics endpoint (all metrics)
-const char *MERAKI_URL =
-    "https://api.meraki.com/api/v1/organizations/" MERAKI_ORG_ID
-    "/sensor/readings/latest?serials[]=" MT15_SERIAL;
-
-// 30-day temp history endpoint (daily buckets)
-const char *MERAKI_URL_TEMP_30D =
-    "https://api.meraki.com/api/v1/organizations/" MERAKI_ORG_ID
-    "/sensor/readings/history/byInterval"
-    "?serials[]=" MT15_SERIAL
-    "&metrics[]=temperature"
-    "&timespan=2592000"   // 30 days in seconds
-    "&interval=86400";    // 1 day buckets
-
-// 30-day humidity history endpoint (daily buckets)
-const char *MERAKI_URL_HUM_30D =
-    "https://api.meraki.com/api/v1/organizations/" MERAKI_ORG_ID
-    "/sensor/readings/history/byInterval"
-    "?serials[]=" MT15_SERIAL
-    "&metrics[]=humidity"
-    "&timespan=2592000"
-    "&interval=86400";
-
-// Refresh interval in ms
+#define OVERVIEW_SERIALS ""   // comma-separated; "" = every sensor in the org
+#define DISPLAYS_PER_ORG 1    // displays sharing the org's API rate limit
+#define LOCAL_API_PORT   8080 // serves /latest and /history on the LAN; 0 = off
+#define HUB_ROLE         HUB_OFF   // one display per site HUB_SEND, the rest
+                                   // HUB_LISTEN: they make no API calls (hub.h)
+#define MQTT_BROKER_HOST ""   // site broker MTs publish to; "" = poll only
+#define MQTT_BROKER_PORT 1883
+#define MQTT_USER        ""
+#define MQTT_PASS        ""
+#define MT15_MAC         "AA:BB:CC:DD:EE:FF"   // MT15_SERIAL's MAC, as in its topics
+
+// All requests go to one host over a single kept-alive TLS connection
+const char *MERAKI_HOST = "api.meraki.com";
+const uint16_t MERAKI_PORT = 443;
+
+// Latest readings TTL in ms; history follows HISTORY_REFRESH_MS. While
+// MQTT is delivering the live sensor's readings (mqtt_live.h) the poll only
+// keeps the overview current, every MQTT_OVERVIEW_REFRESH_MS.
 const unsigned long REFRESH_INTERVAL_MS = 60000;
 
-// ==== STATE ====
-
-WiFiClientSecure secureClient;
-unsigned long lastFetch = 0;
-
-// Latest sensor values
-double g_tempC       = NAN;
-double g_humidityPct = NAN;
-double g_co2Ppm      = NAN;
-double g_noiseDb     = NAN;   // ambient noise level (dB)
-double g_pm25        = NAN;   // pm2.5 ug/m3
-double g_tvoc        = NAN;   // TVOC ppb
-double g_iaqScore    = NAN;   // indoor air quality score (0–100)
-
-// 30-day histories
-const int MAX_TEMP_POINTS = 32;        // we only need ~30
-float g_tempHistory[MAX_TEMP_POINTS];  // daily avg temps in C
-float g_humHistory[MAX_TEMP_POINTS];   // daily avg humidity %
-int   g_tempHistoryCount = 0;
-char  g_tempDateLabel[MAX_TEMP_POINTS][6];  // "MM/DD" + '\0'
-
-// Layout constants
-const int ICON_X      = 10;
-const int ICON_Y      = 10;
-const int ICON_W      = 160;
-const int ICON_H      = 100;
-
-const int TITLE_X       = 190;
-const int TITLE_Y       = 10;
-
-const int WIFI_STATUS_X = 190;
-const int WIFI_STATUS_Y = 55;   // below title
-
-const int METRIC_LABEL_X = 10;
-const int METRIC_VALUE_X = 120;
-const int METRIC_BASE_Y  = ICON_Y + ICON_H + 8;  // below icon
-const int METRIC_LINE_H  = 12;                   // tight spacing
-
-// ==== PAGE / SWIPE STATE ====
-
-enum PageId {
-    PAGE_LIVE         = 0,
-    PAGE_TEMP_HISTORY = 1,
-    PAGE_HUM_HISTORY  = 2,
-    PAGE_MAX          = 3
+// Each display takes an equal share of the org's request budget; failures
+// back off from 5 s to 10 min, and the first fetches land somewhere in the
+// first 5 s so displays powered up together don't hit the API together.
+const SchedulerConfig SCHEDULER_CONFIG = {
+    { REFRESH_INTERVAL_MS, HISTORY_REFRESH_MS },
+    MERAKI_ORG_REQUESTS_PER_S / DISPLAYS_PER_ORG,
+    4.0f,               // burst: a refresh with a few pages
+    5000, 600000,
+    5000
 };
 
-int g_currentPage = PAGE_LIVE;
+// loop() sleeps until touch input or a snapshot arrives (frame_sched.h);
+// the diagnostics page, when shown, is also refreshed every DIAG_REFRESH_MS
+const unsigned long DIAG_REFRESH_MS = 1000;
 
-// Forward declaration
-void drawHumHistoryPage();
+// Longest the fetch task sleeps, so a dropped WiFi is noticed
+const unsigned long FETCH_POLL_MS = 5000;
 
-// ==== UI HELPERS: LIVE PAGE ====
+// Network work runs in its own task on the PRO core (core 0, alongside the
+// WiFi stack); loop() and all drawing stay on core 1.
+const BaseType_t FETCH_TASK_CORE  = 0;
+const uint32_t   FETCH_TASK_STACK = 12288;   // TLS handshake is stack hungry
 
-void drawStaticLayout()
-{
-    M5.Lcd.fillScreen(TFT_BLACK);
-    M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
-
-    // Icon
-    M5.Lcd.pushImage(ICON_X, ICON_Y, ICON_W, ICON_H, (uint16_t *)mt15_icon_map);
-
-    // Title
-    M5.Lcd.setTextDatum(TL_DATUM);
-    M5.Lcd.setTextSize(2);
-    M5.Lcd.drawString("Meraki MT15", TITLE_X, TITLE_Y);
-
-    // WiFi status placeholder
-    M5.Lcd.fillRect(WIFI_STATUS_X, WIFI_STATUS_Y,
-                    120, METRIC_LINE_H * 2, TFT_BLACK);
-    M5.Lcd.setTextColor(TFT_YELLOW, TFT_BLACK);
-    M5.Lcd.drawString("WiFi ...", WIFI_STATUS_X, WIFI_STATUS_Y);
-
-    // Metric labels under the icon (small font)
-    M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
-    M5.Lcd.setTextSize(1);
-    M5.Lcd.setTextDatum(TL_DATUM);
-
-    int y = METRIC_BASE_Y;
-
-    M5.Lcd.drawString("Temp:",  METRIC_LABEL_X, y); y += METRIC_LINE_H;
-    M5.Lcd.drawString("Hum :",  METRIC_LABEL_X, y); y += METRIC_LINE_H;
-    M5.Lcd.drawString("CO2 :",  METRIC_LABEL_X, y); y += METRIC_LINE_H;
-    M5.Lcd.drawString("dB  :",  METRIC_LABEL_X, y); y += METRIC_LINE_H;
-    M5.Lcd.drawString("PM2.5:", METRIC_LABEL_X, y); y += METRIC_LINE_H;
-    M5.Lcd.drawString("TVOC:",  METRIC_LABEL_X, y); y += METRIC_LINE_H;
-    M5.Lcd.drawString("IAQ :",  METRIC_LABEL_X, y);
-}
+// The local API server shares core 0 below the fetch task's priority
+const uint32_t API_TASK_STACK      = 4096;
+const int      API_READ_TIMEOUT_MS = 2000;   // slow or silent clients are dropped
 
-void updateSensorText()
+// ==== PLATFORM (ARDUINO / M5CORE2) ====
+
+unsigned long platformMillis() { return millis(); }
+unsigned long platformMicros() { return micros(); }
+void          platformDelay(unsigned long ms) { delay(ms); }
+uint32_t      platformRandom() { return esp_random(); }   // hardware RNG
+
+void platformLog(const char *fmt, ...)
 {
-    char buf[32];
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    Serial.print(buf);
+}
 
-    M5.Lcd.setTextDatum(TL_DATUM);
-    M5.Lcd.setTextSize(1);                 // match labels
-    M5.Lcd.setTextColor(TFT_GREEN, TFT_BLACK);
+// Internal RAM only: that's what TLS and the WiFi stack allocate from
+size_t platformFreeHeap() { return heap_caps_get_free_size(MALLOC_CAP_INTERNAL); }
+size_t platformMinFreeHeap() { return heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL); }
+size_t platformLargestFreeBlock() { return heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL); }
 
-    int y = METRIC_BASE_Y;
+void *platformAllocLarge(size_t size)
+{
+    void *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return p ? p : heap_caps_malloc(size, MALLOC_CAP_8BIT);
+}
 
-    // Temperature
-    M5.Lcd.fillRect(METRIC_VALUE_X, y, 200, METRIC_LINE_H, TFT_BLACK);
-    if (!isnan(g_tempC)) {
-        snprintf(buf, sizeof(buf), "%.2f C", g_tempC);
-        M5.Lcd.drawString(buf, METRIC_VALUE_X, y);
-    } else {
-        M5.Lcd.drawString("--.- C", METRIC_VALUE_X, y);
-    }
-    y += METRIC_LINE_H;
+// Blobs are files in the LittleFS root; saves go to a temp file that is
+// renamed over the old one (LittleFS renames are atomic).
+long platformLoadBlob(const char *name, uint8_t *buf, size_t size)
+{
+    char path[32];
+    snprintf(path, sizeof(path), "/%s.bin", name);
+    File f = LittleFS.open(path, "r");
+    if (!f) return -1;
+    long len = f.size() <= size ? (long)f.read(buf, f.size()) : -1;
+    f.close();
+    return len;
+}
 
-    // Humidity
-    M5.Lcd.fillRect(METRIC_VALUE_X, y, 200, METRIC_LINE_H, TFT_BLACK);
-    if (!isnan(g_humidityPct)) {
-        snprintf(buf, sizeof(buf), "%.0f %%", g_humidityPct);
-        M5.Lcd.drawString(buf, METRIC_VALUE_X, y);
-    } else {
-        M5.Lcd.drawString("-- %", METRIC_VALUE_X, y);
-    }
-    y += METRIC_LINE_H;
+bool platformSaveBlob(const char *name, const uint8_t *data, size_t len)
+{
+    char path[32], tmp[32];
+    snprintf(path, sizeof(path), "/%s.bin", name);
+    snprintf(tmp, sizeof(tmp), "/%s.tmp", name);
+    File f = LittleFS.open(tmp, "w");
+    if (!f) return false;
+    bool ok = f.write(data, len) == len;
+    f.close();
+    return ok && LittleFS.rename(tmp, path);
+}
 
-    // CO2
-    M5.Lcd.fillRect(METRIC_VALUE_X, y, 200, METRIC_LINE_H, TFT_BLACK);
-    if (!isnan(g_co2Ppm)) {
-        snprintf(buf, sizeof(buf), "%.0f ppm", g_co2Ppm);
-        M5.Lcd.drawString(buf, METRIC_VALUE_X, y);
-    } else {
-        M5.Lcd.drawString("--- ppm", METRIC_VALUE_X, y);
-    }
-    y += METRIC_LINE_H;
+// The core's connection, over WiFiClientSecure. The name is resolved
+// separately so DNS shows up on its own; TCP connect and TLS handshake
+// happen in one call and are timed together (as TLS).
+class SecureTransport : public Transport {
+public:
+    bool connect(const char *host, uint16_t port) override
+    {
+        _client.setInsecure();  // demo: no CA pinning
+
+        unsigned long t0 = micros();
+        IPAddress ip;
+        if (!WiFi.hostByName(host, ip)) return false;
+        unsigned long t1 = micros();
+        if (!_client.connect(ip, port, host, NULL, NULL, NULL)) return false;   // host for SNI
+
+        dnsUs = t1 - t0;
+        tcpUs = -1;
+        tlsUs = micros() - t1;
+        return true;
+    }
+    bool   connected() override { return _client.connected(); }
+    void   stop() override { _client.stop(); }
+    size_t write(const uint8_t *buf, size_t len) override { return _client.write(buf, len); }
+    int    available() override { return _client.available(); }
+    int    read() override { return _client.read(); }
+
+private:
+    WiFiClientSecure _client;
+};
 
-    // Noise
-    M5.Lcd.fillRect(METRIC_VALUE_X, y, 200, METRIC_LINE_H, TFT_BLACK);
-    if (!isnan(g_noiseDb)) {
-        snprintf(buf, sizeof(buf), "%.0f dB", g_noiseDb);
-        M5.Lcd.drawString(buf, METRIC_VALUE_X, y);
-    } else {
-        M5.Lcd.drawString("-- dB", METRIC_VALUE_X, y);
-    }
-    y += METRIC_LINE_H;
+// The core's drawing surface over TFT_eSPI: the panel itself or a sprite
+class TftDisplay : public Display {
+public:
+    explicit TftDisplay(TFT_eSPI &tft) : _tft(tft) {}
 
-    // PM2.5
-    M5.Lcd.fillRect(METRIC_VALUE_X, y, 200, METRIC_LINE_H, TFT_BLACK);
-    if (!isnan(g_pm25)) {
-        snprintf(buf, sizeof(buf), "%.0f ug/m3", g_pm25);
-        M5.Lcd.drawString(buf, METRIC_VALUE_X, y);
-    } else {
-        M5.Lcd.drawString("-- ug/m3", METRIC_VALUE_X, y);
+    void fillRect(int x, int y, int w, int h, uint16_t color) override
+    {
+        _tft.fillRect(x, y, w, h, color);
     }
-    y += METRIC_LINE_H;
-
-    // TVOC
-    M5.Lcd.fillRect(METRIC_VALUE_X, y, 200, METRIC_LINE_H, TFT_BLACK);
-    if (!isnan(g_tvoc)) {
-        snprintf(buf, sizeof(buf), "%.0f ppb", g_tvoc);
-        M5.Lcd.drawString(buf, METRIC_VALUE_X, y);
-    } else {
-        M5.Lcd.drawString("-- ppb", METRIC_VALUE_X, y);
+    void drawRect(int x, int y, int w, int h, uint16_t color) override
+    {
+        _tft.drawRect(x, y, w, h, color);
     }
-    y += METRIC_LINE_H;
-
-    // IAQ
-    M5.Lcd.fillRect(METRIC_VALUE_X, y, 200, METRIC_LINE_H, TFT_BLACK);
-    if (!isnan(g_iaqScore)) {
-        snprintf(buf, sizeof(buf), "%.0f /100", g_iaqScore);
-        M5.Lcd.drawString(buf, METRIC_VALUE_X, y);
-    } else {
-        M5.Lcd.drawString("-- /100", METRIC_VALUE_X, y);
+    void drawLine(int x0, int y0, int x1, int y1, uint16_t color) override
+    {
+        _tft.drawLine(x0, y0, x1, y1, color);
     }
-}
-
-// ==== TEMP HISTORY PAGE ====
-
-void drawTempHistoryPage()
-{
-    M5.Lcd.fillScreen(TFT_BLACK);
-    M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
-    M5.Lcd.setTextDatum(TL_DATUM);
-
-    // Title
-    M5.Lcd.setTextSize(2);
-    M5.Lcd.drawString("Temp last 30 days (C)", 10, 10);
-
-    if (g_tempHistoryCount <= 1) {
-        M5.Lcd.setTextSize(1);
-        M5.Lcd.drawString("Not enough data", 10, 40);
-        return;
+    void pushImage(int x, int y, int w, int h, const uint16_t *pixels) override
+    {
+        _tft.pushImage(x, y, w, h, (uint16_t *)pixels);
     }
-
-    // Plot area
-    int x0 = 10;
-    int y0 = 40;
-    int w  = 280;   // narrower so labels fit on right
-    int h  = 180;
-
-    // Find min/max (skip NaN)
-    float tMin = 1e9, tMax = -1e9;
-    for (int i = 0; i < g_tempHistoryCount; ++i) {
-        float v = g_tempHistory[i];
-        if (isnan(v)) continue;
-        if (v < tMin) tMin = v;
-        if (v > tMax) tMax = v;
+    void drawText(const char *text, int x, int y, int size,
+                  uint16_t fg, uint16_t bg) override
+    {
+        _tft.setTextDatum(TL_DATUM);
+        _tft.setTextSize(size);
+        _tft.setTextColor(fg, bg);
+        _tft.drawString(text, x, y);
     }
-
-    if (tMin > tMax) {
-        M5.Lcd.setTextSize(1);
-        M5.Lcd.drawString("No valid temps", 10, 40);
-        return;
+    int textWidth(const char *text, int size) override
+    {
+        _tft.setTextSize(size);
+        return _tft.textWidth(text);
     }
 
-    // Pad the y range slightly
-    float margin = 0.5f;
-    tMin -= margin;
-    tMax += margin;
-
-    // Draw border
-    M5.Lcd.drawRect(x0, y0, w, h, TFT_DARKGREY);
-
-    // Sparkline
-    int prevX = -1, prevY = -1;
-    for (int i = 0; i < g_tempHistoryCount; ++i) {
-        float v = g_tempHistory[i];
-        if (isnan(v)) continue;
+private:
+    TFT_eSPI &_tft;
+};
 
-        float frac = (v - tMin) / (tMax - tMin + 1e-6f); // 0..1
-        int x = x0 + (int)((float)i * (w - 1) / (g_tempHistoryCount - 1));
-        int y = y0 + h - 1 - (int)(frac * (h - 2));
+SecureTransport g_secureTransport;   // fetch task only
+
+// Plain TCP, for the site's MQTT broker on the LAN
+class PlainTransport : public Transport {
+public:
+    bool connect(const char *host, uint16_t port) override
+    {
+        unsigned long t0 = micros();
+        if (!_client.connect(host, port)) return false;
+        _client.setNoDelay(true);   // pings and acks are a few bytes
+        tcpUs = micros() - t0;
+        return true;
+    }
+    bool   connected() override { return _client.connected(); }
+    void   stop() override { _client.stop(); }
+    size_t write(const uint8_t *buf, size_t len) override { return _client.write(buf, len); }
+    int    available() override { return _client.available(); }
+    int    read() override { return _client.read(); }
+
+private:
+    WiFiClient _client;
+};
 
-        if (prevX >= 0) {
-            M5.Lcd.drawLine(prevX, prevY, x, y, TFT_CYAN);
+PlainTransport g_mqttTransport;   // fetch task only
+
+// Hub mode's datagrams over lwIP's sockets. Joined after every WiFi
+// (re)connect, since the membership goes with the interface.
+class LwipMulticast : public Multicast {
+public:
+    bool begin(const char *group, uint16_t port, bool receive) override
+    {
+        if (_fd >= 0) close(_fd);
+        _fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (_fd < 0) return false;
+
+        _dest = {};
+        _dest.sin_family = AF_INET;
+        _dest.sin_port   = htons(port);
+        bool ok = inet_pton(AF_INET, group, &_dest.sin_addr) == 1;
+        if (ok && receive) {
+            struct sockaddr_in any = {};
+            any.sin_family      = AF_INET;
+            any.sin_port        = htons(port);
+            any.sin_addr.s_addr = htonl(INADDR_ANY);
+            struct ip_mreq mreq = {};
+            mreq.imr_multiaddr        = _dest.sin_addr;
+            mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+            ok = bind(_fd, (struct sockaddr *)&any, sizeof(any)) == 0 &&
+                 setsockopt(_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0;
+        } else if (ok) {
+            uint8_t ttl = 1;   // this subnet only
+            setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        }
+        if (!ok) {
+            close(_fd);
+            _fd = -1;
         }
-        prevX = x;
-        prevY = y;
+        return ok;
     }
 
-    // Y-axis labels (pulled in a bit so they don’t clip)
-    M5.Lcd.setTextSize(1);
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%.1fC", tMax);
-    M5.Lcd.drawString(buf, x0 + w + 4, y0);
-    snprintf(buf, sizeof(buf), "%.1fC", tMin);
-    M5.Lcd.drawString(buf, x0 + w + 4, y0 + h - 8);
-
-    // --- Weekly vertical dashes + MM/DD labels ---
+    bool send(const uint8_t *buf, size_t len) override
+    {
+        return _fd >= 0 &&
+               sendto(_fd, buf, len, 0, (struct sockaddr *)&_dest, sizeof(_dest)) == (int)len;
+    }
 
-    int lastIdx = g_tempHistoryCount - 1;
-    int baseY   = y0 + h;        // axis baseline for ticks
-    int labelY  = baseY + 4;     // text just below ticks
+    int receive(uint8_t *buf, size_t size, unsigned long timeoutMs) override
+    {
+        if (_fd < 0) return -1;
+        struct timeval tv = { (long)(timeoutMs / 1000), (long)(timeoutMs % 1000) * 1000 };
+        setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        int n = recv(_fd, buf, size, 0);
+        if (n >= 0) return n;
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
 
-    // indices we want: today, -7, -14, -21, -28 (if they exist)
-    int weekOffsets[] = {0, 7, 14, 21, 28};
-    int numOffsets    = sizeof(weekOffsets) / sizeof(weekOffsets[0]);
+private:
+    int                _fd   = -1;
+    struct sockaddr_in _dest = {};
+};
 
-    for (int k = 0; k < numOffsets; ++k) {
-        int idx = lastIdx - weekOffsets[k];
-        if (idx < 0 || idx >= g_tempHistoryCount) continue;
+LwipMulticast g_lwipMulticast;   // fetch task only
+TftDisplay      g_panel(M5.Lcd);
 
-        int x = x0 + (int)((float)idx * (w - 1) / (g_tempHistoryCount - 1));
+// ==== PAGE SPRITE CACHE ====
 
-        // vertical hashmark across the plot
-        M5.Lcd.drawLine(x, y0, x, y0 + h, TFT_DARKGREY);
+// With PSRAM every page has its own full-screen sprite (10 x 150 KB). History
+// and overview pages are re-rendered into theirs only when what they show
+// changes, the diagnostics page only while it is on screen, and the live
+// page's widgets draw into theirs, so a swipe is a single bulk blit and
+// live updates push just the damaged rectangles. If the sprites can't be
+// allocated, pages draw straight to the panel (renderPageDirect()).
+const int SWIPE_SLIDE_FRAMES = 0;   // >0 animates swipes as a slide
 
-        // small tick at the bottom
-        M5.Lcd.drawLine(x, baseY, x, baseY + 2, TFT_DARKGREY);
+TFT_eSprite *g_pageSprite[PAGE_MAX]   = {};
+TftDisplay  *g_pageCanvas[PAGE_MAX]   = {};   // core view of each sprite
+uint32_t     g_pageKey[PAGE_MAX]      = {};   // history/overview/diagKey() a sprite holds
+bool         g_pageRendered[PAGE_MAX] = {};
+bool         g_pageCacheOk = false;
+int          g_shownPage   = -1;              // page whose sprite is on the panel
 
-        // MM/DD label under the tick
-        M5.Lcd.setTextSize(1);
-        int textX = x - 10;  // roughly center under tick
-        if (textX < 0) textX = 0;
-        if (textX > 320 - 24) textX = 320 - 24;
+// Input-to-visible timing: from the touch sample that completed a gesture
+// to the last pixel pushed for what it changed (0 = nothing pending)
+uint32_t g_inputUs = 0;
 
-        M5.Lcd.drawString(g_tempDateLabel[idx], textX, labelY);
+void freePageCache()
+{
+    for (int p = 0; p < PAGE_MAX; ++p) {
+        delete g_pageCanvas[p];
+        g_pageCanvas[p] = NULL;
+        if (!g_pageSprite[p]) continue;
+        g_pageSprite[p]->deleteSprite();
+        delete g_pageSprite[p];
+        g_pageSprite[p] = NULL;
     }
 }
 
-// ==== HUMIDITY HISTORY PAGE ====
-
-void drawHumHistoryPage()
+bool initPageCache()
 {
-    M5.Lcd.fillScreen(TFT_BLACK);
-    M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
-    M5.Lcd.setTextDatum(TL_DATUM);
-
-    // Title
-    M5.Lcd.setTextSize(2);
-    M5.Lcd.drawString("Humidity last 30 days", 10, 10);
-
-    if (g_tempHistoryCount <= 1) {
-        M5.Lcd.setTextSize(1);
-        M5.Lcd.drawString("Not enough data", 10, 40);
-        return;
-    }
-
-    // Plot area
-    int x0 = 10;
-    int y0 = 40;
-    int w  = 280;
-    int h  = 180;
-
-    // Find min/max humidity (skip NaN)
-    float hMin =  1e9, hMax = -1e9;
-    for (int i = 0; i < g_tempHistoryCount; ++i) {
-        float v = g_humHistory[i];
-        if (isnan(v)) continue;
-        if (v < hMin) hMin = v;
-        if (v > hMax) hMax = v;
-    }
-
-    if (hMin > hMax) {
-        M5.Lcd.setTextSize(1);
-        M5.Lcd.drawString("No valid humidity", 10, 40);
-        return;
-    }
-
-    // Pad the y range a bit
-    float margin = 3.0f;
-    hMin -= margin;
-    hMax += margin;
-
-    // Draw border
-    M5.Lcd.drawRect(x0, y0, w, h, TFT_DARKGREY);
-
-    // Draw sparkline
-    int prevX = -1, prevY = -1;
-    for (int i = 0; i < g_tempHistoryCount; ++i) {
-        float v = g_humHistory[i];
-        if (isnan(v)) continue;
-
-        float frac = (v - hMin) / (hMax - hMin + 1e-6f); // 0..1
-        int x = x0 + (int)((float)i * (w - 1) / (g_tempHistoryCount - 1));
-        int y = y0 + h - 1 - (int)(frac * (h - 2));
-
-        if (prevX >= 0) {
-            M5.Lcd.drawLine(prevX, prevY, x, y, TFT_CYAN);
+    for (int p = 0; p < PAGE_MAX; ++p) {
+        TFT_eSprite *s = new TFT_eSprite(&M5.Lcd);
+        s->setColorDepth(16);
+        g_pageSprite[p] = s;
+        if (!s->createSprite(SCREEN_W, SCREEN_H)) {   // lands in PSRAM when present
+            Serial.printf("[UI] page sprite %d alloc failed, drawing direct\n", p);
+            freePageCache();
+            return false;
         }
-        prevX = x;
-        prevY = y;
+        s->fillSprite(TFT_BLACK);
+        g_pageCanvas[p] = new TftDisplay(*s);
     }
 
-    // Y-axis labels
-    M5.Lcd.setTextSize(1);
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%.0f%%", hMax);
-    M5.Lcd.drawString(buf, x0 + w + 4, y0);
-    snprintf(buf, sizeof(buf), "%.0f%%", hMin);
-    M5.Lcd.drawString(buf, x0 + w + 4, y0 + h - 8);
-
-    // Weekly ticks based on g_tempDateLabel[]
-    int n = g_tempHistoryCount;
-    int baseY = y0 + h;
-    int labelY = baseY + 4;
-
-    int weekOffsets[] = {0, 7, 14, 21, 28};
-    int numOffsets    = sizeof(weekOffsets) / sizeof(weekOffsets[0]);
-    int lastIdx       = n - 1;
-
-    for (int k = 0; k < numOffsets; ++k) {
-        int idx = lastIdx - weekOffsets[k];
-        if (idx < 0 || idx >= n) continue;
-
-        int x = x0 + (int)((float)idx * (w - 1) / (n - 1));
-
-        // tiny vertical tick at bottom
-        M5.Lcd.drawLine(x, baseY, x, baseY + 2, TFT_DARKGREY);
-
-        int textX = x - 10;
-        if (textX < 0) textX = 0;
-        if (textX > 320 - 24) textX = 320 - 24;
-
-        M5.Lcd.drawString(g_tempDateLabel[idx], textX, labelY);
-    }
+    g_canvas      = g_pageCanvas[PAGE_LIVE];
+    g_trackDamage = true;
+    g_pageCacheOk = true;
+    return true;
 }
 
-// ==== PAGE DISPATCH ====
-
-void drawCurrentPage()
+// Copies one rectangle of a full-screen sprite to the same place on the
+// panel. Row by row, since the sprite's stride is the screen width; pixels
+// are already in panel byte order.
+void pushSpriteRect(TFT_eSprite &spr, const Rect &r)
 {
-    if (g_currentPage == PAGE_LIVE) {
-        drawStaticLayout();
-        updateSensorText();
-    } else if (g_currentPage == PAGE_TEMP_HISTORY) {
-        drawTempHistoryPage();
-    } else if (g_currentPage == PAGE_HUM_HISTORY) {
-        drawHumHistoryPage();
+    uint16_t *px = (uint16_t *)spr.getPointer();
+    bool swap = M5.Lcd.getSwapBytes();
+    M5.Lcd.setSwapBytes(false);
+    for (int row = 0; row < r.h; ++row) {
+        M5.Lcd.pushImage(r.x, r.y + row, r.w, 1, px + (r.y + row) * SCREEN_W + r.x);
     }
+    M5.Lcd.setSwapBytes(swap);
 }
 
-// ==== MERAKI FETCH + PARSE (LATEST) ====
-
-bool fetchMT15Once()
+// Slides the page on the panel out and `to` in, both from their sprites.
+void slideToPage(int from, int to)
 {
-    HTTPClient http;
-    secureClient.setInsecure();  // demo: no CA pinning
-
-    if (!http.begin(secureClient, MERAKI_URL)) {
-        Serial.println("[HTTP] begin() failed");
-        return false;
-    }
-
-    http.addHeader("X-Cisco-Meraki-API-Key", MERAKI_API_KEY);
-    http.addHeader("Accept", "application/json");
-
-    int httpCode = http.GET();
-    if (httpCode <= 0) {
-        Serial.printf("[HTTP] GET failed: %s\n",
-                      http.errorToString(httpCode).c_str());
-        http.end();
-        return false;
+    int dir    = to > from ? -1 : 1;   // forward swipes move content left
+    int frames = max(SWIPE_SLIDE_FRAMES, 1);
+    for (int f = 1; f <= frames; ++f) {
+        int off = dir * SCREEN_W * f / frames;
+        g_pageSprite[from]->pushSprite(off, 0);
+        g_pageSprite[to]->pushSprite(off - dir * SCREEN_W, 0);
     }
+}
 
-    String payload = http.getString();
-    http.end();
+// Cache mode: bring every sprite up to date, then put the current page on
+// the panel with as little SPI traffic as its changes allow.
+void renderCachedPages()
+{
+    const SensorSnapshot &snap = uiSnapshot();
 
-    Serial.printf("[HTTP] Status: %d, len=%d\n", httpCode, payload.length());
-    // Serial.println(payload); // uncomment for raw JSON
+    renderLivePage(snap);   // widgets track their own damage
 
-    if (httpCode != 200) {
-        Serial.println("[HTTP] Non-200 status");
-        return false;
-    }
+    bool shownStale = false;
 
-    StaticJsonDocument<2048> doc;
-    DeserializationError err = deserializeJson(doc, payload);
-    if (err) {
-        Serial.printf("JSON parse error: %s\n", err.c_str());
-        return false;
+    uint32_t overview = overviewKey(snap.sensors, g_overviewScroll);
+    if (!g_pageRendered[PAGE_OVERVIEW] || g_pageKey[PAGE_OVERVIEW] != overview) {
+        renderOverviewCanvas(*g_pageCanvas[PAGE_OVERVIEW], snap.sensors, g_overviewScroll);
+        g_pageKey[PAGE_OVERVIEW] = overview;
+        g_pageRendered[PAGE_OVERVIEW] = true;
+        if (g_shownPage == PAGE_OVERVIEW) shownStale = true;
     }
 
-    if (!doc.is<JsonArray>()) {
-        Serial.println("Root is not array");
-        return false;
-    }
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        int page = PAGE_HISTORY_FIRST + m;
+        uint32_t key = historyKey(m, snap.history);
+        if (g_pageRendered[page] && g_pageKey[page] == key) continue;
 
-    JsonArray rootArr = doc.as<JsonArray>();
-    if (rootArr.size() == 0) {
-        Serial.println("Empty readings array");
-        return false;
+        unsigned long t0 = micros();
+        renderHistoryCanvas(*g_pageCanvas[page], m, snap.history);
+        Serial.printf("[UI] history page %d rendered in %lu us\n", page, micros() - t0);
+        g_pageKey[page] = key;
+        g_pageRendered[page] = true;
+        if (page == g_shownPage) shownStale = true;
     }
 
-    JsonObject sensor  = rootArr[0];
-    JsonArray  readings = sensor["readings"].as<JsonArray>();
-    if (readings.isNull()) {
-        Serial.println("No 'readings' array");
-        return false;
+    // Nobody looks at it otherwise, and its key moves with every sample
+    if (g_currentPage == PAGE_DIAG) {
+        uint32_t key = diagKey(snap);
+        if (!g_pageRendered[PAGE_DIAG] || g_pageKey[PAGE_DIAG] != key) {
+            renderDiagCanvas(*g_pageCanvas[PAGE_DIAG], snap);
+            g_pageKey[PAGE_DIAG] = key;
+            g_pageRendered[PAGE_DIAG] = true;
+            if (g_shownPage == PAGE_DIAG) shownStale = true;
+        }
     }
 
-    // reset
-    g_tempC       = NAN;
-    g_humidityPct = NAN;
-    g_co2Ppm      = NAN;
-    g_noiseDb     = NAN;
-    g_pm25        = NAN;
-    g_tvoc        = NAN;
-    g_iaqScore    = NAN;
-
-    for (JsonObject r : readings) {
-        const char *metric = r["metric"] | "";
-
-        if (strcmp(metric, "temperature") == 0) {
-            JsonObject temp = r["temperature"];
-            if (!temp.isNull() && temp["celsius"].is<double>()) {
-                g_tempC = temp["celsius"].as<double>();
-            }
-
-        } else if (strcmp(metric, "humidity") == 0) {
-            JsonObject hum = r["humidity"];
-            if (!hum.isNull() && hum["relativePercentage"].is<double>()) {
-                g_humidityPct = hum["relativePercentage"].as<double>();
-            }
-
-        } else if (strcmp(metric, "co2") == 0) {
-            JsonObject co2 = r["co2"];
-            if (!co2.isNull() && co2["concentration"].is<double>()) {
-                g_co2Ppm = co2["concentration"].as<double>();
-            }
-
-        } else if (strcmp(metric, "noise") == 0) {
-            JsonObject amb = r["noise"]["ambient"];
-            if (!amb.isNull() && amb["level"].is<double>()) {
-                g_noiseDb = amb["level"].as<double>();
-            }
-
-        } else if (strcmp(metric, "pm25") == 0) {
-            JsonObject pm = r["pm25"];
-            if (!pm.isNull() && pm["concentration"].is<double>()) {
-                g_pm25 = pm["concentration"].as<double>();
-            }
-
-        } else if (strcmp(metric, "tvoc") == 0) {
-            JsonObject tv = r["tvoc"];
-            if (!tv.isNull() && tv["concentration"].is<double>()) {
-                g_tvoc = tv["concentration"].as<double>();
-            }
-
-        } else if (strcmp(metric, "indoorAirQuality") == 0) {
-            JsonObject iaq = r["indoorAirQuality"];
-            if (!iaq.isNull() && iaq["score"].is<double>()) {
-                g_iaqScore = iaq["score"].as<double>();
-            }
+    if (g_shownPage != g_currentPage) {
+        if (SWIPE_SLIDE_FRAMES > 0 && g_shownPage >= 0) {
+            slideToPage(g_shownPage, g_currentPage);
+        } else {
+            g_pageSprite[g_currentPage]->pushSprite(0, 0);
         }
+        g_shownPage = g_currentPage;
+    } else if (g_currentPage == PAGE_LIVE) {
+        for (int i = 0; i < g_damageCount; ++i) {
+            pushSpriteRect(*g_pageSprite[PAGE_LIVE], g_damage[i]);
+        }
+    } else if (shownStale) {
+        g_pageSprite[g_currentPage]->pushSprite(0, 0);
     }
-
-    Serial.printf("MT15 latest: T=%.2fC H=%.1f%% CO2=%.0fppm\n",
-                  g_tempC, g_humidityPct, g_co2Ppm);
-
-    return true;
+    g_damageCount = 0;
 }
 
-// ==== MERAKI FETCH + PARSE (30D TEMP HISTORY) ====
-
-bool fetchMT15TempHistory30d()
+// Brings the panel in line with the current page and snapshot. Safe to
+// call as often as we like: anything unchanged costs nothing.
+void renderCurrentPage()
 {
-    HTTPClient http;
-    secureClient.setInsecure();  // demo: no CA pinning
-
-    if (!http.begin(secureClient, MERAKI_URL_TEMP_30D)) {
-        Serial.println("[HTTP-30d] begin() failed");
-        return false;
+    unsigned long t0 = micros();
+    if (g_pageCacheOk) {
+        renderCachedPages();
+    } else {
+        renderPageDirect(uiSnapshot());
     }
+    perfRecord(PERF_RENDER, micros() - t0);
 
-    http.addHeader("X-Cisco-Meraki-API-Key", MERAKI_API_KEY);
-    http.addHeader("Accept", "application/json");
-
-    int httpCode = http.GET();
-    if (httpCode <= 0) {
-        Serial.printf("[HTTP-30d] GET failed: %s\n",
-                      http.errorToString(httpCode).c_str());
-        http.end();
-        return false;
+    if (g_inputUs != 0) {
+        uint32_t us = (uint32_t)micros() - g_inputUs;
+        perfRecord(PERF_INPUT, us);
+        Serial.printf("[UI] input to page %d visible in %lu us (%s)\n",
+                      g_currentPage, (unsigned long)us, g_pageCacheOk ? "cached" : "direct");
+        g_inputUs = 0;
     }
+}
 
-    String payload = http.getString();
-    http.end();
+TaskHandle_t g_loopTask = NULL;
 
-    Serial.printf("[HTTP-30d] Status: %d, len=%d\n", httpCode, payload.length());
-    // Serial.println(payload); // debug if needed
+// Fetch side: hands the working state to the UI and wakes loop() for it.
+void publishToUi()
+{
+    publishSnapshot();
+    if (g_loopTask) xTaskNotify(g_loopTask, FRAME_EV_DATA, eSetBits);
+}
 
-    if (httpCode != 200) {
-        Serial.println("[HTTP-30d] Non-200 status");
-        return false;
-    }
+// ==== WIFI ====
 
-    StaticJsonDocument<8192> doc;
-    DeserializationError err = deserializeJson(doc, payload);
-    if (err) {
-        Serial.printf("[HTTP-30d] JSON parse error: %s\n", err.c_str());
-        return false;
-    }
+// Fetch task only: blocks for up to ~20 s, which is fine off the UI core.
+void connectWiFi()
+{
+    g_wifiState = WIFI_CONNECTING;
+    publishToUi();
 
-    if (!doc.is<JsonArray>()) {
-        Serial.println("[HTTP-30d] Root is not array");
-        return false;
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+
+    int retries = 0;
+    while (WiFi.status() != WL_CONNECTED && retries < 40) { // ~20 seconds
+        delay(500);
+        retries++;
     }
 
-    JsonArray arr = doc.as<JsonArray>();
-    int n = arr.size();
-    if (n <= 0) {
-        Serial.println("[HTTP-30d] Empty array");
-        return false;
+    if (WiFi.status() == WL_CONNECTED) {
+        g_wifiState = WIFI_OK;
+        Serial.print("WiFi connected, IP: ");
+        Serial.println(WiFi.localIP());
+    } else {
+        g_wifiState = WIFI_FAIL;
+        Serial.println("WiFi connect failed");
     }
+    publishToUi();
+}
 
-    if (n > MAX_TEMP_POINTS) n = MAX_TEMP_POINTS;
+// ==== FETCH TASK ====
 
-    // API returns newest first; we want oldest at index 0
-    g_tempHistoryCount = 0;
-    for (int i = 0; i < n; ++i) {
-        JsonObject item = arr[i];
+TaskHandle_t g_fetchTask = NULL;
 
-        // temperature.celsius.average
-        double tempAvg = NAN;
-        JsonObject tempObj = item["temperature"]["celsius"];
-        if (!tempObj.isNull() && tempObj["average"].is<double>()) {
-            tempAvg = tempObj["average"].as<double>();
+// Hub listener: no API calls, no TLS; installs whatever the hub sends
+// and passes it on like a fetch would.
+void listenForHub()
+{
+    bool joined = false;
+    for (;;) {
+        if (WiFi.status() != WL_CONNECTED) {
+            connectWiFi();
+            joined = false;
+            continue;
         }
-
-        // date label from startTs "YYYY-MM-DDTHH:MM:SSZ"
-        const char *startTs = item["startTs"] | "";
-        char mmdd[6] = "??/??";
-        if (startTs && strlen(startTs) >= 10) {
-            mmdd[0] = startTs[5];
-            mmdd[1] = startTs[6];
-            mmdd[2] = '/';
-            mmdd[3] = startTs[8];
-            mmdd[4] = startTs[9];
-            mmdd[5] = '\0';
+        if (!joined) {
+            joined = g_multicast->begin(HUB_GROUP, HUB_PORT, true);
+            if (!joined) {
+                Serial.println("[hub] cannot join the group");
+                vTaskDelay(pdMS_TO_TICKS(FETCH_POLL_MS));
+                continue;
+            }
         }
 
-        int targetIndex = n - 1 - i; // reverse order (oldest at 0)
-
-        // store temp
-        if (!isnan(tempAvg)) {
-            g_tempHistory[targetIndex] = (float)tempAvg;
-        } else {
-            g_tempHistory[targetIndex] = NAN;
+        // Wakes at least every FETCH_POLL_MS to notice a dropped WiFi. A
+        // socket error comes back at once: wait before rejoining, or the
+        // task spins on the dead socket.
+        HubReceive rx = hubReceive(FETCH_POLL_MS);
+        if (rx == HUB_RX_ERROR) {
+            Serial.println("[hub] receive failed, rejoining");
+            joined = false;
+            vTaskDelay(pdMS_TO_TICKS(FETCH_POLL_MS));
+            continue;
         }
-
-        // store label even if value is NAN
-        strncpy(g_tempDateLabel[targetIndex],
-                mmdd,
-                sizeof(g_tempDateLabel[targetIndex]));
-        g_tempDateLabel[targetIndex][5] = '\0';
-    }
-
-    g_tempHistoryCount = n;
-
-    Serial.printf("[HTTP-30d] Parsed %d daily temp points\n", g_tempHistoryCount);
-    for (int i = 0; i < g_tempHistoryCount; ++i) {
-        Serial.printf("  day[%02d] = %.2f C (%s)\n",
-                      i, g_tempHistory[i], g_tempDateLabel[i]);
+        if (rx != HUB_RX_INSTALLED) continue;
+        analyticsUpdate();
+        archiveUpdate();
+        memSample(false);
+        publishToUi();
+        localApiPublish();
+        saveStateCache();
     }
-
-    return true;
 }
 
-// ==== MERAKI FETCH + PARSE (30D HUMIDITY HISTORY) ====
-
-bool fetchMT15HumHistory30d()
+// Runs whichever refresh is due (see scheduler.h), publishing after each,
+// and in between waits on MQTT, publishing whatever it pushes. In hub mode
+// every refresh is also multicast (HUB_SEND), or replaced by the hub's
+// (HUB_LISTEN).
+void fetchTask(void *)
 {
-    HTTPClient http;
-    secureClient.setInsecure();  // demo: no CA pinning
+    g_multicast = &g_lwipMulticast;
+    if (HUB_ROLE == HUB_LISTEN) listenForHub();   // never returns
 
-    if (!http.begin(secureClient, MERAKI_URL_HUM_30D)) {
-        Serial.println("[HTTP-30d-HUM] begin() failed");
-        return false;
-    }
+    schedulerInit(SCHEDULER_CONFIG);
+    mqttLiveInit(g_mqttTransport);
+    bool joined = false;
 
-    http.addHeader("X-Cisco-Meraki-API-Key", MERAKI_API_KEY);
-    http.addHeader("Accept", "application/json");
+    for (;;) {
+        if (WiFi.status() != WL_CONNECTED) {
+            connectWiFi();
+            joined = false;
+        }
+        if (HUB_ROLE == HUB_SEND && !joined && WiFi.status() == WL_CONNECTED) {
+            joined = g_multicast->begin(HUB_GROUP, HUB_PORT, false);
+        }
 
-    int httpCode = http.GET();
-    if (httpCode <= 0) {
-        Serial.printf("[HTTP-30d-HUM] GET failed: %s\n",
-                      http.errorToString(httpCode).c_str());
-        http.end();
-        return false;
+        schedulerSetTtl(JOB_LATEST,
+                        mqttLiveActive() ? MQTT_OVERVIEW_REFRESH_MS : REFRESH_INTERVAL_MS);
+        int job = WiFi.status() == WL_CONNECTED ? schedulerNextJob() : -1;
+        if (job >= 0) {
+            bool fullHistory = false;   // set when the ring was rebuilt
+            bool ok;
+            if (job == JOB_LATEST) {
+                ok = fetchMT15Once();
+                if (ok) g_stateFromCache = false;
+            } else {
+                ok = fetchMT15History(&fullHistory);
+            }
+            schedulerJobDone(job, ok);
+            memSample(true);
+            publishToUi();
+            if (HUB_ROLE == HUB_SEND && ok && joined) hubBroadcast(fullHistory);
+            localApiPublish();
+            saveStateCache();
+            continue;   // the other job may be due too
+        }
+
+        unsigned long idle = schedulerIdleMs();
+        unsigned long wait = idle < FETCH_POLL_MS ? idle : FETCH_POLL_MS;
+        if (WiFi.status() != WL_CONNECTED) {
+            vTaskDelay(pdMS_TO_TICKS(wait));
+        } else if (mqttLivePoll(wait)) {
+            // Not saved: the next refresh does, and flash wear matters
+            publishToUi();
+            if (HUB_ROLE == HUB_SEND && joined) hubBroadcast();
+            localApiPublish();
+        }
     }
+}
 
-    String payload = http.getString();
-    http.end();
+// ==== LOCAL API ====
 
-    Serial.printf("[HTTP-30d-HUM] Status: %d, len=%d\n", httpCode, payload.length());
-    // Serial.println(payload); // debug if needed
+// One connection at a time, one request per connection: LAN readers poll
+// every few seconds at most, and the bodies are ready-made (local_api.h),
+// so a request costs a recv and two sends. accept() blocks, so an idle
+// server never wakes.
 
-    if (httpCode != 200) {
-        Serial.println("[HTTP-30d-HUM] Non-200 status");
-        return false;
-    }
+// Listening socket on LOCAL_API_PORT, or -1
+int openApiListener()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) return -1;
 
-    StaticJsonDocument<8192> doc;
-    DeserializationError err = deserializeJson(doc, payload);
-    if (err) {
-        Serial.printf("[HTTP-30d-HUM] JSON parse error: %s\n", err.c_str());
-        return false;
-    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
 
-    if (!doc.is<JsonArray>()) {
-        Serial.println("[HTTP-30d-HUM] Root is not array");
-        return false;
+    struct sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(LOCAL_API_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 2) < 0) {
+        close(fd);
+        return -1;
     }
+    return fd;
+}
 
-    JsonArray arr = doc.as<JsonArray>();
-    int n = arr.size();
-    if (n <= 0) {
-        Serial.println("[HTTP-30d-HUM] Empty array");
-        return false;
+// Sends all of `len`; false if the client went away
+bool sendAll(int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        int n = send(fd, buf, len, 0);
+        if (n <= 0) return false;
+        buf += n;
+        len -= n;
     }
+    return true;
+}
 
-    if (n > MAX_TEMP_POINTS) n = MAX_TEMP_POINTS;
-
-    // We assume same intervals as temp; oldest at index 0
-    for (int i = 0; i < n; ++i) {
-        JsonObject item = arr[i];
+void serveApiClient(int fd)
+{
+    static char head[LOCAL_API_HEAD_BYTES];
+    static char out[256];
+
+    unsigned long t0 = micros();
+    struct timeval tv = { API_READ_TIMEOUT_MS / 1000, (API_READ_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    // Up to the blank line; a head that fills the buffer is answered 431
+    size_t len = 0;
+    while (len < sizeof(head) - 1) {
+        int n = recv(fd, head + len, sizeof(head) - 1 - len, 0);
+        if (n <= 0) return;
+        len += n;
+        head[len] = '\0';
+        if (strstr(head, "\r\n\r\n")) break;
+    }
+    head[len] = '\0';
+
+    LocalApiResponse res;
+    localApiHandle(head, res);
+    size_t headLen = localApiFormatHead(res, out, sizeof(out));
+    if (!sendAll(fd, out, headLen)) return;
+    if (res.sendBody && !sendAll(fd, res.body, res.len)) return;
+
+    Serial.printf("[api] %.*s %d, %u bytes in %lu us\n", (int)strcspn(head, "\r\n"), head,
+                  res.status, (unsigned)(res.sendBody ? res.len : 0), micros() - t0);
+}
 
-        double humAvg = NAN;
-        JsonObject humRoot = item["humidity"];
-        if (!humRoot.isNull()) {
-            JsonObject rel = humRoot["relativePercentage"];
-            if (!rel.isNull()) {
-                if (rel["average"].is<double>()) {
-                    humAvg = rel["average"].as<double>();
-                }
-            } else if (humRoot["relativePercentage"].is<double>()) {
-                humAvg = humRoot["relativePercentage"].as<double>();
+void apiTask(void *)
+{
+    int listener = -1;
+    for (;;) {
+        if (listener < 0) {
+            if (WiFi.status() != WL_CONNECTED || (listener = openApiListener()) < 0) {
+                vTaskDelay(pdMS_TO_TICKS(FETCH_POLL_MS));
+                continue;
             }
+            Serial.printf("[api] serving http://%s:%d/latest and /history\n",
+                          WiFi.localIP().toString().c_str(), LOCAL_API_PORT);
         }
 
-        int targetIndex = n - 1 - i; // reverse order (oldest at 0)
-        if (!isnan(humAvg)) {
-            g_humHistory[targetIndex] = (float)humAvg;
-        } else {
-            g_humHistory[targetIndex] = NAN;
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {   // the interface went away; listen again once it's back
+            close(listener);
+            listener = -1;
+            continue;
         }
+        serveApiClient(fd);
+        shutdown(fd, SHUT_RDWR);
+        close(fd);
     }
+}
 
-    Serial.println("[HTTP-30d-HUM] Filled humidity history");
-    for (int i = 0; i < g_tempHistoryCount && i < n; ++i) {
-        Serial.printf("  hum[%02d] = %.2f %% (%s)\n",
-                      i, g_humHistory[i], g_tempDateLabel[i]);
-    }
+// ==== TOUCH ====
 
-    return true;
-}
+// The FT6336's INT line wakes the touch task, which then samples every
+// TOUCH_SAMPLE_MS until the finger lifts, on a priority above loop()'s, so
+// neither drawing nor the fetch task can make it miss a flick. It is the
+// only reader of the touch controller (loop() doesn't call M5.update()).
+const int         TOUCH_INT_PIN    = 39;
+const UBaseType_t TOUCH_TASK_PRIO  = 3;
+const uint32_t    TOUCH_TASK_STACK = 3072;
+const BaseType_t  TOUCH_TASK_CORE  = 1;
 
-// ==== WIFI STATUS LINE ====
+// Overview flings keep scrolling as if the finger went on this long
+const unsigned long FLING_COAST_MS = 250;
 
-void connectWiFi()
+TaskHandle_t      g_touchTask = NULL;
+TouchRing         g_touchRing;   // touch task -> loop()
+GestureRecognizer g_gestures;    // loop() only
+int               g_scrollPx        = 0;           // overview drag not yet scrolled
+int               g_pageBeforeDiag  = PAGE_LIVE;   // where a long press goes back to
+
+void IRAM_ATTR touchIsr()
 {
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(g_touchTask, &woken);
+    portYIELD_FROM_ISR(woken);
+}
 
-    int retries = 0;
-    while (WiFi.status() != WL_CONNECTED && retries < 40) { // ~20 seconds
-        delay(500);
-        retries++;
-    }
+void touchTask(void *)
+{
+    bool        down = false;
+    TouchSample last = {};
+    TickType_t  wake = 0;
+
+    for (;;) {
+        if (!down) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            wake = xTaskGetTickCount();
+        } else {
+            vTaskDelayUntil(&wake, pdMS_TO_TICKS(TOUCH_SAMPLE_MS));
+        }
 
-    // Update WiFi status under the title
-    M5.Lcd.fillRect(WIFI_STATUS_X, WIFI_STATUS_Y,
-                    120, METRIC_LINE_H * 2, TFT_BLACK);
-    M5.Lcd.setTextDatum(TL_DATUM);
-    M5.Lcd.setTextSize(2);
+        TouchSample s = last;   // a release repeats the last point
+        s.us   = (uint32_t)micros();
+        s.down = M5.Touch.ispressed();
+        if (s.down) {
+            Point p = M5.Touch.getPressPoint();
+            s.x = p.x;
+            s.y = p.y;
+        }
+        if (!s.down && !down) continue;   // edge without a touch behind it
 
-    if (WiFi.status() == WL_CONNECTED) {
-        M5.Lcd.setTextColor(TFT_GREEN, TFT_BLACK);
-        M5.Lcd.drawString("WiFi OK", WIFI_STATUS_X, WIFI_STATUS_Y);
-        Serial.print("WiFi connected, IP: ");
-        Serial.println(WiFi.localIP());
-    } else {
-        M5.Lcd.setTextColor(TFT_RED, TFT_BLACK);
-        M5.Lcd.drawString("WiFi FAIL", WIFI_STATUS_X, WIFI_STATUS_Y);
-        Serial.println("WiFi connect failed");
+        down = s.down;
+        last = s;
+        g_touchRing.push(s);
+        xTaskNotify(g_loopTask, FRAME_EV_TOUCH, eSetBits);
     }
 }
 
-// ==== SWIPE HANDLING ====
-
-void handleSwipe()
+// Acts on one gesture. Returns true if the panel needs a render.
+//   fling left/right   next / previous page
+//   long press         diagnostics page, and back
+//   scroll, fling      overview rows (a row per OVERVIEW_ROW_H of travel)
+bool handleGesture(const Gesture &g)
 {
-    static bool   touchActive = false;
-    static int16_t startX = 0, startY = 0;
-    static int16_t lastX  = 0, lastY  = 0;
-
-    if (M5.Touch.ispressed()) {
-        Point p = M5.Touch.getPressPoint();
-
-        if (!touchActive) {
-            touchActive = true;
-            startX = lastX = p.x;
-            startY = lastY = p.y;
+    const SensorStore &sensors = uiSnapshot().sensors;
+    int rows = 0;
+
+    switch (g.type) {
+    case GESTURE_FLING_LEFT:
+        if (g_currentPage >= PAGE_MAX - 1) return false;
+        g_currentPage++;
+        return true;
+    case GESTURE_FLING_RIGHT:
+        if (g_currentPage <= 0) return false;
+        g_currentPage--;
+        return true;
+    case GESTURE_LONG_PRESS:
+        if (g_currentPage == PAGE_DIAG) {
+            g_currentPage = g_pageBeforeDiag;
         } else {
-            lastX = p.x;
-            lastY = p.y;
-        }
-    } else if (touchActive) {
-        int dx = lastX - startX;
-        int dy = lastY - startY;
-
-        const int SWIPE_THRESHOLD = 50;
-
-        if (abs(dx) > SWIPE_THRESHOLD && abs(dx) > abs(dy)) {
-            if (dx < 0 && g_currentPage < PAGE_MAX - 1) {
-                g_currentPage++;
-                drawCurrentPage();
-            } else if (dx > 0 && g_currentPage > 0) {
-                g_currentPage--;
-                drawCurrentPage();
-            }
+            g_pageBeforeDiag = g_currentPage;
+            g_currentPage = PAGE_DIAG;
         }
-
-        touchActive = false;
+        return true;
+    case GESTURE_SCROLL:
+        if (g_currentPage != PAGE_OVERVIEW) return false;
+        g_scrollPx -= g.dy;   // finger up = further down the list
+        rows = g_scrollPx / OVERVIEW_ROW_H;
+        g_scrollPx -= rows * OVERVIEW_ROW_H;
+        return rows != 0 && scrollOverview(rows, sensors);
+    case GESTURE_FLING_UP:
+    case GESTURE_FLING_DOWN:
+        g_scrollPx = 0;
+        if (g_currentPage != PAGE_OVERVIEW) return false;
+        rows = (int)(g.velocity * FLING_COAST_MS / 1000 / OVERVIEW_ROW_H);
+        return scrollOverview(g.type == GESTURE_FLING_UP ? rows : -rows, sensors);
+    case GESTURE_TAP:
+        Serial.printf("[UI] tap at %d,%d\n", g.x, g.y);
+        return false;
+    default:
+        return false;
     }
 }
 
+// Runs everything the touch task has queued through the recognizer; the
+// next frame shows whatever it changed.
+void handleTouch()
+{
+    TouchSample s;
+    Gesture     g;
+    bool        changed = false;
+    while (g_touchRing.pop(s)) {
+        if (!g_gestures.feed(s, g) || !handleGesture(g)) continue;
+        if (!changed) g_inputUs = g.us;   // time the oldest one
+        changed = true;
+    }
+    if (changed) frameInvalidate();
+}
+
 // ==== ARDUINO SETUP / LOOP ====
 
 void setup()
@@ -819,46 +804,73 @@ void setup()
     Serial.begin(115200);
     delay(200);
 
-    drawStaticLayout();
-    connectWiFi();
-
-    // Initial data fetch so all pages have something to draw
-    if (WiFi.status() == WL_CONNECTED) {
-        fetchMT15Once();
-        fetchMT15TempHistory30d();
-        fetchMT15HumHistory30d();
+    g_merakiConfig = { MERAKI_HOST, MERAKI_PORT, MERAKI_API_KEY,
+                       MERAKI_ORG_ID, MT15_SERIAL, OVERVIEW_SERIALS };
+    g_transport    = &g_secureTransport;
+    g_mqttConfig.host      = MQTT_BROKER_HOST;
+    g_mqttConfig.port      = MQTT_BROKER_PORT;
+    g_mqttConfig.user      = MQTT_USER;
+    g_mqttConfig.pass      = MQTT_PASS;
+    g_mqttConfig.sensorMac = MT15_MAC;
+
+    // Seed the UI with the state saved before the last reset, or an empty
+    // (all-NaN) snapshot, before the task exists
+    if (!LittleFS.begin(true)) Serial.println("LittleFS mount failed");
+    loadStateCache();
+    publishSnapshot();
+    archiveInit();
+    if (LOCAL_API_PORT && localApiInit()) localApiPublish();
+    if (HUB_ROLE == HUB_LISTEN) hubListenInit();
+    acquireSnapshot();
+
+    // Start from a blank panel so the widgets' idea of it is accurate
+    M5.Lcd.fillScreen(TFT_BLACK);
+    g_canvas = &g_panel;
+    initWidgets();
+    initPageCache();
+    renderCurrentPage();
+
+    // Both tasks below wake loop() through its task notification
+    g_loopTask = xTaskGetCurrentTaskHandle();
+
+    // Touch is sampled by its own task from here on
+    xTaskCreatePinnedToCore(touchTask, "touch", TOUCH_TASK_STACK, NULL, TOUCH_TASK_PRIO,
+                            &g_touchTask, TOUCH_TASK_CORE);
+    pinMode(TOUCH_INT_PIN, INPUT);
+    attachInterrupt(digitalPinToInterrupt(TOUCH_INT_PIN), touchIsr, FALLING);
+
+    // First fetch starts immediately; pages fill in as snapshots arrive
+    xTaskCreatePinnedToCore(fetchTask, "fetch", FETCH_TASK_STACK, NULL, 1,
+                            &g_fetchTask, FETCH_TASK_CORE);
+    if (LOCAL_API_PORT) {
+        xTaskCreatePinnedToCore(apiTask, "api", API_TASK_STACK, NULL, 0, NULL, FETCH_TASK_CORE);
     }
-
-    drawCurrentPage();
-    lastFetch = millis();
 }
 
 void loop()
 {
-    M5.update();
-    handleSwipe();
-
-    unsigned long now = millis();
-    if (now - lastFetch >= REFRESH_INTERVAL_MS || lastFetch == 0) {
-        if (WiFi.status() == WL_CONNECTED) {
-            // Always refresh live + both histories
-            fetchMT15Once();
-            fetchMT15TempHistory30d();
-            fetchMT15HumHistory30d();
-
-            // Redraw current page
-            if (g_currentPage == PAGE_LIVE) {
-                updateSensorText();
-            } else if (g_currentPage == PAGE_TEMP_HISTORY) {
-                drawTempHistoryPage();
-            } else if (g_currentPage == PAGE_HUM_HISTORY) {
-                drawHumHistoryPage();
-            }
-        } else {
-            connectWiFi();
-        }
-        lastFetch = now;
-    }
-
-    delay(100);
+    handleTouch();
+
+    // Never blocks: network I/O lives in fetchTask on the other core
+    if (acquireSnapshot()) frameInvalidate();
+
+    if (frameDue()) {
+        renderCurrentPage();
+        frameDone();
+        // Its loop and render timings move on their own
+        if (g_currentPage == PAGE_DIAG) frameRenderBy(millis() + DIAG_REFRESH_MS);
+    }
+
+    // Sleep until an event arrives or the next frame / deadline is due; a
+    // timed wake-up's lateness is the loop's jitter
+    unsigned long sleepMs = frameSleepMs();
+    TickType_t ticks = sleepMs == FRAME_SLEEP_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(sleepMs);
+    uint32_t events = 0;
+    unsigned long waitStart = micros();
+    if (xTaskNotifyWait(0, UINT32_MAX, &events, ticks) != pdTRUE) {
+        events = 0;
+        long late = (long)(micros() - waitStart) - (long)(sleepMs * 1000);
+        perfRecord(PERF_LOOP_JITTER, abs(late));
+    }
+    frameWoke(events);
 }